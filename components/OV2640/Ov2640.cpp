@@ -7,6 +7,7 @@
 #include "esp_camera.h"
 #include "utility/system/NvsWrap.hpp"
 #include "sub/Cam.hpp"
+#include "cam/FrameRing.hpp"
 
 using namespace std;
 
@@ -16,6 +17,8 @@ static constexpr const char *kTag = "[OV2640]";
 static constexpr const char *kNvsKey = "Ov2640";
 static constexpr const char *kNvsFrameSize = "FrameSize";
 
+Ov2640::FramePool Ov2640::framePool{};
+
 /// \brief Memory constraints necessitate the use of frame size limitations
 ///
 /// \details Format: (pixformat, "lt" limitation)
@@ -186,28 +189,32 @@ void Ov2640::reinit()
 }
 
 #if CONFIG_OV2640_CUSTOM_BUFFER_MANAGEMENT
-std::shared_ptr<Cam::Frame> Ov2640::getFrame()
+Cam::FramePtr Ov2640::getFrame()
 {
-	static std::array<std::weak_ptr<Cam::Frame>, CONFIG_OV2640_CUSTOM_BUFFER_MANAGEMENT_N_BUFFERS> wpBuffers;
 	static size_t usedBuffers = 0;
 
-	// Find a buffer which is not being used at the moment
+	// Find a buffer which is not being used at the moment. Pool slots mirror the driver's buffers
 
-	for (size_t i = 0, nUsed = 0; i < wpBuffers.size(); ++i) {
+	for (size_t i = 0, nUsed = 0; i < FramePool::capacity(); ++i) {
 		if (i > 0) {
 			ESP_LOGI(kTag, "using additional buffers");
 		}
-		if (wpBuffers[i].expired()) {
+		if (!framePool.isUsed(i)) {
 
 			auto frameBuffer = esp_camera_nfb_get(i);
 			if (!frameBuffer) {
 				continue;
 			}
 
-			std::shared_ptr<Ov2640::Frame> sp(new Ov2640::Frame(frameBuffer));
-			wpBuffers[i] = sp;
+			auto *frame = framePool.tryEmplaceAt(i, frameBuffer);
+
+			if (frame == nullptr) {  // Has been occupied concurrently
+				esp_camera_fb_return(frameBuffer);
+
+				continue;
+			}
 
-			return sp;
+			return Cam::FramePtr{frame};
 		} else {
 			++nUsed;
 			if (nUsed != usedBuffers) {
@@ -218,19 +225,28 @@ std::shared_ptr<Cam::Frame> Ov2640::getFrame()
 	}
 	ESP_LOGW(kTag, "could not find a free buffer");
 
-	return std::make_shared<Cam::Frame>();
+	return Cam::FramePtr{};
 }
 #else
-std::shared_ptr<Cam::Frame> Ov2640::getFrame()
+Cam::FramePtr Ov2640::getFrame()
 {
 	auto fb = esp_camera_fb_get();
 
 	if (!fb) {
 		ESP_LOGW(kTag, "Got nullptr frame");
-		return std::make_shared<Cam::Frame>();
+		return Cam::FramePtr{};
 	}
 
-	return std::shared_ptr<Cam::Frame>(new Ov2640::Frame(fb));
+	auto *frame = framePool.tryEmplace(fb);
+
+	if (frame == nullptr) {
+		ESP_LOGW(kTag, "could not find a free frame handle");
+		esp_camera_fb_return(fb);
+
+		return Cam::FramePtr{};
+	}
+
+	return Cam::FramePtr{frame};
 }
 
 #endif
@@ -345,14 +361,26 @@ void Ov2640::setFieldValue(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCal
 ///
 void Ov2640::hookOnFrame(camera_fb_t *aFrame)
 {
-	auto frame = Sub::Key::NewFrameEvent{new Ov2640::Frame{aFrame}};
-	Sub::Key::NewFrame::notify(frame);
+	auto *frame = framePool.tryEmplace(aFrame);
+
+	if (frame == nullptr) {
+		ESP_LOGW(kTag, "could not find a free frame handle, skipping");
+		esp_camera_fb_return(aFrame);
+
+		return;
+	}
+
+	Cam::FramePtr framePtr{frame};
+	Cam::FrameRing::getInstance().pushCopy(framePtr);  // Right away, the re-armed DMA is only waiting for the next VSYNC
+	Sub::Key::NewFrame::notify(framePtr);
 }
 
 // ------------ Ov2640::Frame ------------ //
 
 Ov2640::Frame::Frame(camera_fb_t *aFb) : Cam::Frame(aFb->buf, aFb->len), fb(aFb)
 {
+	// The driver stamps the buffer w/ `esp_timer_get_time()` upon the first DMA transfer
+	setCaptured(static_cast<std::int64_t>(aFb->timestamp.tv_sec) * 1000000 + aFb->timestamp.tv_usec);
 }
 
 Ov2640::Frame::Frame(Frame &&frame) : Cam::Frame(std::move(frame)), fb(frame.fb)
@@ -384,3 +412,9 @@ int Ov2640::Frame::height()
 {
 	return fb->height;
 }
+
+/// \brief Returns the driver's buffer (see the destructor), and makes the slot available for the next frame
+void Ov2640::Frame::onRefCountZero()
+{
+	framePool.destroy(this);
+}
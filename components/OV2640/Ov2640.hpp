@@ -1,6 +1,7 @@
 #ifndef COMPONENTS_OV2640_OV2640_H
 #define COMPONENTS_OV2640_OV2640_H
 
+#include <sdkconfig.h>
 #include <utility>
 #include "img_converters.h"
 #include <cstdint>
@@ -8,6 +9,7 @@
 #include "asio.hpp"
 #include "cam/Camera.hpp"
 #include "module/ModuleBase.hpp"
+#include "utility/cont/Pool.hpp"
 
 // Wrapper around C API for OV2640
 
@@ -17,7 +19,7 @@ class Ov2640 : public Cam::CameraBase, public Mod::ModuleBase {
 public:
 	Ov2640();
 	void init() override;
-	std::shared_ptr<Cam::Frame> getFrame() override;
+	Cam::FramePtr getFrame() override;
 private:
 	class Frame : public Cam::Frame {
 		camera_fb_t *fb;
@@ -30,7 +32,27 @@ private:
 		~Frame();
 		int width() override;
 		int height() override;
+	protected:
+		void onRefCountZero() override;
 	};
+
+	/// \brief Each frame handle wraps one of the driver's buffers, so there
+	/// cannot be more handles alive than there are buffers.
+	///
+	/// \details W/ hooks, the driver re-arms its only buffer right before the
+	/// frame is delivered, so a handle is only valid within the hook. The
+	/// frame ring gets a copy (see `Cam::FrameRing::pushCopy`), and the
+	/// subscribers must be done w/ the frame by the time they return. The spare
+	/// handle covers a subscriber releasing its handle a bit late.
+#if CONFIG_DRIVER_OV2640_USE_HOOKS
+	static constexpr std::size_t kFramePoolSize = 2;
+#elif CONFIG_OV2640_CUSTOM_BUFFER_MANAGEMENT
+	static constexpr std::size_t kFramePoolSize = CONFIG_OV2640_CUSTOM_BUFFER_MANAGEMENT_N_BUFFERS;
+#else
+	static constexpr std::size_t kFramePoolSize = 1;
+#endif
+	using FramePool = Ut::Cont::Pool<Frame, kFramePoolSize>;
+	static FramePool framePool;
 protected:
 	void getFieldValue(Mod::Fld::Req, Mod::Fld::OnResponseCallback) override;
 	void setFieldValue(Mod::Fld::WriteReq, Mod::Fld::OnWriteResponseCallback) override;
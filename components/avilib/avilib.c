@@ -41,15 +41,20 @@ long AVI_errno = 0;
  *                                                                 *
  *******************************************************************/
 
-/* AVI_MAX_LEN: The maximum length of an AVI file, we stay a bit below
-	the 2GB limit (Remember: 2*10^9 is smaller than 2 GB) */
-
-#define AVI_MAX_LEN 2000000000
-
 /* HEADERBYTES: The number of bytes to reserve for the header */
 
 #define HEADERBYTES 2048
 
+/* AVI_INDEX_RAM_ENTRIES: The number of index entries kept in RAM while
+	writing. Once the block is full, it is spilled to a sidecar file, so the
+	memory used by the index does not depend on the length of the recording.
+	The sidecar replaces the file's extension, so it is a valid 8.3 name, see
+	AVI_INDEX_SIDECAR_SUFFIX */
+
+#ifndef AVI_INDEX_RAM_ENTRIES
+#define AVI_INDEX_RAM_ENTRIES 512
+#endif
+
 #define PAD_EVEN(x) (((x) + 1) & ~1)
 
 /* Copy n into dst as a 4 byte, little endian number.
@@ -68,11 +73,13 @@ static void long2str(char *dst, int n)
 
 static unsigned long str2ulong(char *str)
 {
-	return (str[0] | (str[1] << 8) | (str[2] << 16) | (str[3] << 24));
+	unsigned char *s = (unsigned char *)str;
+	return (s[0] | (s[1] << 8) | (s[2] << 16) | ((unsigned long)s[3] << 24));
 }
 static unsigned long str2ushort(char *str)
 {
-	return (str[0] | (str[1] << 8));
+	unsigned char *s = (unsigned char *)str;
+	return (s[0] | (s[1] << 8));
 }
 
 /* Calculate audio sample size from number of bits and number of channels.
@@ -87,6 +94,83 @@ static int avi_sampsize(avi_t *AVI)
 	return s;
 }
 
+/* Issue a write to the file, keeping track of its alignment */
+
+static int avi_write_file(avi_t *AVI, const char *data, long length)
+{
+	if (length == 0)
+		return 0;
+
+	AVI->n_writes++;
+	if (AVI->wbuf_size && (AVI->wpos % AVI->wbuf_size || length % AVI->wbuf_size))
+		AVI->n_unaligned_writes++;
+
+	if (fwrite(data, 1, length, AVI->fdes) != (size_t)length)
+		return -1;
+
+	AVI->wpos += length;
+
+	return 0;
+}
+
+/* Append data to the output. If coalescing is enabled, the data is collected
+   in the buffer until a block is complete. Whole blocks are written directly
+   from the source, when the buffer is empty. */
+
+static int avi_write_out(avi_t *AVI, const char *data, long length)
+{
+	long n;
+
+	if (AVI->wbuf == 0 && AVI->wbuf_size)
+		return avi_write_file(AVI, data, length);
+
+	if (AVI->wbuf == 0)
+		return fwrite(data, 1, length, AVI->fdes) == (size_t)length ? 0 : -1;
+
+	if (AVI->wbuf_len)
+	{
+		n = AVI->wbuf_size - AVI->wbuf_len;
+		if (n > length)
+			n = length;
+		memcpy(AVI->wbuf + AVI->wbuf_len, data, n);
+		AVI->wbuf_len += n;
+		data += n;
+		length -= n;
+
+		if (AVI->wbuf_len < AVI->wbuf_size)
+			return 0;
+
+		if (avi_write_file(AVI, AVI->wbuf + AVI->wbuf_skip, AVI->wbuf_size - AVI->wbuf_skip))
+			return -1;
+		AVI->wbuf_len = 0;
+		AVI->wbuf_skip = 0;
+	}
+
+	n = length - length % AVI->wbuf_size;
+	if (avi_write_file(AVI, data, n))
+		return -1;
+
+	memcpy(AVI->wbuf, data + n, length - n);
+	AVI->wbuf_len = length - n;
+
+	return 0;
+}
+
+/* Write whatever is pending in the coalescing buffer */
+
+static int avi_flush(avi_t *AVI)
+{
+	if (AVI->wbuf == 0 || AVI->wbuf_len == 0)
+		return 0;
+
+	if (avi_write_file(AVI, AVI->wbuf + AVI->wbuf_skip, AVI->wbuf_len - AVI->wbuf_skip))
+		return -1;
+	AVI->wbuf_len = 0;
+	AVI->wbuf_skip = 0;
+
+	return 0;
+}
+
 /* Add a chunk (=tag and data) to the AVI file,
    returns -1 on write error, 0 on success */
 
@@ -101,32 +185,126 @@ static int avi_add_chunk(avi_t *AVI, char *tag, char *data, int length)
 	long2str(c + 4, length);
 
 	/* Output tag, length and data, restore previous position
-	  if the write fails */
+	  if the write fails. Data of odd length is padded w/ a zero byte */
 
-	length = PAD_EVEN(length);
-
-	if (fwrite( c, 1,  8, AVI->fdes) != 8 ||
-		fwrite( data, 1,  length, AVI->fdes) != length)
+	if (avi_write_out(AVI, c, 8) ||
+		avi_write_out(AVI, data, length) ||
+		(length & 1 && avi_write_out(AVI, "", 1)))
 	{
-		fseek(AVI->fdes, AVI->pos, SEEK_SET);
+		if (AVI->wbuf == 0)
+			fseek(AVI->fdes, AVI->pos, SEEK_SET);
 		AVI_errno = AVI_ERR_WRITE;
 		return -1;
 	}
 
 	/* Update file position */
 
-	AVI->pos += 8 + length;
+	AVI->pos += 8 + PAD_EVEN(length);
+
+	return 0;
+}
+
+/* Spill the index entries kept in RAM to the sidecar file */
+
+static int avi_spill_index(avi_t *AVI)
+{
+	if (AVI->idx_ram == 0)
+		return 0;
+
+	if (AVI->idx_sidecar == 0)
+	{
+		AVI->idx_sidecar = fopen(AVI->idx_sidecar_name, "wb+");
+		if (AVI->idx_sidecar == 0)
+			return -1;
+	}
+
+	if (fwrite(AVI->idx, 16, AVI->idx_ram, AVI->idx_sidecar) != (size_t)AVI->idx_ram)
+		return -1;
+
+	AVI->idx_ram = 0;
 
 	return 0;
 }
 
+/* Compose the name of the index sidecar, the caller frees it */
+
+static char *avi_sidecar_name(const char *filename)
+{
+	char *name, *extension;
+
+	name = (char *)malloc(strlen(filename) + sizeof(AVI_INDEX_SIDECAR_SUFFIX));
+	if (name == 0)
+		return 0;
+
+	strcpy(name, filename);
+	extension = strrchr(name, '.');
+	if (extension == 0 || strchr(extension, '/') != 0)
+		extension = name + strlen(name);
+	strcpy(extension, AVI_INDEX_SIDECAR_SUFFIX);
+
+	return name;
+}
+
+/* Add an idx1 entry. The position is relative to the "movi" tag. If the
+   index cannot be spilled, the recording goes on w/o the index */
+
 static int avi_add_index_entry(avi_t *AVI, char *tag, long flags, long pos, long len)
 {
+	if (AVI->idx_error)
+		return 0;
+
+	if (AVI->idx_ram == AVI->max_idx && avi_spill_index(AVI))
+	{
+		AVI->idx_error = 1;
+		return 0;
+	}
+
+	memcpy(AVI->idx[AVI->idx_ram], tag, 4);
+	long2str(AVI->idx[AVI->idx_ram] + 4, flags);
+	long2str(AVI->idx[AVI->idx_ram] + 8, pos - HEADERBYTES + 4);
+	long2str(AVI->idx[AVI->idx_ram] + 12, len);
+	AVI->idx_ram++;
 	AVI->n_idx++;
 
 	return 0;
 }
 
+/* Write the idx1 chunk. The spilled part of the index is streamed from the
+   sidecar through the RAM block, so no extra memory is needed */
+
+static int avi_write_index(avi_t *AVI)
+{
+	char c[8];
+	long n;
+
+	if (AVI->idx_error)
+		return -1;
+
+	memcpy(c, "idx1", 4);
+	long2str(c + 4, AVI->n_idx * 16);
+
+	if (avi_write_out(AVI, c, 8))
+		return -1;
+
+	if (AVI->idx_sidecar)
+	{
+		if (avi_spill_index(AVI) || fseek(AVI->idx_sidecar, 0, SEEK_SET) < 0)
+			return -1;
+
+		while ((n = fread(AVI->idx, 16, AVI->max_idx, AVI->idx_sidecar)) > 0)
+			if (avi_write_out(AVI, (char *)AVI->idx, n * 16))
+				return -1;
+	}
+	else if (avi_write_out(AVI, (char *)AVI->idx, AVI->idx_ram * 16))
+	{
+		return -1;
+	}
+
+	AVI->pos += 8 + AVI->n_idx * 16;
+
+	return 0;
+}
+
 /*
    AVI_open_output_file: Open an AVI File and write a bunch
 						 of zero bytes as space for the header.
@@ -135,6 +313,11 @@ static int avi_add_index_entry(avi_t *AVI, char *tag, long flags, long pos, long
 */
 
 avi_t *AVI_open_output_file(char *filename)
+{
+	return AVI_open_output_file_buffered(filename, 0, 0);
+}
+
+avi_t *AVI_open_output_file_buffered(char *filename, char *buf, long size)
 {
 	avi_t *AVI;
 	int i;
@@ -150,6 +333,21 @@ avi_t *AVI_open_output_file(char *filename)
 	}
 	memset((void *)AVI, 0, sizeof(avi_t));
 
+	/* Index entries are collected in a fixed block, and spilled to
+	  "<filename>.idx", see AVI_INDEX_RAM_ENTRIES */
+
+	AVI->max_idx = AVI_INDEX_RAM_ENTRIES;
+	AVI->idx = (char(*)[16])malloc(AVI->max_idx * 16);
+	AVI->idx_sidecar_name = avi_sidecar_name(filename);
+	if (AVI->idx == 0 || AVI->idx_sidecar_name == 0)
+	{
+		free(AVI->idx);
+		free(AVI->idx_sidecar_name);
+		free(AVI);
+		AVI_errno = AVI_ERR_NO_MEM;
+		return 0;
+	}
+
 	/* Since Linux needs a long time when deleting big files,
 	  we do not truncate the file when we open it.
 	  Instead it is truncated when the AVI file is closed */
@@ -158,20 +356,33 @@ avi_t *AVI_open_output_file(char *filename)
 	if (AVI->fdes == 0)
 	{
 		AVI_errno = AVI_ERR_OPEN;
+		free(AVI->idx);
+		free(AVI->idx_sidecar_name);
 		free(AVI);
 		return 0;
 	}
 
+	/* The coalescing buffer replaces stdio buffering, so the writes reach the
+	  file system exactly as they have been issued */
+
+	if (size >= HEADERBYTES)
+	{
+		setvbuf(AVI->fdes, 0, _IONBF, 0);
+		AVI->wbuf = buf;
+		AVI->wbuf_size = size;
+	}
+
 	/* Write out HEADERBYTES bytes, the header will go here
 	  when we are finished with writing */
 
 	for (i = 0; i < HEADERBYTES; i++)
 		AVI_header[i] = 0;
-	i = fwrite( AVI_header, 1,  HEADERBYTES, AVI->fdes);
-	if (i != HEADERBYTES)
+	if (avi_write_out(AVI, AVI_header, HEADERBYTES))
 	{
 		fclose(AVI->fdes);
 		AVI_errno = AVI_ERR_WRITE;
+		free(AVI->idx);
+		free(AVI->idx_sidecar_name);
 		free(AVI);
 		return 0;
 	}
@@ -228,37 +439,19 @@ void AVI_set_audio(avi_t *AVI, int channels, long rate, int bits, int format)
 	nhb += 2
 
 /*
-  Write the header of an AVI file and close it.
+  Write the header of an AVI file at its start. `movi_len` is the length of
+  the movi list, the RIFF size is derived from AVI->pos.
   returns 0 on success, -1 on write error.
 */
 
-static int avi_close_output_file(avi_t *AVI)
+static int avi_write_header(avi_t *AVI, long movi_len, int hasIndex)
 {
 
-	int ret, njunk, sampsize, hasIndex, ms_per_frame, idxerror, flag;
-	int movi_len, hdrl_start, strl_start;
+	int njunk, sampsize, ms_per_frame, flag;
+	int hdrl_start, strl_start;
 	char AVI_header[HEADERBYTES];
 	long nhb;
 
-	/* Calculate length of movi list */
-
-	movi_len = AVI->pos - HEADERBYTES + 4;
-
-	/* Try to ouput the index entries. This may fail e.g. if no space
-	  is left on device. We will report this as an error, but we still
-	  try to write the header correctly (so that the file still may be
-	  readable in the most cases */
-
-	idxerror = 0;
-//	ret = avi_add_chunk(AVI, "idx1", (void *)AVI->idx, AVI->n_idx * 16);
-	ret = 0;
-	hasIndex = (ret == 0);
-	if (ret)
-	{
-		idxerror = 1;
-		AVI_errno = AVI_ERR_WRITE_INDEX;
-	}
-
 	/* Calculate Microseconds per frame */
 
 	if (AVI->fps < 0.001)
@@ -463,6 +656,48 @@ static int avi_close_output_file(avi_t *AVI)
 		return -1;
 	}
 
+	return 0;
+}
+
+/*
+  Write the header of an AVI file and close it.
+  returns 0 on success, -1 on write error.
+*/
+
+static int avi_close_output_file(avi_t *AVI)
+{
+	int ret, hasIndex, idxerror;
+	long movi_len;
+
+	/* Calculate length of movi list */
+
+	movi_len = AVI->pos - HEADERBYTES + 4;
+
+	/* Try to ouput the index entries. This may fail e.g. if no space
+	  is left on device. We will report this as an error, but we still
+	  try to write the header correctly (so that the file still may be
+	  readable in the most cases */
+
+	idxerror = 0;
+	ret = avi_write_index(AVI);
+	hasIndex = (ret == 0);
+	if (ret)
+	{
+		idxerror = 1;
+		AVI_errno = AVI_ERR_WRITE_INDEX;
+	}
+
+	/* Write out the data pending in the coalescing buffer */
+
+	if (avi_flush(AVI))
+	{
+		AVI_errno = AVI_ERR_WRITE;
+		return -1;
+	}
+
+	if (avi_write_header(AVI, movi_len, hasIndex))
+		return -1;
+
 	if (idxerror)
 		return -1;
 
@@ -495,7 +730,7 @@ static int avi_write_data(avi_t *AVI, char *data, long length, int audio)
 	if (audio)
 		n = avi_add_index_entry(AVI, "01wb", 0x00, AVI->pos, length);
 	else
-		n = avi_add_index_entry(AVI, "00db", 0x10, AVI->pos, length);
+		n = avi_add_index_entry(AVI, "00dc", 0x10, AVI->pos, length);
 
 	if (n)
 		return -1;
@@ -505,7 +740,7 @@ static int avi_write_data(avi_t *AVI, char *data, long length, int audio)
 	if (audio)
 		n = avi_add_chunk(AVI, "01wb", data, length);
 	else
-		n = avi_add_chunk(AVI, "00db", data, length);
+		n = avi_add_chunk(AVI, "00dc", data, length);
 
 	if (n)
 		return -1;
@@ -542,7 +777,7 @@ int AVI_dup_frame(avi_t *AVI)
 
 	if (AVI->last_pos == 0)
 		return 0; /* No previous real frame */
-	if (avi_add_index_entry(AVI, "00db", 0x10, AVI->last_pos, AVI->last_len))
+	if (avi_add_index_entry(AVI, "00dc", 0x10, AVI->last_pos, AVI->last_len))
 		return -1;
 	AVI->video_frames++;
 	AVI->must_use_index = 1;
@@ -563,6 +798,32 @@ int AVI_write_audio(avi_t *AVI, char *data, long bytes)
 	return 0;
 }
 
+int AVI_set_output_buffer(avi_t *AVI, char *buf)
+{
+	int ret = 0;
+
+	if (AVI->mode == AVI_MODE_READ || AVI->wbuf_size == 0)
+	{
+		AVI_errno = AVI_ERR_NOT_PERM;
+		return -1;
+	}
+
+	if (avi_flush(AVI))
+	{
+		AVI_errno = AVI_ERR_WRITE;
+		ret = -1;
+	}
+
+	/* Data already in the file is not written again, the first block is
+	  completed and written from the current position */
+
+	AVI->wbuf = buf;
+	AVI->wbuf_len = buf ? AVI->wpos % AVI->wbuf_size : 0;
+	AVI->wbuf_skip = AVI->wbuf_len;
+
+	return ret;
+}
+
 long AVI_bytes_remain(avi_t *AVI)
 {
 	if (AVI->mode == AVI_MODE_READ)
@@ -571,6 +832,385 @@ long AVI_bytes_remain(avi_t *AVI)
 	return (AVI_MAX_LEN - (AVI->pos + 8 + 16 * AVI->n_idx));
 }
 
+/*
+   AVI_checkpoint: Make the file readable as it is, should the recording be
+   interrupted. The pending data and the index entries kept in RAM are
+   written out, the header is updated w/ the current frame count and the
+   length of the movi list, and both the file and the sidecar are synced.
+   Costs a seek to the start of the file and back, so it is meant to be
+   called once in a few seconds, not per frame.
+
+   returns 0 on success, -1 on error, the recording may go on anyway
+*/
+
+int AVI_checkpoint(avi_t *AVI)
+{
+	if (AVI_checkpoint_write(AVI))
+		return -1;
+
+	return AVI_checkpoint_sync(AVI);
+}
+
+/*
+   AVI_checkpoint_write: The first half of AVI_checkpoint, everything but
+   the syncs. Leaves the file position where it has been.
+*/
+
+int AVI_checkpoint_write(avi_t *AVI)
+{
+	if (AVI->mode == AVI_MODE_READ)
+	{
+		AVI_errno = AVI_ERR_NOT_PERM;
+		return -1;
+	}
+
+	/* Re-attaching the buffer writes the pending data out, and keeps the
+	  following writes aligned */
+
+	if (AVI->wbuf ? AVI_set_output_buffer(AVI, AVI->wbuf) : fflush(AVI->fdes))
+	{
+		AVI_errno = AVI_ERR_WRITE;
+		return -1;
+	}
+
+	if (!AVI->idx_error && avi_spill_index(AVI))
+		AVI->idx_error = 1;
+
+	if (AVI->idx_sidecar && !AVI->idx_error && fflush(AVI->idx_sidecar))
+		AVI->idx_error = 1;
+
+	if (avi_write_header(AVI, AVI->pos - HEADERBYTES + 4, 0))
+		return -1;
+
+	if (fseek(AVI->fdes, AVI->pos, SEEK_SET) < 0 || fflush(AVI->fdes))
+	{
+		AVI_errno = AVI_ERR_WRITE;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+   AVI_checkpoint_sync: The second half of AVI_checkpoint. Only the file
+   descriptors are used, so frames may be written meanwhile.
+*/
+
+int AVI_checkpoint_sync(avi_t *AVI)
+{
+	if (AVI->mode == AVI_MODE_READ)
+	{
+		AVI_errno = AVI_ERR_NOT_PERM;
+		return -1;
+	}
+
+	if (AVI->idx_sidecar && !AVI->idx_error && fsync(fileno(AVI->idx_sidecar)))
+		AVI->idx_error = 1;
+
+	if (fsync(fileno(AVI->fdes)))
+	{
+		AVI_errno = AVI_ERR_WRITE;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* State of the recovery of an interrupted recording */
+
+typedef struct
+{
+	FILE  *fdes;
+	long   size;              /* Size of the file */
+	long   movi_end;          /* End of the last complete chunk */
+	long   n_idx;             /* Number of index entries */
+	long   video_frames;      /* Number of video chunks */
+	long   out;               /* Position of the next idx1 entry, 0 while counting */
+	char (*idx)[16];          /* Entries pending output */
+	long   idx_len;
+} avi_recovery_t;
+
+/* Tell the chunks of the movi list: "##dc", "##db", "##wb" */
+
+static int avi_is_data_tag(const char *tag)
+{
+	return tag[0] >= '0' && tag[0] <= '9' && tag[1] >= '0' && tag[1] <= '9' &&
+		((tag[2] == 'd' && (tag[3] == 'c' || tag[3] == 'b')) || (tag[2] == 'w' && tag[3] == 'b'));
+}
+
+static int avi_recovery_flush(avi_recovery_t *r)
+{
+	if (r->out == 0 || r->idx_len == 0)
+		return 0;
+
+	if (fseek(r->fdes, r->out, SEEK_SET) < 0 || fwrite(r->idx, 16, r->idx_len, r->fdes) != (size_t)r->idx_len)
+		return -1;
+
+	r->out += r->idx_len * 16;
+	r->idx_len = 0;
+
+	return 0;
+}
+
+/* Account for a chunk at `pos`. Only a chunk which is entirely in the file is
+   taken, returns 1, if it is not the case */
+
+static int avi_recovery_add(avi_recovery_t *r, const char *tag, long pos, long len)
+{
+	if (!avi_is_data_tag(tag) || len < 0 || pos + 8 + PAD_EVEN(len) > r->size)
+		return 1;
+
+	if (pos + 8 + PAD_EVEN(len) > r->movi_end)
+		r->movi_end = pos + 8 + PAD_EVEN(len);
+
+	r->n_idx++;
+	if (tag[2] == 'd')
+		r->video_frames++;
+
+	if (r->out == 0)
+		return 0;
+
+	memcpy(r->idx[r->idx_len], tag, 4);
+	long2str(r->idx[r->idx_len] + 4, tag[2] == 'd' ? 0x10 : 0x00);
+	long2str(r->idx[r->idx_len] + 8, pos - HEADERBYTES + 4);
+	long2str(r->idx[r->idx_len] + 12, len);
+	r->idx_len++;
+
+	if (r->idx_len == AVI_INDEX_RAM_ENTRIES)
+		return avi_recovery_flush(r) ? -1 : 0;
+
+	return 0;
+}
+
+/* Go through the chunks: those listed in the sidecar first, so only the tail
+   written after the last checkpoint has to be walked chunk by chunk. Stops at
+   the first chunk which is not data (e.g. a partially written idx1), or which
+   has been cut off */
+
+static int avi_recovery_scan(avi_recovery_t *r, FILE *sidecar)
+{
+	char entry[16];
+	char data[8];
+	long pos;
+	int ret;
+
+	r->movi_end = HEADERBYTES;
+	r->n_idx = 0;
+	r->video_frames = 0;
+
+	if (sidecar && fseek(sidecar, 0, SEEK_SET) == 0)
+	{
+		while (fread(entry, 1, 16, sidecar) == 16)
+		{
+			pos = str2ulong(entry + 8) + HEADERBYTES - 4;
+
+			/* Entries follow the chunks, except for duplicated frames */
+
+			if (pos > r->movi_end)
+				break;
+
+			ret = avi_recovery_add(r, entry, pos, str2ulong(entry + 12));
+			if (ret < 0)
+				return -1;
+			if (ret)
+				break;
+		}
+	}
+
+	for (pos = r->movi_end; pos + 8 <= r->size; pos += 8 + PAD_EVEN(str2ulong(data + 4)))
+	{
+		if (fseek(r->fdes, pos, SEEK_SET) < 0 || fread(data, 1, 8, r->fdes) != 8)
+			break;
+
+		ret = avi_recovery_add(r, data, pos, str2ulong(data + 4));
+		if (ret < 0)
+			return -1;
+		if (ret)
+			break;
+	}
+
+	return avi_recovery_flush(r);
+}
+
+/* Find a tag in the header, chunks are aligned to 2 bytes */
+
+static char *avi_find_tag(char *data, long len, const char *tag)
+{
+	long i;
+
+	for (i = 0; i + 4 <= len; i += 2)
+		if (memcmp(data + i, tag, 4) == 0)
+			return data + i;
+
+	return 0;
+}
+
+/* Get the frame size from the SOF segment of a JPEG image at `pos` */
+
+static int avi_jpeg_size(FILE *f, long pos, long len, long *width, long *height)
+{
+	unsigned char m[9];
+	long end = pos + len;
+
+	if (fseek(f, pos, SEEK_SET) < 0 || fread(m, 1, 2, f) != 2 || m[0] != 0xff || m[1] != 0xd8)
+		return -1;
+
+	for (pos += 2; pos + 9 <= end; pos += 2 + ((m[2] << 8) | m[3]))
+	{
+		if (fseek(f, pos, SEEK_SET) < 0 || fread(m, 1, 9, f) != 9 || m[0] != 0xff)
+			return -1;
+
+		if (m[1] >= 0xc0 && m[1] <= 0xc3)
+		{
+			*height = (m[5] << 8) | m[6];
+			*width = (m[7] << 8) | m[8];
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/*
+   AVI_recover: Make a file, which has not been closed properly (e.g. on a
+   power loss), playable. The chunks are found through the index sidecar,
+   and by walking the movi list, the idx1 gets appended after the last
+   complete chunk, and the header is rewritten. The stream parameters are
+   taken from the last checkpoint's header, if there is one, otherwise
+   the frame size is taken from the first JPEG frame, and `fps` is used.
+   Audio is not restored. The sidecar is removed.
+
+   returns the number of video frames recovered, 0 if the file has been
+   closed properly, and needs no recovery, -1 on error
+*/
+
+long AVI_recover(char *filename, double fps)
+{
+	avi_t AVI;
+	avi_recovery_t r;
+	char header[HEADERBYTES];
+	char data[8];
+	char *sidecar_name, *avih, *strh;
+	FILE *sidecar;
+	long ret;
+
+	memset(&AVI, 0, sizeof(AVI));
+	memset(&r, 0, sizeof(r));
+	sidecar_name = avi_sidecar_name(filename);
+	if (sidecar_name == 0)
+	{
+		AVI_errno = AVI_ERR_NO_MEM;
+		return -1;
+	}
+
+	r.fdes = fopen(filename, "rb+");
+	if (r.fdes == 0)
+	{
+		free(sidecar_name);
+		AVI_errno = AVI_ERR_OPEN;
+		return -1;
+	}
+
+	ret = -1;
+	sidecar = 0;
+
+	if (fseek(r.fdes, 0, SEEK_END) < 0 || (r.size = ftell(r.fdes)) < 0 ||
+		fseek(r.fdes, 0, SEEK_SET) < 0 || fread(header, 1, HEADERBYTES, r.fdes) != HEADERBYTES)
+	{
+		AVI_errno = AVI_ERR_NO_MOVI;
+		goto cleanup;
+	}
+
+	/* A checkpoint has been made, or the file has been closed */
+
+	avih = avi_find_tag(header, HEADERBYTES, "avih");
+	strh = avi_find_tag(header, HEADERBYTES, "strh");
+
+	if (memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "AVI ", 4) == 0 && avih && strh &&
+		memcmp(strh + 8, "vids", 4) == 0)
+	{
+		if (str2ulong(avih + 8 + 12) & AVIF_HASINDEX)
+		{
+			ret = 0;
+			goto cleanup;
+		}
+
+		if (str2ulong(avih + 8))
+			fps = 1000000. / str2ulong(avih + 8);
+		AVI.width = str2ulong(avih + 8 + 32);
+		AVI.height = str2ulong(avih + 8 + 36);
+		memcpy(AVI.compressor, strh + 12, 4);
+	}
+	else
+	{
+		memcpy(AVI.compressor, "MJPG", 4);
+	}
+
+	/* Count the chunks to find out where the index goes */
+
+	sidecar = fopen(sidecar_name, "rb");
+	if (avi_recovery_scan(&r, sidecar))
+	{
+		AVI_errno = AVI_ERR_READ;
+		goto cleanup;
+	}
+
+	if (r.video_frames == 0)
+	{
+		AVI_errno = AVI_ERR_NO_VIDS;
+		goto cleanup;
+	}
+
+	if (AVI.width == 0 && fseek(r.fdes, HEADERBYTES, SEEK_SET) == 0 && fread(data, 1, 8, r.fdes) == 8)
+		avi_jpeg_size(r.fdes, HEADERBYTES + 8, str2ulong(data + 4), &AVI.width, &AVI.height);
+
+	/* Output the index, and the header */
+
+	r.idx = (char(*)[16])malloc(AVI_INDEX_RAM_ENTRIES * 16);
+	if (r.idx == 0)
+	{
+		AVI_errno = AVI_ERR_NO_MEM;
+		goto cleanup;
+	}
+
+	AVI.fdes = r.fdes;
+	AVI.fps = fps;
+	AVI.video_frames = r.video_frames;
+	AVI.pos = r.movi_end + 8 + r.n_idx * 16;
+	memcpy(data, "idx1", 4);
+	long2str(data + 4, r.n_idx * 16);
+	r.out = r.movi_end + 8;
+
+	if (fseek(r.fdes, r.movi_end, SEEK_SET) < 0 || fwrite(data, 1, 8, r.fdes) != 8 || avi_recovery_scan(&r, sidecar))
+	{
+		AVI_errno = AVI_ERR_WRITE_INDEX;
+		goto cleanup;
+	}
+
+	if (avi_write_header(&AVI, r.movi_end - HEADERBYTES + 4, 1) || fflush(r.fdes))
+	{
+		AVI_errno = AVI_ERR_CLOSE;
+		goto cleanup;
+	}
+
+	ret = r.video_frames;
+
+cleanup:
+	if (fclose(r.fdes) && ret >= 0)
+	{
+		AVI_errno = AVI_ERR_CLOSE;
+		ret = -1;
+	}
+	if (sidecar)
+		fclose(sidecar);
+	if (ret >= 0)
+		remove(sidecar_name);
+	free(sidecar_name);
+	free(r.idx);
+
+	return ret;
+}
+
 /*******************************************************************
  *                                                                 *
  *    Utilities for reading video and audio from an AVI File       *
@@ -592,6 +1232,13 @@ int AVI_close(avi_t *AVI)
 	/* Even if there happened a error, we first clean up */
 
 	fclose(AVI->fdes);
+	if (AVI->idx_sidecar)
+	{
+		fclose(AVI->idx_sidecar);
+		remove(AVI->idx_sidecar_name);
+	}
+	if (AVI->idx_sidecar_name)
+		free(AVI->idx_sidecar_name);
 	if (AVI->idx)
 		free(AVI->idx);
 	if (AVI->video_index)
@@ -688,7 +1335,7 @@ avi_t *AVI_open_input_file(char *filename, int getIndex)
 			}
 			else if (strncasecmp(data, "movi", 4) == 0)
 			{
-				AVI->movi_start = fseek(AVI->fdes, 0, SEEK_CUR);
+				AVI->movi_start = ftell(AVI->fdes);
 				fseek(AVI->fdes, n, SEEK_CUR);
 			}
 			else
@@ -46,17 +46,44 @@ typedef struct
 	long   n_idx;             /* number of index entries actually filled */
 	long   max_idx;           /* number of index entries actually allocated */
 	char (*idx)[16];          /* index entries (AVI idx1 tag) */
+	long   idx_ram;           /* Writing: number of entries in `idx`, the rest is spilled */
+	FILE  *idx_sidecar;       /* Writing: spilled index entries, 0 if nothing has been spilled */
+	char  *idx_sidecar_name;  /* Writing: the file's name w/ ".idx" extension */
+	int    idx_error;         /* Writing: the index could not be spilled, and it is discarded */
 	video_index_entry * video_index;
 	audio_index_entry * audio_index;
 	long   last_pos;          /* Position of last frame written */
 	long   last_len;          /* Length of last frame written */
 	int    must_use_index;    /* Flag if frames are duplicated */
 	long   movi_start;
+
+	char  *wbuf;              /* Write coalescing buffer, 0 if not used */
+	long   wbuf_size;         /* Size of the buffer, writes are issued in multiples of it */
+	long   wbuf_len;          /* Bytes pending in the buffer */
+	long   wbuf_skip;         /* Bytes at the start of the buffer, which are already in the file */
+	long   wpos;              /* File position of the next write */
+	long   n_writes;          /* Number of writes issued to the file */
+	long   n_unaligned_writes; /* Writes not aligned to (or not a multiple of) wbuf_size */
 } avi_t;
 
+/* AVI_MAX_LEN: The maximum length of an AVI file, we stay a bit below
+	the 2GB limit (Remember: 2*10^9 is smaller than 2 GB) */
+
+#define AVI_MAX_LEN 2000000000
+
+/* AVI_INDEX_SIDECAR_SUFFIX: While writing, the index is spilled to a file
+	named after the AVI file w/ this extension. It is removed on close, so
+	the one left behind marks a recording which has not been finalized */
+
+#define AVI_INDEX_SIDECAR_SUFFIX ".idx"
+
 #define AVI_MODE_WRITE  0
 #define AVI_MODE_READ   1
 
+/* The error code of the last failed call, see below */
+
+extern long AVI_errno;
+
 /* The error codes delivered by avi_open_input_file */
 
 #define AVI_ERR_SIZELIM      1     /* The write of the data would exceed
@@ -121,14 +148,50 @@ typedef struct
 
 
 avi_t* AVI_open_output_file(char * filename);
+
+/* Same as AVI_open_output_file, but the output is coalesced in `buf`, so the
+   file gets written in `size`-byte multiples at `size`-aligned offsets (e.g.
+   FAT clusters), except for the tail written on close. Whole blocks of large
+   frames are written straight from the frame. The stream is unbuffered, so
+   stdio does not split the writes. `buf` is owned by the caller, and it must
+   outlive the file. If `buf` is 0, the output goes straight to the file until
+   a buffer is attached w/ AVI_set_output_buffer. Falls back to stdio
+   buffering, if `size` is less than the header. */
+avi_t* AVI_open_output_file_buffered(char * filename, char *buf, long size);
+
+/* Attaches a coalescing buffer of the size given on open to the file, or
+   detaches it, if `buf` is 0. Whatever is pending in the previous buffer gets
+   written first, so a single buffer may be handed over from one file to
+   another (e.g. segments of a recording). The first write after attaching
+   fills up the current block, the rest stay aligned. Returns -1, if the
+   pending data could not be written, the buffer is switched anyway. */
+int  AVI_set_output_buffer(avi_t *AVI, char *buf);
 void AVI_set_video(avi_t *AVI, int width, int height, double fps, char *compressor);
 void AVI_set_audio(avi_t *AVI, int channels, long rate, int bits, int format);
 int  AVI_write_frame(avi_t *AVI, char *data, long bytes);
 int  AVI_dup_frame(avi_t *AVI);
 int  AVI_write_audio(avi_t *AVI, char *data, long bytes);
 long AVI_bytes_remain(avi_t *AVI);
+
+/* Writes the pending data and the index out, updates the header, and syncs
+   the file, so it may be recovered w/ AVI_recover, should it not get closed.
+   Seeks to the start of the file and back, call it once in a few seconds */
+int  AVI_checkpoint(avi_t *AVI);
+
+/* AVI_checkpoint, split in two, so the slow part may be run off the task
+   writing the frames. AVI_checkpoint_write must not run concurrently w/ the
+   other calls on the file. AVI_checkpoint_sync may, as long as the file is
+   not closed meanwhile */
+int  AVI_checkpoint_write(avi_t *AVI);
+int  AVI_checkpoint_sync(avi_t *AVI);
 int  AVI_close(avi_t *AVI);
 
+/* Rebuilds the index and the header of a file which has not been closed,
+   keeping the frames up to the last complete one. Returns the number of
+   frames recovered, 0 if the file is intact, -1 on error. `fps` is used, if
+   no checkpoint has been made */
+long AVI_recover(char *filename, double fps);
+
 avi_t *AVI_open_input_file(char *filename, int getIndex);
 
 long AVI_video_frames(avi_t *AVI);
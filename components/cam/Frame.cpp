@@ -6,9 +6,12 @@
 //
 
 #include "cam/Frame.hpp"
+#include <atomic>
 
 using namespace Cam;
 
+static std::atomic<std::uint32_t> sSequence{0};
+
 int Frame::width()
 {
 	return -1;
@@ -22,4 +25,31 @@ int Frame::height()
 bool Frame::valid()
 {
 	return (size() > 0 && data() != nullptr);
-}
\ No newline at end of file
+}
+
+/// \brief The base frame does not own any resources
+void Frame::onRefCountZero()
+{
+}
+
+void Frame::setCaptured(std::int64_t aCaptureTimeUs)
+{
+	frameSequence = sSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+	frameCaptureTimeUs = aCaptureTimeUs;
+}
+
+void Frame::setCapturedAs(const Frame &aOriginal)
+{
+	frameSequence = aOriginal.frameSequence;
+	frameCaptureTimeUs = aOriginal.frameCaptureTimeUs;
+}
+
+std::uint32_t Frame::sequence() const
+{
+	return frameSequence;
+}
+
+std::int64_t Frame::captureTimeUs() const
+{
+	return frameCaptureTimeUs;
+}
@@ -0,0 +1,187 @@
+//
+// FrameRing.cpp
+//
+
+#include "cam/FrameRing.hpp"
+#include <esp_log.h>
+
+using namespace Cam;
+
+static constexpr const char *kTag = "[cam: frame ring]";
+
+// ------------ FrameRing ------------ //
+
+FrameRing &FrameRing::getInstance()
+{
+	static FrameRing instance{};
+
+	return instance;
+}
+
+void FrameRing::push(const FramePtr &aFrame)
+{
+	if (!ring.tryPush(aFrame)) {
+		ESP_LOGV(kTag, "a consumer is in the slot, skipping the frame");
+
+		return;
+	}
+
+	for (auto &consumer : consumers) {
+		auto *frameConsumer = consumer.load(std::memory_order_acquire);
+
+		if (frameConsumer != nullptr) {
+			frameConsumer->wake();
+		}
+	}
+}
+
+void FrameRing::pushCopy(const FramePtr &aFrame)
+{
+	const int slot = copies.copy(aFrame->data(), aFrame->size());
+
+	if (slot == CopyPool<CONFIG_CAM_FRAME_RING_COPIES>::kNone) {
+		ESP_LOGV(kTag, "no free copy, skipping the frame");
+
+		return;
+	}
+
+	// The slot is not used by a frame, as it is only released by the frame's destruction, see `Copy::onRefCountZero`
+	Copy *copy = copyFrames.tryEmplaceAt(static_cast<std::size_t>(slot), *this, slot, *aFrame.get());
+	push(FramePtr{copy});
+}
+
+int FrameRing::attach(FrameConsumer &aConsumer)
+{
+	const int consumerId = ring.registerConsumer();
+
+	if (consumerId != Ring::kNoConsumer) {
+		consumers[consumerId].store(&aConsumer, std::memory_order_release);
+	}
+
+	return consumerId;
+}
+
+void FrameRing::detach(int aConsumerId)
+{
+	if (aConsumerId != Ring::kNoConsumer) {
+		consumers[aConsumerId].store(nullptr, std::memory_order_release);
+		ring.unregisterConsumer(aConsumerId);
+	}
+}
+
+// ------------ FrameRing::Copy ------------ //
+
+FrameRing::Copy::Copy(FrameRing &aOwner, int aSlot, Frame &aOriginal) :
+	Frame{aOwner.copies.data(aSlot), aOwner.copies.size(aSlot)},
+	owner{aOwner},
+	slot{aSlot},
+	frameWidth{aOriginal.width()},
+	frameHeight{aOriginal.height()}
+{
+	setCapturedAs(aOriginal);
+}
+
+int FrameRing::Copy::width()
+{
+	return frameWidth;
+}
+
+int FrameRing::Copy::height()
+{
+	return frameHeight;
+}
+
+void FrameRing::Copy::onRefCountZero()
+{
+	FrameRing &ring = owner;
+	const int copySlot = slot;
+	ring.copyFrames.destroy(this);  // The copy is not to be reused before its frame is gone
+	ring.copies.release(copySlot);
+}
+
+// ------------ FrameConsumer ------------ //
+
+FrameConsumer::FrameConsumer(const char *aName, Callback &&aCallback, int aStack, int aPriority, CorePin aCorePin) :
+	Ut::Thr::FreertosTask{aName, aStack, aPriority, aCorePin},
+	consumerName{aName},
+	callback{std::move(aCallback)},
+	latency{Latency::registerConsumer(aName)},
+	semWake{},
+	mutex{},
+	consumerId{FrameRing::Ring::kNoConsumer},
+	started{false}
+{
+}
+
+void FrameConsumer::setEnabled(bool aEnabled)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const int id = consumerId.load();
+
+	if (aEnabled && id == FrameRing::Ring::kNoConsumer) {
+		const int newId = FrameRing::getInstance().attach(*this);
+
+		if (newId == FrameRing::Ring::kNoConsumer) {
+			ESP_LOGE(kTag, "%s: unable to attach, consumer table is full (see CONFIG_CAM_FRAME_RING_MAX_CONSUMERS)",
+				consumerName);
+
+			return;
+		}
+
+		consumerId.store(newId);
+
+		if (!started) {  // The task is created lazily, so idle consumers do not take memory
+			started = true;
+			start();
+		}
+	} else if (!aEnabled && id != FrameRing::Ring::kNoConsumer) {
+		const auto lastStats = FrameRing::getInstance().ring.stats(id);
+		FrameRing::getInstance().detach(id);
+		consumerId.store(FrameRing::Ring::kNoConsumer);
+		ESP_LOGI(kTag, "%s: detached, frames consumed %u, dropped %u", consumerName,
+			static_cast<unsigned>(lastStats.consumed), static_cast<unsigned>(lastStats.dropped));
+	}
+}
+
+bool FrameConsumer::isEnabled() const
+{
+	return consumerId.load() != FrameRing::Ring::kNoConsumer;
+}
+
+FrameRing::Stats FrameConsumer::stats() const
+{
+	return FrameRing::getInstance().ring.stats(consumerId.load());
+}
+
+const char *FrameConsumer::name() const
+{
+	return consumerName;
+}
+
+void FrameConsumer::wake()
+{
+	semWake.release();
+}
+
+void FrameConsumer::run()
+{
+	while (true) {
+		semWake.acquire();
+		FramePtr frame{};
+
+		while (true) {
+			std::lock_guard<std::mutex> lock{mutex};
+
+			if (!FrameRing::getInstance().ring.tryPop(consumerId.load(), frame)) {
+				break;
+			}
+
+			{
+				LatencyProbe latencyProbe{latency, *frame};
+				callback(frame);
+			}
+
+			frame.reset();  // Return the buffer to the camera ASAP
+		}
+	}
+}
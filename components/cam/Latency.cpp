@@ -0,0 +1,131 @@
+//
+// Latency.cpp
+//
+
+#include "cam/Latency.hpp"
+#include "utility/time.hpp"
+#include <esp_log.h>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+using namespace Cam;
+
+static constexpr const char *kTag = "[cam: latency]";
+
+namespace {
+
+struct Table {
+	std::array<LatencyStats, CONFIG_CAM_LATENCY_MAX_CONSUMERS> entries;
+	std::atomic<std::size_t> size;
+	std::mutex mutex;  ///< Serializes registration
+
+	Table() : size{0}
+	{
+		for (auto &entry : entries) {
+			entry.name.store(nullptr);
+			entry.reset();
+		}
+	}
+};
+
+/// \brief Consumers register themselves from constructors of static
+/// instances, hence the lazy initialization
+Table &table()
+{
+	static Table instance{};
+
+	return instance;
+}
+
+LatencyStats::Histogram::Value clampUs(std::int64_t aUs)
+{
+	using Value = LatencyStats::Histogram::Value;
+
+	if (aUs < 0) {
+		return 0;
+	}
+
+	return aUs > std::numeric_limits<Value>::max() ? std::numeric_limits<Value>::max() : static_cast<Value>(aUs);
+}
+
+}  // namespace
+
+// ------------ LatencyStats ------------ //
+
+void LatencyStats::reset()
+{
+	captureToConsume.reset();
+	consumeDuration.reset();
+	lastSequence.store(0, std::memory_order_relaxed);
+}
+
+// ------------ Latency ------------ //
+
+LatencyStats *Latency::registerConsumer(const char *aName)
+{
+	auto &tab = table();
+	std::lock_guard<std::mutex> lock{tab.mutex};
+	const std::size_t size = tab.size.load();
+
+	for (std::size_t i = 0; i < size; ++i) {
+		if (std::strcmp(tab.entries[i].name.load(), aName) == 0) {
+			return &tab.entries[i];
+		}
+	}
+
+	if (size == tab.entries.size()) {
+		ESP_LOGW(kTag, "%s: unable to register, the table is full (see CONFIG_CAM_LATENCY_MAX_CONSUMERS)", aName);
+
+		return nullptr;
+	}
+
+	tab.entries[size].name.store(aName);
+	tab.size.store(size + 1);
+
+	return &tab.entries[size];
+}
+
+std::size_t Latency::size()
+{
+	return table().size.load();
+}
+
+LatencyStats &Latency::at(std::size_t aIndex)
+{
+	return table().entries[aIndex];
+}
+
+void Latency::reset()
+{
+	for (std::size_t i = 0; i < size(); ++i) {
+		at(i).reset();
+	}
+}
+
+// ------------ LatencyProbe ------------ //
+
+LatencyProbe::LatencyProbe(LatencyStats *aStats, const Frame &aFrame) :
+	LatencyProbe{aStats, aFrame.sequence(), aFrame.captureTimeUs()}
+{
+}
+
+LatencyProbe::LatencyProbe(LatencyStats *aStats, std::uint32_t aSequence, std::int64_t aCaptureTimeUs) :
+	stats{aStats},
+	startUs{Ut::bootTimeUs()}
+{
+	if (stats == nullptr || aSequence == 0) {  // Not stamped by the camera
+		return;
+	}
+
+	stats->captureToConsume.record(clampUs(startUs - aCaptureTimeUs));
+	stats->lastSequence.store(aSequence, std::memory_order_relaxed);
+}
+
+LatencyProbe::~LatencyProbe()
+{
+	if (stats != nullptr) {
+		stats->consumeDuration.record(clampUs(Ut::bootTimeUs() - startUs));
+	}
+}
@@ -0,0 +1,204 @@
+//
+// ReplayCamera.cpp
+//
+
+#include "cam/ReplayCamera.hpp"
+#include "utility/time.hpp"
+#include <esp_log.h>
+
+using namespace Cam;
+
+static constexpr const char *kTag = "[cam: replay]";
+
+#if CONFIG_CAM_MODEL_REPLAY
+
+/// \brief Constructs the frame source according to the configuration
+static Replay::Source &kconfigSource()
+{
+#if CONFIG_CAM_REPLAY_SOURCE_AVI
+	static Replay::AviMjpegSource source{};
+
+	if (!source.open(CONFIG_CAM_REPLAY_FILE)) {
+		ESP_LOGE(kTag, "Unable to open \"%s\" as MJPEG AVI", CONFIG_CAM_REPLAY_FILE);
+	}
+#elif CONFIG_CAM_REPLAY_SOURCE_RAW_GRAYSCALE
+	static Replay::RawGrayscaleSource source{CONFIG_CAM_REPLAY_WIDTH, CONFIG_CAM_REPLAY_HEIGHT};
+
+	if (!source.open(CONFIG_CAM_REPLAY_FILE)) {
+		ESP_LOGE(kTag, "Unable to open \"%s\"", CONFIG_CAM_REPLAY_FILE);
+	}
+#else
+	static Replay::SyntheticSource source{CONFIG_CAM_REPLAY_WIDTH, CONFIG_CAM_REPLAY_HEIGHT};
+#endif
+
+	return source;
+}
+
+#if CONFIG_CAM_REPLAY_LOOP
+static constexpr bool kLoop = true;
+#else
+static constexpr bool kLoop = false;
+#endif
+
+#if CONFIG_CAM_REPLAY_SOURCE_AVI
+static constexpr bool kGrayscale = false;
+#else
+static constexpr bool kGrayscale = true;
+#endif
+
+ReplayCamera::ReplayCamera() :
+	ReplayCamera{kconfigSource(), static_cast<float>(CONFIG_CAM_REPLAY_FPS), kLoop, kGrayscale}
+{
+}
+
+#endif  // CONFIG_CAM_MODEL_REPLAY
+
+ReplayCamera::ReplayCamera(Replay::Source &aSource, float aFps, bool aLoop, bool aGrayscale) :
+	Mod::ModuleBase{Mod::Module::Camera},
+	source{aSource},
+	pacer{aFps},
+	loop{aLoop},
+	grayscale{aGrayscale},
+	initialized{false},
+	bufferSize{0},
+	buffers{},
+	framePool{},
+	lastFrame{-1, -1}
+{
+}
+
+/// \brief Allocates frame buffers. That is the only allocation the camera makes
+void ReplayCamera::init()
+{
+	bufferSize = source.maxFrameSize();
+
+	if (bufferSize == 0) {
+		ESP_LOGE(kTag, "The source has no frames");
+
+		return;
+	}
+
+	for (auto &buffer : buffers) {
+		buffer.reset(new (std::nothrow) std::uint8_t[bufferSize]);
+
+		if (!buffer) {
+			ESP_LOGE(kTag, "Unable to allocate %d frame buffers, %d bytes each", kBuffers, bufferSize);
+
+			return;
+		}
+	}
+
+	initialized = true;
+	ESP_LOGI(kTag, "Initialized, %d buffers, %d bytes each", kBuffers, bufferSize);
+}
+
+FramePtr ReplayCamera::getFrame()
+{
+	if (!initialized) {
+		return FramePtr{};
+	}
+
+	pacer.wait();
+
+	for (std::size_t i = 0; i < kBuffers; ++i) {
+		if (framePool.isUsed(i)) {
+			continue;
+		}
+
+		// The slot is claimed first, so the buffer is never read into, while a frame made of it is still out there
+		Frame *frame = framePool.tryEmplaceAt(i, *this, buffers[i].get());
+
+		if (frame == nullptr) {  // Has been occupied concurrently
+			continue;
+		}
+
+		FramePtr framePtr{frame};  // Gives the slot back, if the frame is not read
+		Replay::Source::FrameInfo frameInfo{};
+		bool read = source.read(buffers[i].get(), bufferSize, frameInfo);
+
+		if (!read && loop && source.rewind()) {
+			read = source.read(buffers[i].get(), bufferSize, frameInfo);
+		}
+
+		if (!read) {
+			ESP_LOGW(kTag, "End of sequence");
+
+			return FramePtr{};
+		}
+
+		frame->assign(frameInfo);
+		lastFrame.width = frameInfo.width;
+		lastFrame.height = frameInfo.height;
+
+		return framePtr;
+	}
+
+	ESP_LOGW(kTag, "could not find a free buffer");
+
+	return FramePtr{};
+}
+
+void ReplayCamera::getFieldValue(Mod::Fld::Req aRequest, Mod::Fld::OnResponseCallback aOnResponse)
+{
+	switch (aRequest.field) {
+		case Mod::Fld::Field::FrameSize:
+			if (initialized && lastFrame.width > 0) {
+				aOnResponse(makeResponse<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(lastFrame.width,
+					lastFrame.height));
+			}
+
+			break;
+
+		case Mod::Fld::Field::Initialized:
+			aOnResponse(makeResponse<Mod::Module::Camera, Mod::Fld::Field::Initialized>(initialized));
+
+			break;
+
+		case Mod::Fld::Field::ModelName:
+			aOnResponse(makeResponse<Mod::Module::Camera, Mod::Fld::Field::ModelName>("Replay"));
+
+			break;
+
+		case Mod::Fld::Field::FrameFormat:
+			aOnResponse(makeResponse<Mod::Module::Camera, Mod::Fld::Field::FrameFormat>(
+				grayscale ? "grayscale" : "jpeg"));
+
+			break;
+
+		default:
+			break;
+	}
+}
+
+// ------------ ReplayCamera::Frame ------------ //
+
+ReplayCamera::Frame::Frame(ReplayCamera &aOwner, std::uint8_t *aData) :
+	Cam::Frame{aData, 0},
+	owner{aOwner},
+	frameWidth{0},
+	frameHeight{0}
+{
+}
+
+void ReplayCamera::Frame::assign(const Replay::Source::FrameInfo &aFrameInfo)
+{
+	static_cast<Ut::Cont::Buffer &>(*this) = Ut::Cont::Buffer{data(), aFrameInfo.size};
+	frameWidth = aFrameInfo.width;
+	frameHeight = aFrameInfo.height;
+	setCaptured(Ut::bootTimeUs());  // The frame is considered captured once it has been read from the source
+}
+
+int ReplayCamera::Frame::width()
+{
+	return frameWidth;
+}
+
+int ReplayCamera::Frame::height()
+{
+	return frameHeight;
+}
+
+void ReplayCamera::Frame::onRefCountZero()
+{
+	owner.framePool.destroy(this);
+}
@@ -8,6 +8,7 @@
 #include "sdkconfig.h"
 #include "cam/cam.hpp"
 #include "cam/Camera.hpp"
+#include "cam/ReplayCamera.hpp"
 #include "Ov2640.hpp"
 
 template <typename T>
@@ -21,9 +22,10 @@ static void init()
 void camInit()
 {
 #ifdef CONFIG_CAM_ENABLE
-#ifdef CONFIG_CAM_MODEL_OV2640
+#if defined(CONFIG_CAM_MODEL_OV2640)
 	init<Ov2640>();
-#else
+#elif defined(CONFIG_CAM_MODEL_REPLAY)
+	init<Cam::ReplayCamera>();
 #endif // CONFIG_CAM_MODEL_OV2640
 #endif  // CONFIG_CAM_ENABLE
 }
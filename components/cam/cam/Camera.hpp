@@ -8,7 +8,6 @@
 #ifndef CAM_CAM_CAMERA_HPP
 #define CAM_CAM_CAMERA_HPP
 
-#include <memory>
 #include "utility/cont/Buffer.hpp"
 #include "Frame.hpp"
 
@@ -16,9 +15,10 @@ namespace Cam {
 
 class CameraBase {
 public:
-	virtual std::shared_ptr<Frame> getFrame()
+	/// \returns Empty handle, if no frame is available
+	virtual FramePtr getFrame()
 	{
-		return std::make_shared<Frame>();
+		return FramePtr{};
 	}
 
 	virtual ~CameraBase() = default;
@@ -0,0 +1,110 @@
+//
+// CopyPool.hpp
+//
+
+#ifndef CAM_CAM_COPYPOOL_HPP
+#define CAM_CAM_COPYPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace Cam {
+
+/// \brief Buffers the frames get copied into, when the driver re-uses its buffer as soon as the frame has been
+/// delivered (e.g. OV2640 w/ hooks). A copy stays intact until it is released, whatever the driver does meanwhile.
+///
+/// \details Copies are made by a single producer (the camera thread), and released by any of the consumers. Slots
+/// are claimed, and released lock-free. A slot's buffer is allocated on its first use, and it only grows, so there
+/// are no allocations, once the frame size has settled.
+template <std::size_t N>
+class CopyPool {
+	static_assert(N > 0, "A pool must have at least one slot");
+
+public:
+	static constexpr int kNone = -1;
+
+	CopyPool() : buffers{}, capacities{}, sizes{}
+	{
+		for (auto &slotUsed : used) {
+			slotUsed.store(false);
+		}
+	}
+
+	CopyPool(const CopyPool &) = delete;
+	CopyPool &operator=(const CopyPool &) = delete;
+
+	/// \brief Copies the frame into a free slot
+	/// \returns the slot, or `kNone`, if there is no free one, or no memory for the copy
+	int copy(const void *aData, std::size_t aSize)
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			bool expected = false;
+
+			if (!used[i].compare_exchange_strong(expected, true, std::memory_order_acquire,
+				std::memory_order_relaxed))
+			{
+				continue;
+			}
+
+			if (aSize > capacities[i]) {
+				buffers[i].reset(new (std::nothrow) std::uint8_t[aSize]);
+				capacities[i] = buffers[i] ? aSize : 0;
+			}
+
+			if (!buffers[i]) {
+				used[i].store(false, std::memory_order_release);
+
+				return kNone;
+			}
+
+			std::memcpy(buffers[i].get(), aData, aSize);
+			sizes[i] = aSize;
+
+			return static_cast<int>(i);
+		}
+
+		return kNone;
+	}
+
+	/// \pre `aSlot` has been returned by `copy`, and it has not been released
+	std::uint8_t *data(int aSlot)
+	{
+		return buffers[aSlot].get();
+	}
+
+	std::size_t size(int aSlot) const
+	{
+		return sizes[aSlot];
+	}
+
+	/// \brief Returns the slot into the pool. Its buffer is kept for the copies to come
+	void release(int aSlot)
+	{
+		used[aSlot].store(false, std::memory_order_release);
+	}
+
+	std::size_t countUsed() const
+	{
+		std::size_t count = 0;
+
+		for (const auto &slotUsed : used) {
+			count += slotUsed.load(std::memory_order_relaxed) ? 1 : 0;
+		}
+
+		return count;
+	}
+
+private:
+	std::unique_ptr<std::uint8_t[]> buffers[N];
+	std::size_t capacities[N];
+	std::size_t sizes[N];
+	std::atomic<bool> used[N];
+};
+
+}  // namespace Cam
+
+#endif  // CAM_CAM_COPYPOOL_HPP
@@ -9,18 +9,47 @@
 #define CAM_CAM_FRAME_HPP
 
 #include "utility/cont/Buffer.hpp"
+#include "utility/IntrusivePtr.hpp"
+#include <cstdint>
 
 namespace Cam {
 
-struct Frame : Ut::Cont::Buffer {
+/// \brief Frame handle. Frames are reference-counted intrusively, so passing
+/// them around does not entail any allocations. A camera implementation
+/// decides what happens to a frame, when it is no longer referenced.
+struct Frame : Ut::Cont::Buffer, Ut::RefCounted {
 	using Ut::Cont::Buffer::Buffer;
 	using Ut::Cont::Buffer::operator=;
 
 	virtual int width();
 	virtual int height();
 	virtual bool valid();
+
+	/// \brief Stamps the frame w/ the capture time, and assigns it the next
+	/// sequence number. Sequence numbers are shared between all camera
+	/// implementations, and they increase monotonically, so a gap means that a
+	/// frame has been dropped before it reached a consumer.
+	/// \param aCaptureTimeUs - time since boot, as returned by `Ut::bootTimeUs()`
+	void setCaptured(std::int64_t aCaptureTimeUs);
+
+	std::uint32_t sequence() const;
+
+	/// \brief Capture time since boot, us. 0, if the frame has not been stamped
+	std::int64_t captureTimeUs() const;
+
+protected:
+	void onRefCountZero() override;
+
+	/// \brief Takes over the capture time, and the sequence number of the frame this one is a copy of
+	void setCapturedAs(const Frame &aOriginal);
+
+private:
+	std::uint32_t frameSequence = 0;
+	std::int64_t frameCaptureTimeUs = 0;
 };
 
+using FramePtr = Ut::IntrusivePtr<Frame>;
+
 }  // namespace Cam
 
 #endif  // CAM_CAM_FRAME_HPP
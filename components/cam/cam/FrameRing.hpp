@@ -0,0 +1,133 @@
+//
+// FrameRing.hpp
+//
+
+#ifndef CAM_CAM_FRAMERING_HPP
+#define CAM_CAM_FRAMERING_HPP
+
+#include "cam/CopyPool.hpp"
+#include "cam/Frame.hpp"
+#include "cam/Latency.hpp"
+#include "utility/cont/Pool.hpp"
+#include "utility/cont/SpmcRing.hpp"
+#include "utility/thr/Semaphore.hpp"
+#include "utility/thr/Threading.hpp"
+#include <sdkconfig.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace Cam {
+
+class FrameConsumer;
+
+/// \brief Decouples frame consumers from the camera thread. The camera thread
+/// pushes each frame into the ring, and each `FrameConsumer` reads it from
+/// its own context, at its own pace.
+///
+/// \details Mind that frames in the ring, and those being processed by the
+/// consumers, occupy the driver's frame buffers. A frame is only kept in the
+/// ring until every consumer has read it, but there may still be up to
+/// `CONFIG_CAM_FRAME_RING_DEPTH` frames waiting, and one being processed by
+/// each consumer.
+///
+/// \details A driver which re-uses its buffer as soon as the frame has been
+/// delivered (OV2640 w/ hooks) hands its frames over w/ `pushCopy`, so the
+/// consumers get copies the ring owns, see `Cam::CopyPool`.
+class FrameRing {
+public:
+	using Ring = Ut::Cont::SpmcRing<FramePtr, CONFIG_CAM_FRAME_RING_DEPTH, CONFIG_CAM_FRAME_RING_MAX_CONSUMERS>;
+	using Stats = typename Ring::ConsumerStats;
+
+	static FrameRing &getInstance();
+
+	/// \brief Places the frame into the ring, and wakes the consumers up.
+	/// Never blocks, so it is safe to call from the driver's callbacks. If a
+	/// consumer happens to be reading the slot the frame goes to, the frame is
+	/// skipped.
+	void push(const FramePtr &aFrame);
+
+	/// \brief Same as `push`, but the frame is copied first, so it may be
+	/// released (and its buffer re-used) right after the call. If all the
+	/// copies (CONFIG_CAM_FRAME_RING_COPIES) are in use, or there is no memory
+	/// for one, the frame is skipped.
+	void pushCopy(const FramePtr &aFrame);
+
+private:
+	/// \brief A frame copied into one of the `copies`
+	class Copy : public Frame {
+	public:
+		Copy(FrameRing &aOwner, int aSlot, Frame &aOriginal);
+		int width() override;
+		int height() override;
+	protected:
+		void onRefCountZero() override;
+	private:
+		FrameRing &owner;
+		int slot;
+		int frameWidth;
+		int frameHeight;
+	};
+
+	friend class FrameConsumer;
+	int attach(FrameConsumer &aConsumer);
+	void detach(int aConsumerId);
+
+private:
+	Ring ring;
+	CopyPool<CONFIG_CAM_FRAME_RING_COPIES> copies;
+	Ut::Cont::Pool<Copy, CONFIG_CAM_FRAME_RING_COPIES> copyFrames;  ///< Slot `i` wraps `copies`' slot `i`
+	std::array<std::atomic<FrameConsumer *>, CONFIG_CAM_FRAME_RING_MAX_CONSUMERS> consumers;
+};
+
+/// \brief Worker context processing frames from `FrameRing`.
+///
+/// \details When the consumer falls behind, the oldest frames are dropped for
+/// this very consumer. Others, as well as the camera thread, are not affected.
+/// Latency of each frame's processing is recorded under the consumer's name
+/// (see `Cam::Latency`).
+class FrameConsumer : public Ut::Thr::FreertosTask {
+public:
+	using Callback = std::function<void(const FramePtr &)>;
+
+	FrameConsumer(const char *aName, Callback &&aCallback, int aStack = CONFIG_CAM_FRAME_CONSUMER_STACK_SIZE,
+		int aPriority = CONFIG_CAM_FRAME_CONSUMER_PRIORITY, CorePin aCorePin = CorePin::CoreNone);
+
+	template <class T>
+	FrameConsumer(const char *aName, void (T::*aMethod)(const FramePtr &), T *aInstance,
+		int aStack = CONFIG_CAM_FRAME_CONSUMER_STACK_SIZE, int aPriority = CONFIG_CAM_FRAME_CONSUMER_PRIORITY,
+		CorePin aCorePin = CorePin::CoreNone) :
+		FrameConsumer{aName, [aMethod, aInstance](const FramePtr &aFrame) { (aInstance->*aMethod)(aFrame); }, aStack,
+			aPriority, aCorePin}
+	{
+	}
+
+	/// \brief Starts / stops receiving frames. Disabling blocks until the
+	/// frame being processed at the moment, if any, is handled.
+	void setEnabled(bool aEnabled);
+	bool isEnabled() const;
+
+	/// \brief Number of frames processed, dropped, and pending
+	FrameRing::Stats stats() const;
+	const char *name() const;
+
+	void run() override;
+
+private:
+	friend class FrameRing;
+	void wake();
+
+private:
+	const char *consumerName;
+	Callback callback;
+	LatencyStats *latency;
+	Ut::Thr::Semaphore<1, 0> semWake;
+	std::mutex mutex;  ///< Taken while a frame is being processed
+	std::atomic<int> consumerId;
+	bool started;
+};
+
+}  // namespace Cam
+
+#endif  // CAM_CAM_FRAMERING_HPP
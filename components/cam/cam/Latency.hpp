@@ -0,0 +1,66 @@
+//
+// Latency.hpp
+//
+
+#ifndef CAM_CAM_LATENCY_HPP
+#define CAM_CAM_LATENCY_HPP
+
+#include "cam/Frame.hpp"
+#include "utility/al/Histogram.hpp"
+#include <sdkconfig.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cam {
+
+/// \brief Frame latency statistics of a particular consumer
+struct LatencyStats {
+	using Histogram = Ut::Al::Histogram<>;
+
+	std::atomic<const char *> name;
+	Histogram captureToConsume;  ///< Time from the frame's capture to the beginning of its processing, us
+	Histogram consumeDuration;  ///< Time spent processing the frame, us
+	std::atomic<std::uint32_t> lastSequence;  ///< Sequence number of the last frame consumed
+
+	void reset();
+};
+
+/// \brief Registry of per-consumer latency statistics. The statistics are
+/// stored in a fixed table, and they are never unregistered, so a pointer
+/// obtained once remains valid.
+class Latency {
+public:
+	/// \brief Finds the consumer's entry by name, or creates a new one
+	/// \returns nullptr, if the table is full (see CONFIG_CAM_LATENCY_MAX_CONSUMERS)
+	static LatencyStats *registerConsumer(const char *aName);
+
+	/// \brief Number of registered consumers
+	static std::size_t size();
+
+	/// \pre aIndex < size()
+	static LatencyStats &at(std::size_t aIndex);
+
+	static void reset();
+};
+
+/// \brief Measures latency of a single frame's processing. Construct it at the
+/// beginning of a frame handler.
+class LatencyProbe {
+public:
+	/// \param aStats - may be nullptr, in which case nothing gets recorded
+	LatencyProbe(LatencyStats *aStats, const Frame &aFrame);
+	/// \brief For the frames which have been handed over w/o the `Frame` itself, see `Frame::sequence()`
+	LatencyProbe(LatencyStats *aStats, std::uint32_t aSequence, std::int64_t aCaptureTimeUs);
+	~LatencyProbe();
+	LatencyProbe(const LatencyProbe &) = delete;
+	LatencyProbe &operator=(const LatencyProbe &) = delete;
+
+private:
+	LatencyStats *stats;
+	std::int64_t startUs;
+};
+
+}  // namespace Cam
+
+#endif  // CAM_CAM_LATENCY_HPP
@@ -0,0 +1,77 @@
+//
+// ReplayCamera.hpp
+//
+
+#ifndef CAM_CAM_REPLAYCAMERA_HPP
+#define CAM_CAM_REPLAYCAMERA_HPP
+
+#include "cam/Camera.hpp"
+#include "cam/replay/Pacer.hpp"
+#include "cam/replay/Source.hpp"
+#include "module/ModuleBase.hpp"
+#include "utility/cont/Pool.hpp"
+#include <sdkconfig.h>
+#include <cstdint>
+#include <memory>
+
+namespace Cam {
+
+/// \brief Camera replaying a recorded (MJPEG AVI, raw grayscale) or a
+/// synthetic frame sequence at a configured rate. Enables profiling of the
+/// frame path w/o a sensor.
+///
+/// \details Similar to the sensor's driver, the camera has a fixed number of
+/// frame buffers allocated once on initialization. A frame handle occupies
+/// its buffer until it is released.
+class ReplayCamera : public CameraBase, public Mod::ModuleBase {
+public:
+#if defined(CONFIG_CAM_REPLAY_N_BUFFERS)
+	static constexpr std::size_t kBuffers = CONFIG_CAM_REPLAY_N_BUFFERS;
+#else
+	static constexpr std::size_t kBuffers = 2;
+#endif
+
+	/// \brief Constructs a camera from Kconfig settings (CONFIG_CAM_REPLAY_*)
+	ReplayCamera();
+	ReplayCamera(Replay::Source &aSource, float aFps, bool aLoop, bool aGrayscale);
+	void init() override;
+	FramePtr getFrame() override;
+
+protected:
+	void getFieldValue(Mod::Fld::Req, Mod::Fld::OnResponseCallback) override;
+
+private:
+	class Frame : public Cam::Frame {
+	public:
+		Frame(ReplayCamera &aOwner, std::uint8_t *aData);
+
+		/// \brief The frame has been read into the buffer
+		void assign(const Replay::Source::FrameInfo &aFrameInfo);
+		int width() override;
+		int height() override;
+	protected:
+		void onRefCountZero() override;
+	private:
+		ReplayCamera &owner;
+		int frameWidth;
+		int frameHeight;
+	};
+
+private:
+	Replay::Source &source;
+	Replay::Pacer pacer;
+	bool loop;
+	bool grayscale;
+	bool initialized;
+	std::size_t bufferSize;
+	std::unique_ptr<std::uint8_t[]> buffers[kBuffers];
+	Ut::Cont::Pool<Frame, kBuffers> framePool;
+	struct {
+		int width;
+		int height;
+	} lastFrame;
+};
+
+}  // namespace Cam
+
+#endif  // CAM_CAM_REPLAYCAMERA_HPP
@@ -0,0 +1,76 @@
+//
+// Pacer.hpp
+//
+
+#ifndef CAM_CAM_REPLAY_PACER_HPP
+#define CAM_CAM_REPLAY_PACER_HPP
+
+#include <chrono>
+#include <thread>
+
+namespace Cam {
+namespace Replay {
+
+/// \brief Paces frame production at a constant rate
+class Pacer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/// \param aFps Non-positive value disables pacing
+	explicit Pacer(float aFps) : period{}, next{}, started{false}
+	{
+		setFps(aFps);
+	}
+
+	void setFps(float aFps)
+	{
+		period = aFps > 0.0f ?
+			std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>{1.0f / aFps}) :
+			Clock::duration::zero();
+		started = false;
+	}
+
+	/// \brief Blocks until the next frame is due.
+	///
+	/// \details If the caller is late for more than a period, the missed
+	/// slots are skipped rather than produced in a burst, the same way a
+	/// sensor would behave.
+	///
+	/// \returns The moment the frame is due
+	Clock::time_point wait()
+	{
+		const auto now = Clock::now();
+
+		if (period == Clock::duration::zero()) {
+			return now;
+		}
+
+		if (!started) {
+			started = true;
+			next = now + period;
+
+			return now;
+		}
+
+		if (now < next) {
+			std::this_thread::sleep_until(next);
+		} else {
+			next += ((now - next) / period) * period;  // Skip missed slots
+		}
+
+		const auto due = next;
+		next += period;
+
+		return due;
+	}
+
+private:
+	Clock::duration period;
+	Clock::time_point next;
+	bool started;
+};
+
+}  // namespace Replay
+}  // namespace Cam
+
+#endif  // CAM_CAM_REPLAY_PACER_HPP
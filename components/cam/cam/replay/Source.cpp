@@ -0,0 +1,351 @@
+//
+// Source.cpp
+//
+
+#include "cam/replay/Source.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Cam {
+namespace Replay {
+
+static constexpr std::size_t kFourccSize = 4;
+static constexpr std::size_t kChunkHeaderSize = 8;
+static constexpr std::size_t kAvihSize = 56;
+
+static std::uint32_t u32FromLe(const std::uint8_t *aData)
+{
+	return static_cast<std::uint32_t>(aData[0])
+		| static_cast<std::uint32_t>(aData[1]) << 8
+		| static_cast<std::uint32_t>(aData[2]) << 16
+		| static_cast<std::uint32_t>(aData[3]) << 24;
+}
+
+static bool isFourcc(const std::uint8_t *aData, const char *aFourcc)
+{
+	return std::memcmp(aData, aFourcc, kFourccSize) == 0;
+}
+
+/// \brief RIFF chunks are word-aligned
+static long padEven(long aSize)
+{
+	return (aSize + 1) & ~1L;
+}
+
+// ------------ AviMjpegSource ------------ //
+
+AviMjpegSource::AviMjpegSource() :
+	file{nullptr},
+	moviBegin{0},
+	moviEnd{0},
+	width{-1},
+	height{-1},
+	usPerFrame{0},
+	maxChunkSize{0},
+	nFrames{0}
+{
+}
+
+AviMjpegSource::~AviMjpegSource()
+{
+	close();
+}
+
+bool AviMjpegSource::open(const char *aFilename)
+{
+	close();
+	file = std::fopen(aFilename, "rb");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	if (!parseHeader() || !rewind()) {
+		close();
+
+		return false;
+	}
+
+	// Scan through the video chunks to find out the buffer size required
+	std::uint32_t chunkSize = 0;
+	nFrames = 0;
+	maxChunkSize = 0;
+
+	while (nextVideoChunk(chunkSize)) {
+		++nFrames;
+		maxChunkSize = std::max<std::size_t>(maxChunkSize, chunkSize);
+
+		if (std::fseek(file, padEven(chunkSize), SEEK_CUR) != 0) {
+			break;
+		}
+	}
+
+	if (nFrames == 0) {
+		close();
+
+		return false;
+	}
+
+	return rewind();
+}
+
+void AviMjpegSource::close()
+{
+	if (file != nullptr) {
+		std::fclose(file);
+		file = nullptr;
+	}
+
+	moviBegin = 0;
+	moviEnd = 0;
+	nFrames = 0;
+	maxChunkSize = 0;
+}
+
+bool AviMjpegSource::parseHeader()
+{
+	std::uint8_t header[kChunkHeaderSize + kFourccSize];
+
+	if (std::fread(header, 1, sizeof(header), file) != sizeof(header) || !isFourcc(header, "RIFF")
+			|| !isFourcc(header + kChunkHeaderSize, "AVI ")) {
+		return false;
+	}
+
+	std::fseek(file, 0, SEEK_END);
+	const long fileSize = std::ftell(file);
+	long position = sizeof(header);
+	long hdrlEnd = 0;
+
+	// Walk through the top-level chunks, descending into the "hdrl" list
+	while (position + static_cast<long>(kChunkHeaderSize) <= fileSize) {
+		if (std::fseek(file, position, SEEK_SET) != 0
+				|| std::fread(header, 1, kChunkHeaderSize, file) != kChunkHeaderSize) {
+			break;
+		}
+
+		const long chunkSize = static_cast<long>(u32FromLe(header + kFourccSize));
+		position += kChunkHeaderSize;
+
+		if (isFourcc(header, "LIST")) {
+			if (std::fread(header, 1, kFourccSize, file) != kFourccSize) {
+				break;
+			}
+
+			if (isFourcc(header, "movi")) {
+				moviBegin = position + kFourccSize;
+				moviEnd = std::min(position + chunkSize, fileSize);
+				position += padEven(chunkSize);
+			} else if (isFourcc(header, "hdrl") || isFourcc(header, "strl")) {
+				hdrlEnd = std::max(hdrlEnd, position + chunkSize);
+				position += kFourccSize;  // Descend into the list
+			} else {
+				position += padEven(chunkSize);
+			}
+		} else if (isFourcc(header, "avih") && position < hdrlEnd) {
+			std::uint8_t avih[kAvihSize];
+
+			if (chunkSize < static_cast<long>(kAvihSize) || std::fread(avih, 1, kAvihSize, file) != kAvihSize) {
+				return false;
+			}
+
+			usPerFrame = u32FromLe(avih);
+			width = static_cast<int>(u32FromLe(avih + 32));
+			height = static_cast<int>(u32FromLe(avih + 36));
+			position += padEven(chunkSize);
+		} else {
+			position += padEven(chunkSize);
+		}
+	}
+
+	return moviBegin != 0;
+}
+
+bool AviMjpegSource::nextVideoChunk(std::uint32_t &aChunkSize)
+{
+	std::uint8_t header[kChunkHeaderSize];
+
+	while (true) {
+		const long position = std::ftell(file);
+
+		if (position < 0 || position + static_cast<long>(kChunkHeaderSize) > moviEnd
+				|| std::fread(header, 1, kChunkHeaderSize, file) != kChunkHeaderSize) {
+			return false;
+		}
+
+		const std::uint32_t chunkSize = u32FromLe(header + kFourccSize);
+
+		if (isFourcc(header, "LIST")) {  // E.g. "rec " lists, descend
+			std::fseek(file, kFourccSize, SEEK_CUR);
+		} else if (header[2] == 'd' && (header[3] == 'c' || header[3] == 'b')) {
+			if (position + static_cast<long>(kChunkHeaderSize + chunkSize) > moviEnd) {  // Truncated
+				return false;
+			}
+
+			aChunkSize = chunkSize;
+
+			return true;
+		} else if (std::fseek(file, padEven(chunkSize), SEEK_CUR) != 0) {
+			return false;
+		}
+	}
+}
+
+bool AviMjpegSource::read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo)
+{
+	std::uint32_t chunkSize = 0;
+
+	if (file == nullptr || !nextVideoChunk(chunkSize)) {
+		return false;
+	}
+
+	if (chunkSize > aCapacity) {
+		std::fseek(file, padEven(chunkSize), SEEK_CUR);
+
+		return false;
+	}
+
+	if (std::fread(aBuffer, 1, chunkSize, file) != chunkSize) {
+		return false;
+	}
+
+	std::fseek(file, padEven(chunkSize) - chunkSize, SEEK_CUR);
+	aFrameInfo = {chunkSize, width, height};
+
+	return true;
+}
+
+bool AviMjpegSource::rewind()
+{
+	return file != nullptr && std::fseek(file, moviBegin, SEEK_SET) == 0;
+}
+
+std::size_t AviMjpegSource::maxFrameSize() const
+{
+	return maxChunkSize;
+}
+
+float AviMjpegSource::fps() const
+{
+	return usPerFrame > 0 ? 1000000.0f / static_cast<float>(usPerFrame) : 0.0f;
+}
+
+std::size_t AviMjpegSource::frameCount() const
+{
+	return nFrames;
+}
+
+// ------------ RawGrayscaleSource ------------ //
+
+RawGrayscaleSource::RawGrayscaleSource(int aWidth, int aHeight) :
+	file{nullptr},
+	width{aWidth},
+	height{aHeight}
+{
+}
+
+RawGrayscaleSource::~RawGrayscaleSource()
+{
+	close();
+}
+
+bool RawGrayscaleSource::open(const char *aFilename)
+{
+	close();
+	file = std::fopen(aFilename, "rb");
+
+	return file != nullptr;
+}
+
+void RawGrayscaleSource::close()
+{
+	if (file != nullptr) {
+		std::fclose(file);
+		file = nullptr;
+	}
+}
+
+bool RawGrayscaleSource::read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo)
+{
+	const std::size_t frameSize = maxFrameSize();
+
+	if (file == nullptr || aCapacity < frameSize || std::fread(aBuffer, 1, frameSize, file) != frameSize) {
+		return false;
+	}
+
+	aFrameInfo = {frameSize, width, height};
+
+	return true;
+}
+
+bool RawGrayscaleSource::rewind()
+{
+	return file != nullptr && std::fseek(file, 0, SEEK_SET) == 0;
+}
+
+std::size_t RawGrayscaleSource::maxFrameSize() const
+{
+	return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+}
+
+// ------------ SyntheticSource ------------ //
+
+SyntheticSource::SyntheticSource(int aWidth, int aHeight, std::size_t aFrames, int aSquareSize) :
+	width{aWidth},
+	height{aHeight},
+	nFrames{std::max<std::size_t>(aFrames, 1)},
+	squareSize{std::min(aSquareSize, std::min(aWidth, aHeight))},
+	frame{0}
+{
+}
+
+bool SyntheticSource::read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo)
+{
+	static constexpr std::uint8_t kSquareIntensity = 255;
+	static constexpr std::uint8_t kBackgroundMask = 0x7f;  // Keep the background darker than the square
+	const std::size_t frameSize = maxFrameSize();
+
+	if (frame >= nFrames || aCapacity < frameSize) {
+		return false;
+	}
+
+	int squareX = 0;
+	int squareY = 0;
+	squarePosition(frame, squareX, squareY);
+
+	for (int y = 0; y < height; ++y) {
+		std::uint8_t *row = aBuffer + static_cast<std::size_t>(y) * width;
+
+		for (int x = 0; x < width; ++x) {
+			const bool inSquare = x >= squareX && x < squareX + squareSize && y >= squareY
+				&& y < squareY + squareSize;
+			row[x] = inSquare ? kSquareIntensity : static_cast<std::uint8_t>((x + y) / 4) & kBackgroundMask;
+		}
+	}
+
+	++frame;
+	aFrameInfo = {frameSize, width, height};
+
+	return true;
+}
+
+bool SyntheticSource::rewind()
+{
+	frame = 0;
+
+	return true;
+}
+
+std::size_t SyntheticSource::maxFrameSize() const
+{
+	return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+}
+
+void SyntheticSource::squarePosition(std::size_t aFrame, int &aX, int &aY) const
+{
+	const std::size_t steps = nFrames > 1 ? nFrames - 1 : 1;
+	aX = static_cast<int>(aFrame * static_cast<std::size_t>(width - squareSize) / steps);
+	aY = static_cast<int>(aFrame * static_cast<std::size_t>(height - squareSize) / steps);
+}
+
+}  // namespace Replay
+}  // namespace Cam
@@ -0,0 +1,130 @@
+//
+// Source.hpp
+//
+
+#ifndef CAM_CAM_REPLAY_SOURCE_HPP
+#define CAM_CAM_REPLAY_SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace Cam {
+namespace Replay {
+
+/// \brief Frame source for the replay camera. Implementations do not allocate
+/// memory per frame: frames are read into a buffer provided by the caller.
+///
+/// \details Implementations only use the standard library, so they can be
+/// built and tested on a host.
+class Source {
+public:
+	struct FrameInfo {
+		std::size_t size;
+		int width;
+		int height;
+	};
+
+	/// \brief Reads the next frame into `aBuffer`
+	/// \returns false, if the end of the sequence is reached, or the frame
+	/// does not fit the buffer
+	virtual bool read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo) = 0;
+
+	/// \brief Starts the sequence over
+	virtual bool rewind() = 0;
+
+	/// \brief Buffer size which is sufficient for any frame of the sequence
+	virtual std::size_t maxFrameSize() const = 0;
+
+	/// \brief Frame rate suggested by the source. 0, if unknown
+	virtual float fps() const
+	{
+		return 0.0f;
+	}
+
+	virtual ~Source() = default;
+};
+
+/// \brief Reads MJPEG frames from an AVI file (e.g. one produced by
+/// `CameraRecorder::RecMjpgAvi`). Video chunks ("##dc", "##db") of the
+/// "movi" list are read sequentially, so the file does not have to have an
+/// index.
+class AviMjpegSource : public Source {
+public:
+	AviMjpegSource();
+	~AviMjpegSource();
+	AviMjpegSource(const AviMjpegSource &) = delete;
+	AviMjpegSource &operator=(const AviMjpegSource &) = delete;
+
+	/// \brief Opens the file, parses the header, and scans through the
+	/// "movi" list to find out the largest frame size
+	bool open(const char *aFilename);
+	void close();
+	bool read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo) override;
+	bool rewind() override;
+	std::size_t maxFrameSize() const override;
+	float fps() const override;
+	std::size_t frameCount() const;
+
+private:
+	bool parseHeader();
+	bool nextVideoChunk(std::uint32_t &aChunkSize);
+
+private:
+	std::FILE *file;
+	long moviBegin;  ///< Offset of the first chunk in the "movi" list
+	long moviEnd;
+	int width;
+	int height;
+	std::uint32_t usPerFrame;
+	std::size_t maxChunkSize;
+	std::size_t nFrames;
+};
+
+/// \brief Reads a file of concatenated raw 8-bit grayscale frames of the same
+/// resolution
+class RawGrayscaleSource : public Source {
+public:
+	RawGrayscaleSource(int aWidth, int aHeight);
+	~RawGrayscaleSource();
+	RawGrayscaleSource(const RawGrayscaleSource &) = delete;
+	RawGrayscaleSource &operator=(const RawGrayscaleSource &) = delete;
+
+	bool open(const char *aFilename);
+	void close();
+	bool read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo) override;
+	bool rewind() override;
+	std::size_t maxFrameSize() const override;
+
+private:
+	std::FILE *file;
+	int width;
+	int height;
+};
+
+/// \brief Generates grayscale frames with a bright square moving over a
+/// gradient background. Useful for benchmarking w/o any file at hand.
+class SyntheticSource : public Source {
+public:
+	/// \param aFrames Sequence length. The square makes a full pass over the
+	/// frame during the sequence
+	SyntheticSource(int aWidth, int aHeight, std::size_t aFrames = 100, int aSquareSize = 32);
+	bool read(std::uint8_t *aBuffer, std::size_t aCapacity, FrameInfo &aFrameInfo) override;
+	bool rewind() override;
+	std::size_t maxFrameSize() const override;
+
+	/// \brief Position of the square's top left corner in the `aFrame`-th frame
+	void squarePosition(std::size_t aFrame, int &aX, int &aY) const;
+
+private:
+	int width;
+	int height;
+	std::size_t nFrames;
+	int squareSize;
+	std::size_t frame;
+};
+
+}  // namespace Replay
+}  // namespace Cam
+
+#endif  // CAM_CAM_REPLAY_SOURCE_HPP
@@ -0,0 +1,320 @@
+//
+// Catalog.cpp
+//
+
+#include <sdkconfig.h>
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include "camera_recorder/Catalog.hpp"
+#include "camera_recorder/RecMjpgAvi.hpp"
+#include "camera_recorder/camera_recorder.hpp"
+#include "utility/thr/WorkQueue.hpp"
+#include "utility/time.hpp"
+#include "sd_fat.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <strings.h>
+#include <sys/stat.h>
+
+namespace CameraRecorder {
+
+Catalog::Catalog() :
+	mutex{},
+	built{false},
+	generation{0},
+	total{0, 0, 0},
+	latest{},
+	latestFirst{0},
+	latestCount{0},
+	unfinished{},
+	unfinishedCount{0}
+{
+	sdFatSetOnMounted(&Catalog::onMounted, this);
+}
+
+esp_err_t Catalog::summary(Summary &aOut)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const esp_err_t err = ensureBuilt();
+
+	if (err == ESP_OK) {
+		aOut = total;
+	}
+
+	return err;
+}
+
+void Catalog::onCreated(const char *aPath)
+{
+	const char *name = basename(aPath);
+
+	if (kind(name) == Kind::None) {
+		return;
+	}
+
+	struct stat st{};
+	const bool exists = stat(aPath, &st) == 0;  // Before the lock, so queries do not wait for the card
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (!isValid()) {
+		return;
+	}
+
+	Entry *entry = find(name);
+
+	if (entry != nullptr) {  // Overwritten
+		total.bytes -= std::min<std::uint64_t>(total.bytes, entry->size);
+		entry->size = 0;
+	} else if (exists) {  // Overwritten, and it has fallen out of the "latest" window. It is counted in already
+		total.bytes -= std::min<std::uint64_t>(total.bytes, static_cast<std::uint64_t>(st.st_size));
+		addLatest(name, 0);
+	} else {
+		add(name, 0);
+	}
+}
+
+void Catalog::onClosed(const char *aPath, std::uint32_t aSize)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const char *name = basename(aPath);
+
+	if (!isValid() || kind(name) == Kind::None) {
+		return;
+	}
+
+	Entry *entry = find(name);
+	std::uint32_t sizePrev = 0;
+
+	if (entry != nullptr) {
+		sizePrev = entry->size;
+		entry->size = aSize;
+	}
+
+	total.bytes = total.bytes + aSize - sizePrev;
+}
+
+void Catalog::onRemoved(const char *aPath)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const char *name = basename(aPath);
+	const Kind fileKind = kind(name);
+
+	if (!isValid() || fileKind == Kind::None) {
+		return;
+	}
+
+	if (fileKind == Kind::Photo && total.photos > 0) {
+		--total.photos;
+	} else if (fileKind == Kind::Video && total.videos > 0) {
+		--total.videos;
+	}
+
+	Entry *entry = find(name);
+
+	if (entry == nullptr) {  // Fell out of the "latest" window, the size is unknown
+		return;
+	}
+
+	total.bytes -= std::min<std::uint64_t>(total.bytes, entry->size);
+
+	// Close the gap
+	const auto pos = static_cast<std::size_t>(entry - latest.data());
+	std::size_t i = (pos + latest.size() - latestFirst) % latest.size();
+
+	for (; i + 1 < latestCount; ++i) {
+		latest[(latestFirst + i) % latest.size()] = latest[(latestFirst + i + 1) % latest.size()];
+	}
+
+	--latestCount;
+}
+
+void Catalog::invalidate()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	built = false;
+}
+
+Catalog::Kind Catalog::kind(const char *aName)
+{
+	const char *extension = strrchr(aName, '.');
+
+	if (extension == nullptr) {
+		return Kind::None;
+	} else if (strcasecmp(extension, ".jpg") == 0 || strcasecmp(extension, ".jpeg") == 0) {
+		return Kind::Photo;
+	} else if (strcasecmp(extension, ".avi") == 0) {
+		return Kind::Video;
+	}
+
+	return Kind::None;
+}
+
+const char *Catalog::basename(const char *aPath)
+{
+	const char *separator = strrchr(aPath, '/');
+
+	return separator == nullptr ? aPath : separator + 1;
+}
+
+/// \brief The catalog is rebuilt right away, rather than on the first query, so the unfinished recordings get
+/// recovered. The card is scanned from the work queue, as the mount may be performed from any context
+void Catalog::onMounted(void *aInstance)
+{
+	if (!Ut::Thr::Wq::MediumPriority::checkInstance()) {
+		return;
+	}
+
+	Ut::Thr::Wq::MediumPriority::getInstance().push(
+		[aInstance]()
+		{
+			Catalog &catalog = *static_cast<Catalog *>(aInstance);
+			std::lock_guard<std::mutex> lock{catalog.mutex};
+			catalog.ensureBuilt();
+		});
+}
+
+void Catalog::onScanned(const char *aName, std::uint32_t aSize, void *aInstance)
+{
+	static_cast<Catalog *>(aInstance)->add(aName, aSize);
+	static_cast<Catalog *>(aInstance)->addUnfinished(aName, aSize);
+}
+
+esp_err_t Catalog::ensureBuilt()
+{
+	if (isValid()) {
+		return ESP_OK;
+	}
+
+	const auto startedUs = Ut::bootTimeUs();
+	total = {0, 0, 0};
+	latestFirst = 0;
+	latestCount = 0;
+	unfinishedCount = 0;
+	generation = sdFatGeneration();
+	built = sdFatForEachFile(&Catalog::onScanned, this);
+
+	if (!built) {
+		ESP_LOGW(kDebugTag, "Catalog: unable to scan the storage");
+
+		return ESP_ERR_NOT_FOUND;
+	}
+
+	ESP_LOGI(kDebugTag, "Catalog: built in %lld ms, photos %u, videos %u, %llu KiB",
+		static_cast<long long>((Ut::bootTimeUs() - startedUs) / 1000), total.photos, total.videos,
+		static_cast<unsigned long long>(total.bytes / 1024));
+	scheduleRecovery();
+
+	return ESP_OK;
+}
+
+bool Catalog::isValid() const
+{
+	return built && generation == sdFatGeneration();
+}
+
+void Catalog::add(const char *aName, std::uint32_t aSize)
+{
+	const Kind fileKind = kind(aName);
+
+	if (fileKind == Kind::None) {
+		return;
+	}
+
+	if (fileKind == Kind::Photo) {
+		++total.photos;
+	} else {
+		++total.videos;
+	}
+
+	total.bytes += aSize;
+	addLatest(aName, aSize);
+}
+
+void Catalog::addLatest(const char *aName, std::uint32_t aSize)
+{
+	if (latestCount == latest.size()) {  // Drop the oldest one
+		latestFirst = (latestFirst + 1) % latest.size();
+		--latestCount;
+	}
+
+	Entry &entry = latest[(latestFirst + latestCount) % latest.size()];
+	strncpy(entry.name, aName, sizeof(entry.name) - 1);
+	entry.name[sizeof(entry.name) - 1] = '\0';
+	entry.size = aSize;
+	++latestCount;
+}
+
+Catalog::Entry *Catalog::find(const char *aName)
+{
+	for (std::size_t i = latestCount; i > 0; --i) {  // Most likely, it is one of the newest
+		Entry &entry = latest[(latestFirst + i - 1) % latest.size()];
+
+		if (strncasecmp(entry.name, aName, sizeof(entry.name) - 1) == 0) {  // W/o long file names, FAT reports upper case
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+/// \brief Takes a recording, if it has left the index sidecar behind (see `AVI_INDEX_SIDECAR_SUFFIX`), or if it
+/// is too small to hold a frame
+void Catalog::addUnfinished(const char *aName, std::uint32_t aSize)
+{
+	static constexpr std::uint32_t kSizeNoFrames = 4096;  // Header, and a frame's worth at most
+	static constexpr const char *kVideoExtension = ".avi";
+	const char *extension = strrchr(aName, '.');
+
+	if (extension == nullptr || unfinishedCount == unfinished.size()
+		|| strlen(aName) - strlen(extension) + strlen(kVideoExtension) >= kNameMaxLength
+		|| !(strcasecmp(extension, AVI_INDEX_SIDECAR_SUFFIX) == 0
+		|| (kind(aName) == Kind::Video && aSize < kSizeNoFrames)))
+	{
+		return;
+	}
+
+	Entry entry{};
+	strncpy(entry.name, aName, extension - aName);
+	strcat(entry.name, kVideoExtension);
+
+	for (std::size_t i = 0; i < unfinishedCount; ++i) {
+		if (strcasecmp(unfinished[i].name, entry.name) == 0) {
+			return;
+		}
+	}
+
+	unfinished[unfinishedCount++] = entry;
+}
+
+void Catalog::scheduleRecovery()
+{
+	if (unfinishedCount == 0) {
+		return;
+	}
+
+	if (!Ut::Thr::Wq::MediumPriority::checkInstance() || !RecMjpgAvi::checkInstance()) {
+		ESP_LOGW(kDebugTag, "Catalog: %u unfinished recordings, unable to recover",
+			static_cast<unsigned>(unfinishedCount));
+
+		return;
+	}
+
+	ESP_LOGI(kDebugTag, "Catalog: %u unfinished recordings, recovering", static_cast<unsigned>(unfinishedCount));
+	const auto names = unfinished;
+	const auto count = unfinishedCount;
+	unfinishedCount = 0;
+	Ut::Thr::Wq::MediumPriority::getInstance().push(
+		[names, count]()
+		{
+			for (std::size_t i = 0; i < count; ++i) {
+				const std::string path = std::string{CONFIG_SD_FAT_MOUNT_POINT} + "/" + names[i].name;
+				RecMjpgAvi::getInstance().recover(path.c_str());
+			}
+		});
+}
+
+}  // namespace CameraRecorder
@@ -0,0 +1,119 @@
+//
+// PreRoll.cpp
+//
+
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include <esp_heap_caps.h>
+#include "camera_recorder/PreRoll.hpp"
+
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+
+using namespace CameraRecorder;
+
+static constexpr const char *kTag = "[camera_recorder: pre-roll]";
+static constexpr std::size_t kArenaSize = CONFIG_CAMERA_RECORDER_PREROLL_BUFFER_KB * 1024;
+static constexpr std::int64_t kWindowUs = static_cast<std::int64_t>(CONFIG_CAMERA_RECORDER_PREROLL_S) * 1000000;
+
+PreRoll::PreRoll() :
+	mutex{},
+	arena{static_cast<std::uint8_t *>(heap_caps_malloc(kArenaSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT))},
+	ring{},
+	frameConsumer{"PreRoll", &PreRoll::onNewFrame, this},
+	lastCaptureTimeUs{-1},
+	pushed{0},
+	oversize{0}
+{
+	if (arena == nullptr) {
+		ESP_LOGE(kTag, "unable to allocate %u KiB of PSRAM, pre-roll is disabled",
+			static_cast<unsigned>(CONFIG_CAMERA_RECORDER_PREROLL_BUFFER_KB));
+
+		return;
+	}
+
+	ring.assign(arena, kArenaSize);
+	ESP_LOGI(kTag, "%d s, %u KiB of PSRAM, up to %u frames", CONFIG_CAMERA_RECORDER_PREROLL_S,
+		static_cast<unsigned>(CONFIG_CAMERA_RECORDER_PREROLL_BUFFER_KB), static_cast<unsigned>(Ring::maxSize()));
+}
+
+PreRoll::~PreRoll()
+{
+	frameConsumer.setEnabled(false);
+	heap_caps_free(arena);
+}
+
+void PreRoll::arm()
+{
+	if (isAvailable()) {
+		frameConsumer.setEnabled(true);
+	}
+}
+
+void PreRoll::disarm()
+{
+	frameConsumer.setEnabled(false);
+}
+
+bool PreRoll::isAvailable() const
+{
+	return arena != nullptr;
+}
+
+void PreRoll::push(Cam::Frame &aFrame)
+{
+	pushImpl(aFrame, false);
+}
+
+PreRoll::Stats PreRoll::stats() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return {ring.size(), ring.usedBytes(), ring.capacityBytes(), pushed, ring.evicted(), oversize};
+}
+
+void PreRoll::onNewFrame(const Cam::FramePtr &aFrame)
+{
+	static constexpr std::uint32_t kLogPeriod = 200;
+
+	if (aFrame && aFrame->data() != nullptr && aFrame->size()) {
+		pushImpl(*aFrame, true);
+	}
+
+	if (frameConsumer.stats().consumed % kLogPeriod == 0) {
+		const auto preRollStats = stats();
+		ESP_LOGD(kTag, "armed, frames %u, %u of %u KiB, pushed %u, evicted %u, oversize %u, dropped by the consumer %u",
+			static_cast<unsigned>(preRollStats.frames), static_cast<unsigned>(preRollStats.usedBytes / 1024),
+			static_cast<unsigned>(preRollStats.capacityBytes / 1024), static_cast<unsigned>(preRollStats.pushed),
+			static_cast<unsigned>(preRollStats.evicted), static_cast<unsigned>(preRollStats.oversize),
+			static_cast<unsigned>(frameConsumer.stats().dropped));
+	}
+}
+
+/// \param aExpire - discard the frames which have fallen out of the pre-roll window
+void PreRoll::pushImpl(Cam::Frame &aFrame, bool aExpire)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (aFrame.captureTimeUs() <= lastCaptureTimeUs) {  // Both the consumer and the recorder have got it on handover
+		return;
+	}
+
+	lastCaptureTimeUs = aFrame.captureTimeUs();
+
+	if (!ring.push_back(aFrame.data(), aFrame.size(), Meta{aFrame.captureTimeUs(), aFrame.width(), aFrame.height()})) {
+		++oversize;
+
+		return;
+	}
+
+	++pushed;
+
+	while (aExpire && ring.front().meta.captureTimeUs < aFrame.captureTimeUs() - kWindowUs) {
+		ring.pop_front();
+	}
+}
+
+#endif  // CONFIG_CAMERA_RECORDER_PREROLL_S
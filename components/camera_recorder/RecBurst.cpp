@@ -0,0 +1,367 @@
+//
+// RecBurst.cpp
+//
+
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include <esp_heap_caps.h>
+#include "cam/Camera.hpp"
+#include "camera_recorder/Catalog.hpp"
+#include "camera_recorder/RecBurst.hpp"
+#include "camera_recorder/RecFrame.hpp"
+#include "utility/time.hpp"
+#include "sd_fat.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+using namespace CameraRecorder;
+
+static constexpr const char *kTag = "[camera_recorder: burst]";
+static constexpr std::size_t kArenaSize = CONFIG_CAMERA_RECORDER_BURST_BUFFER_KB * 1024;
+static constexpr std::size_t kJpegRatio = 16;  ///< Pixels per byte, a conservative estimate of a photo's size
+static constexpr std::size_t kShotsMin = 2;  ///< The buffer must hold the shot being written, and the one being taken
+static constexpr std::chrono::milliseconds kPollPeriod{50};
+static constexpr std::int64_t kStreamTimeoutUs = 1000000;  ///< W/o a frame stream in place, frames are pulled
+static constexpr std::int64_t kStallTimeoutUs = 3000000;  ///< W/o frames, the burst is aborted
+
+static Cam::LatencyStats::Histogram::Value clampUs(std::int64_t aUs)
+{
+	using Value = Cam::LatencyStats::Histogram::Value;
+
+	return aUs < 0 ? 0 : static_cast<Value>(std::min<std::int64_t>(aUs, std::numeric_limits<Value>::max()));
+}
+
+RecBurst::RecBurst() :
+	Ut::Thr::FreertosTask{"RecBurst", CONFIG_CAM_FRAME_CONSUMER_STACK_SIZE, CONFIG_CAM_FRAME_CONSUMER_PRIORITY},
+	key{&RecBurst::onNewFrame, this},
+	mutex{},
+	arena{nullptr},
+	arenaSize{0},
+	ring{},
+	request{0, 0, 0, nullptr},
+	frameSizePrev{0, 0},
+	active{false},
+	capturing{false},
+	taken{0},
+	reported{0},
+	nextShotUs{0},
+	lastFrameUs{0},
+	lastStreamUs{0},
+	semWake{},
+	taskStarted{false},
+	latency{Cam::Latency::registerConsumer("RecBurst")}
+{
+	key.setEnabled(false);
+}
+
+RecBurst::~RecBurst()
+{
+	key.setEnabled(false);
+	heap_caps_free(arena);
+}
+
+bool RecBurst::start(Request aRequest)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		if (active) {
+			ESP_LOGW(kTag, "start -- fail (a burst is ongoing)");
+
+			return false;
+		}
+
+		active = true;  // Claim it
+	}
+
+	const auto photoFrameSize = RecFrame::photoFrameSize();
+	const bool allocated = arenaAllocate(kShotsMin * static_cast<std::size_t>(photoFrameSize.first)
+		* photoFrameSize.second / kJpegRatio);
+	sdFatInit();
+
+	if (!allocated || aRequest.intervalUs < 0 || !RecFrame::readFrameSize(frameSizePrev)
+		|| !RecFrame::writeFrameSize(photoFrameSize))
+	{
+		ESP_LOGE(kTag, "start -- fail (%s)", !allocated ? "unable to allocate the buffer" : "frame size");
+		std::lock_guard<std::mutex> lock{mutex};
+		heap_caps_free(arena);
+		arena = nullptr;
+		arenaSize = 0;
+		active = false;
+
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		ring.assign(arena, arenaSize);
+		request = std::move(aRequest);
+		capturing = true;
+		taken = 0;
+		reported = 0;
+		nextShotUs = 0;
+		lastFrameUs = Ut::bootTimeUs();
+		lastStreamUs = lastFrameUs;
+	}
+
+	if (!taskStarted) {
+		taskStarted = true;
+		Ut::Thr::FreertosTask::start();
+	}
+
+	ESP_LOGI(kTag, "started, shots: %u, interval: %lld ms, first: %u.jpg", request.count,
+		static_cast<long long>(request.intervalUs / 1000), request.firstName);
+	key.setEnabled(true);
+	semWake.release();
+
+	return true;
+}
+
+void RecBurst::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		capturing = false;
+	}
+
+	semWake.release();
+}
+
+bool RecBurst::isActive() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return active;
+}
+
+std::int64_t RecBurst::intervalUs() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return active ? request.intervalUs : 0;
+}
+
+/// \brief PSRAM is preferred. Otherwise, at most half of the largest free block of internal RAM is taken, so the
+/// rest of the firmware is not starved, unless it is less than `aSizeMin`
+/// \returns false, if a buffer of at least `aSizeMin` could not be allocated
+bool RecBurst::arenaAllocate(std::size_t aSizeMin)
+{
+#if CONFIG_ESP32_SPIRAM_SUPPORT
+	arena = static_cast<std::uint8_t *>(heap_caps_malloc(std::max(kArenaSize, aSizeMin),
+		MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+
+	if (arena != nullptr) {
+		arenaSize = std::max(kArenaSize, aSizeMin);
+
+		return true;
+	}
+#endif
+	arenaSize = std::max(aSizeMin,
+		std::min(kArenaSize, heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) / 2));
+	arena = static_cast<std::uint8_t *>(heap_caps_malloc(arenaSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+
+	if (arena == nullptr) {
+		arenaSize = 0;
+
+		return false;
+	}
+
+	ESP_LOGI(kTag, "no PSRAM, %u KiB of internal RAM taken", static_cast<unsigned>(arenaSize / 1024));
+
+	return true;
+}
+
+/// \brief The writer. Also pulls frames from the camera, if there is no frame stream to take the shots from
+void RecBurst::run()
+{
+	while (true) {
+		semWake.try_acquire_for(kPollPeriod);
+		bool pull = false;
+
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			const auto nowUs = Ut::bootTimeUs();
+
+			if (capturing && nowUs - lastFrameUs > kStallTimeoutUs) {
+				ESP_LOGW(kTag, "no frames from the camera, aborting");
+				capturing = false;
+			}
+
+			pull = capturing && nowUs - lastStreamUs > kStreamTimeoutUs && nowUs >= nextShotUs;
+		}
+
+		if (pull) {
+			auto frame = Cam::Camera::getInstance().getFrame();
+
+			if (frame && frame->valid()) {
+				takeShot(*frame);
+			}
+		}
+
+		while (true) {
+			Ring::Entry entry{};
+			const std::uint8_t *data = nullptr;
+			bool done = false;
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+
+				if (!active) {
+					break;
+				}
+
+				if (ring.empty()) {
+					done = !capturing;
+
+					if (!done) {
+						break;
+					}
+				} else {
+					entry = ring.front();  // While the ring holds it, `takeShot` does not touch its data
+					data = ring.data(entry);
+				}
+			}
+
+			if (done) {
+				finish();
+
+				break;
+			}
+
+			while (reported < entry.meta.index) {  // Skipped, as there was no space in the ring
+				reportShot(reported, false, 0, 0);
+			}
+
+			reportShot(entry.meta.index, writeShot(entry, data), entry.meta.scheduledUs, entry.meta.captureTimeUs);
+			std::lock_guard<std::mutex> lock{mutex};
+			ring.pop_front();
+		}
+	}
+}
+
+void RecBurst::onNewFrame(Sub::Key::NewFrameEvent aFrame)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		lastStreamUs = Ut::bootTimeUs();
+	}
+
+	if (aFrame && aFrame->valid()) {
+		takeShot(*aFrame);
+	}
+}
+
+/// \brief Copies the frame into the ring, if a shot is due
+void RecBurst::takeShot(Cam::Frame &aFrame)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const auto nowUs = Ut::bootTimeUs();
+	const auto captureTimeUs = aFrame.sequence() != 0 ? aFrame.captureTimeUs() : nowUs;  // Stamped by the camera
+	lastFrameUs = nowUs;
+
+	if (!capturing || (nextShotUs != 0 && captureTimeUs < nextShotUs)) {
+		return;
+	}
+
+	const auto scheduledUs = nextShotUs != 0 ? nextShotUs : captureTimeUs;
+
+	if (ring.fits(aFrame.size())) {
+		ring.push_back(aFrame.data(), aFrame.size(), Meta{taken, scheduledUs, captureTimeUs});
+	} else {
+		ESP_LOGW(kTag, "shot %u skipped, the writer is behind", taken);
+	}
+
+	++taken;
+	nextShotUs = scheduledUs + request.intervalUs;
+
+	while (request.intervalUs > 0 && nextShotUs <= captureTimeUs) {  // The camera has been late, skip the slots missed
+		nextShotUs += request.intervalUs;
+	}
+
+	if (request.count != 0 && taken == request.count) {
+		capturing = false;
+	}
+
+	semWake.release();
+}
+
+bool RecBurst::writeShot(const Ring::Entry &aEntry, const std::uint8_t *aData)
+{
+	static constexpr std::size_t kMaxFilePathLength = 64;
+	char filePath[kMaxFilePathLength];
+	snprintf(filePath, sizeof(filePath), "%s/%u.jpg", CONFIG_SD_FAT_MOUNT_POINT,
+		request.firstName + aEntry.meta.index);
+	const auto startedUs = Ut::bootTimeUs();
+
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onCreated(filePath);
+	}
+
+	FILE *file = fopen(filePath, "wb");
+
+	if (file == nullptr) {
+		ESP_LOGW(kTag, "unable to open the file %s", filePath);
+
+		if (Catalog::checkInstance()) {
+			Catalog::getInstance().invalidate();
+		}
+
+		return false;
+	}
+
+	const bool ok = fwrite(aData, 1, aEntry.size, file) == aEntry.size;
+	const long fileSize = ftell(file);
+	fclose(file);
+
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onClosed(filePath, fileSize > 0 ? static_cast<std::uint32_t>(fileSize) : 0);
+	}
+
+	if (latency != nullptr) {
+		latency->captureToConsume.record(clampUs(startedUs - aEntry.meta.captureTimeUs));
+		latency->consumeDuration.record(clampUs(Ut::bootTimeUs() - startedUs));
+	}
+
+	ESP_LOGD(kTag, "shot %u, %s, %u KiB, late by %lld ms, written in %lld ms", aEntry.meta.index, filePath,
+		static_cast<unsigned>(aEntry.size / 1024),
+		static_cast<long long>((aEntry.meta.captureTimeUs - aEntry.meta.scheduledUs) / 1000),
+		static_cast<long long>((Ut::bootTimeUs() - startedUs) / 1000));
+
+	return ok;
+}
+
+void RecBurst::reportShot(unsigned aIndex, bool aOk, std::int64_t aScheduledUs, std::int64_t aCaptureTimeUs)
+{
+	++reported;
+
+	if (request.onShot) {
+		request.onShot(Shot{aIndex, request.firstName + aIndex, aOk, aScheduledUs, aCaptureTimeUs,
+			Ut::bootTimeUs()});
+	}
+}
+
+/// \brief Restores the frame size, and releases the buffer
+void RecBurst::finish()
+{
+	key.setEnabled(false);
+
+	while (reported < taken) {
+		reportShot(reported, false, 0, 0);
+	}
+
+	ESP_LOGI(kTag, "finished, shots: %u, restoring frame size %dx%d", taken, frameSizePrev.first,
+		frameSizePrev.second);
+	RecFrame::writeFrameSize(frameSizePrev);
+	std::lock_guard<std::mutex> lock{mutex};
+	ring.assign(nullptr, 0);
+	heap_caps_free(arena);
+	arena = nullptr;
+	arenaSize = 0;
+	request.onShot = nullptr;
+	active = false;
+}
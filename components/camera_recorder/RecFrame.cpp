@@ -10,6 +10,8 @@
 // https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
 #define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
 
+#include "camera_recorder/Catalog.hpp"
+#include "camera_recorder/RecBurst.hpp"
 #include "camera_recorder/RecFrame.hpp"
 #include "camera_recorder/camera_recorder.hpp"
 #include "module/ModuleBase.hpp"
@@ -20,12 +22,28 @@ static constexpr const char *kTag = "[camera_recorder: frame]";
 
 using namespace CameraRecorder;
 
+RecFrame::RecFrame():
+	key{&RecFrame::onNewFrame, this},
+	file{nullptr},
+	fileSize{0},
+	latency{Cam::Latency::registerConsumer("RecFrame")}
+{
+	key.setEnabled(false);
+}
+
+RecFrame::~RecFrame()
+{
+	key.setEnabled(false);
+}
+
 void RecFrame::onNewFrame(Sub::Key::NewFrameEvent frame)
 {
 	std::lock_guard<std::mutex> lock(sync.mut);
+	Cam::LatencyProbe latencyProbe{latency, *frame};
 
 	if (file) {
 		fwrite(frame->data(), 1, frame->size(), file);
+		fileSize = ftell(file);
 		fclose(file);
 		file = nullptr;
 	}
@@ -55,15 +73,17 @@ bool RecFrame::start(const char *aFilename)
 		return false;
 	}
 
+	if (RecBurst::checkInstance() && RecBurst::getInstance().isActive()) {
+		ESP_LOGW(kTag, "start -- fail (a burst is ongoing)");
+
+		return false;
+	}
+
 	// Save frame in a higher resolution.
 	// Save the currently used camera resolution
-	constexpr int kUninitialized = 0;
-	constexpr std::pair<int, int> kFrameSizePhoto{800, 600};  // TODO: rewrite w/ parameters
-	std::pair<int, int> frameSizePrev{kUninitialized, kUninitialized};
-	Mod::ModuleBase::moduleFieldReadIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(
-		[&frameSizePrev](std::pair<int, int> aFrameSize) {frameSizePrev = aFrameSize; });
+	std::pair<int, int> frameSizePrev{};
 
-	if (frameSizePrev.first == 0) {  // The camera module has not produced a response
+	if (!readFrameSize(frameSizePrev)) {
 		ESP_LOGW(kTag, "start -- fail (camera's current frame size acquisition)");
 
 		return false;
@@ -72,35 +92,29 @@ bool RecFrame::start(const char *aFilename)
 	// Open the file to save the frame into
 	{
 		std::lock_guard<std::mutex> lock(sync.mut);
+
+		if (Catalog::checkInstance()) {
+			Catalog::getInstance().onCreated(filePath);
+		}
+
 		file = fopen(filePath, "wb");
 		ESP_LOGD(kDebugTag, "start. opening file \"%s\"", filePath);
 
 		if (!file) {
 			ESP_LOGW(kDebugTag, "start. Photo -- unable to open the file %s. Capture is aborted", filePath);
 
+			if (Catalog::checkInstance()) {
+				Catalog::getInstance().invalidate();
+			}
+
 			return false;
 		}
+
+		fileSize = 0;
 	}
 	// Switch the camera to a higher resolution
-	{
-		ESP_LOGD(kDebugTag, "start. Initializing frame size %dx%d", kFrameSizePhoto.first, kFrameSizePhoto.second);
-		bool frameSizeSetIsOk = false;
-		Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(
-			kFrameSizePhoto,
-			[&frameSizeSetIsOk](Mod::Fld::WriteResp aWriteResp)
-			{
-				frameSizeSetIsOk = aWriteResp.isOk();
-
-				if (!aWriteResp.isOk()) {
-					ESP_LOGW(kTag, "start -- fail (frame size setting)");
-				}
-			});
-
-		if (!frameSizeSetIsOk) {
-			ESP_LOGW(kDebugTag, "start. Frame size initialization failed");
-			return false;
-		}
-		ESP_LOGI(kDebugTag, "start. Switched frame size to %dx%d", kFrameSizePhoto.first, kFrameSizePhoto.second);
+	if (!writeFrameSize(photoFrameSize())) {
+		return false;
 	}
 	// First try to acquire an image from the frame stream
 	ESP_LOGD(kDebugTag, "start. Enabling frame subcription, acquiring a frame");
@@ -118,10 +132,15 @@ bool RecFrame::start(const char *aFilename)
 		if (frame && frame->valid() && fwrite(frame->data(), 1, frame->size(), file) == frame->size()) {
 			ret = true;
 		}
+		fileSize = ftell(file);
 		fclose(file);
 		file = nullptr;
 	}
 
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onClosed(filePath, fileSize > 0 ? static_cast<std::uint32_t>(fileSize) : 0);
+	}
+
 	if (ret) {
 		ESP_LOGI(kTag, "Photo -- successfully wrote frame file %s", filePath);
 	} else {
@@ -130,12 +149,47 @@ bool RecFrame::start(const char *aFilename)
 
 	// Restore previous frame size
 	ESP_LOGI(kDebugTag, "start. restoring previous frame size %dx%d", frameSizePrev.first, frameSizePrev.second);
-	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(
-		frameSizePrev, [](Mod::Fld::WriteResp){});
+	writeFrameSize(frameSizePrev);
 
 	return ret;
 }
 
+std::pair<int, int> RecFrame::photoFrameSize()
+{
+	return {800, 600};  // TODO: rewrite w/ parameters
+}
+
+bool RecFrame::readFrameSize(std::pair<int, int> &aFrameSize)
+{
+	constexpr int kUninitialized = 0;
+	aFrameSize = {kUninitialized, kUninitialized};
+	Mod::ModuleBase::moduleFieldReadIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(
+		[&aFrameSize](std::pair<int, int> aValue) {aFrameSize = aValue; });
+
+	return aFrameSize.first != kUninitialized;  // The camera module has produced a response
+}
+
+bool RecFrame::writeFrameSize(std::pair<int, int> aFrameSize)
+{
+	ESP_LOGD(kDebugTag, "Initializing frame size %dx%d", aFrameSize.first, aFrameSize.second);
+	bool frameSizeSetIsOk = false;
+	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(aFrameSize,
+		[&frameSizeSetIsOk](Mod::Fld::WriteResp aWriteResp)
+		{
+			frameSizeSetIsOk = aWriteResp.isOk();
+
+			if (!aWriteResp.isOk()) {
+				ESP_LOGW(kTag, "frame size setting -- fail");
+			}
+		});
+
+	if (frameSizeSetIsOk) {
+		ESP_LOGI(kDebugTag, "Switched frame size to %dx%d", aFrameSize.first, aFrameSize.second);
+	}
+
+	return frameSizeSetIsOk;
+}
+
 void RecFrame::stop()
 {
 }
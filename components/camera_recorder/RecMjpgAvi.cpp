@@ -5,14 +5,27 @@
 //     Author: Dmitry Murashov (d.murashov@geoscan.aero)
 //
 
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include "camera_recorder/Catalog.hpp"
 #include "camera_recorder/RecMjpgAvi.hpp"
 #include "utility/time.hpp"
+#include <cstdio>
+#include <cstring>
 #include <sdkconfig.h>
+#include <strings.h>
+#include <sys/stat.h>
 
 using namespace CameraRecorder;
 
 static constexpr const char *kTag = "[camera_recorder: mjpeg/avi]";
+static constexpr const char *kExtension = ".avi";
+static constexpr long kChunkOverhead = 8 + 1 + 16;  ///< Chunk header, padding, index entry
+static constexpr long kSegmentMaxSize = CONFIG_CAMERA_RECORDER_SEGMENT_SIZE_MB * 1024L * 1024L;
+static_assert(kSegmentMaxSize < AVI_MAX_LEN, "A segment must fit in an AVI file");
+static constexpr std::int64_t kCheckpointIntervalUs =
+	static_cast<std::int64_t>(CONFIG_CAMERA_RECORDER_CHECKPOINT_INTERVAL_S) * 1000000;
+static constexpr double kRecoveryFps = 25.0;  ///< Nominal, for the files w/o a single checkpoint
 
 void RecMjpgAvi::logWriting(Sub::Key::NewFrameEvent frame)
 {
@@ -23,25 +36,85 @@ void RecMjpgAvi::logWriting(Sub::Key::NewFrameEvent frame)
 		iter = 0;
 		ESP_LOGI(kTag, "Record -- writing frame, %dx%d, %dkb",
 			frame->width(), frame->height(), frame->size() / 1024);
+		logStats();
 	}
 }
 
+/// \brief Queue depth and frames dropped by the writer, and how the SD card has been written to
+void RecMjpgAvi::logStats()
+{
+	const auto stats = frameConsumer.stats();
+	ESP_LOGI(kTag, "Record -- frames written %u, queued %u, dropped %u, writes %ld (unaligned %ld)",
+		static_cast<unsigned>(stats.consumed), static_cast<unsigned>(stats.lag), static_cast<unsigned>(stats.dropped),
+		rec.current.fd ? rec.current.fd->n_writes : 0L, rec.current.fd ? rec.current.fd->n_unaligned_writes : 0L);
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	const auto preRollStats = preRoll.stats();
+	ESP_LOGI(kTag, "Record -- pre-roll: frames %u, %u of %u KiB, pushed %u, evicted %u, oversize %u",
+		static_cast<unsigned>(preRollStats.frames), static_cast<unsigned>(preRollStats.usedBytes / 1024),
+		static_cast<unsigned>(preRollStats.capacityBytes / 1024), static_cast<unsigned>(preRollStats.pushed),
+		static_cast<unsigned>(preRollStats.evicted), static_cast<unsigned>(preRollStats.oversize));
+#endif
+}
+
 bool RecMjpgAvi::startWrap(const char *filename)
 {
 	std::string name;
-	name.reserve(strlen(CONFIG_SD_FAT_MOUNT_POINT) + strlen(filename) + strlen(".avi") + 1);
+	name.reserve(strlen(CONFIG_SD_FAT_MOUNT_POINT) + strlen(filename) + strlen(kExtension) + 1);
 	name.append(CONFIG_SD_FAT_MOUNT_POINT);
 	name.append("/");
 	name.append(filename);
-	name.append(".avi");
+	name.append(kExtension);
 
 	return start(name.c_str());
 }
 
+// ------------ Segment ------------ //
+
+float RecMjpgAvi::Segment::fps() const
+{
+	if (frames < 2 || lastFrameUs <= firstFrameUs) {
+		return 0.0f;
+	}
+
+	return static_cast<float>(frames - 1) * 1e6f / static_cast<float>(lastFrameUs - firstFrameUs);
+}
+
+// ------------ SegmentWorker ------------ //
+
+RecMjpgAvi::SegmentWorker::SegmentWorker(RecMjpgAvi &aOwner) :
+	Ut::Thr::FreertosTask{"RecMjpgAviSeg", CONFIG_CAM_FRAME_CONSUMER_STACK_SIZE, CONFIG_CAM_FRAME_CONSUMER_PRIORITY},
+	owner{aOwner},
+	semWake{}
+{
+}
+
+void RecMjpgAvi::SegmentWorker::run()
+{
+	while (true) {
+		semWake.acquire();
+		owner.serveSegments();
+	}
+}
+
+void RecMjpgAvi::SegmentWorker::wake()
+{
+	semWake.release();
+}
+
+// ------------ RecMjpgAvi ------------ //
+
 RecMjpgAvi::RecMjpgAvi() :
 	Mod::ModuleBase(Mod::Module::Camera),
-	sub{{&RecMjpgAvi::startWrap, this}, {&RecMjpgAvi::stop, this}}
+	rec{},
+	sub{{&RecMjpgAvi::startWrap, this}, {&RecMjpgAvi::stop, this}},
+	frameConsumer{"RecMjpgAvi", &RecMjpgAvi::onNewFrame, this},
+	writeBuffer{nullptr},
+	segmentWorker{*this},
+	segmentWorkerStarted{false}
 {
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	preRoll.arm();
+#endif
 	ESP_LOGI(kTag, "RecMjpgAvi initialized");
 }
 
@@ -50,7 +123,7 @@ void RecMjpgAvi::getFieldValue(Mod::Fld::Req aReq, Mod::Fld::OnResponseCallback
 	switch (aReq.field) {
 		case Mod::Fld::Field::Recording:
 			aOnResponse(makeResponse<Mod::Module::Camera, Mod::Fld::Field::Recording>(
-				nullptr != stat.fd));
+				nullptr != rec.current.fd));
 
 			break;
 
@@ -59,39 +132,213 @@ void RecMjpgAvi::getFieldValue(Mod::Fld::Req aReq, Mod::Fld::OnResponseCallback
 	}
 }
 
-void RecMjpgAvi::updateFps()
+std::string RecMjpgAvi::segmentPath(unsigned aIndex) const
 {
-	if (stat.frames < kFrameRegCount) {
-		++stat.frames;
-	} else if (stat.frames == kFrameRegCount) {
-		calculateFps();
-		++stat.frames;
+	if (aIndex == 0) {
+		return rec.basename + kExtension;
 	}
+
+	char suffix[16];
+	snprintf(suffix, sizeof(suffix), "_%u%s", aIndex, kExtension);
+
+	return rec.basename + suffix;
 }
 
-void RecMjpgAvi::calculateFps()
+/// \brief Opens the segment's file. The write buffer is attached on rollover, the header goes straight to the file
+bool RecMjpgAvi::openSegment(Segment &aSegment, unsigned aIndex)
 {
-	if (std::isnan(stat.fps)) {
-		float frames = static_cast<float>(stat.frames);
-		std::chrono::duration<float> duration = std::chrono::microseconds(Ut::bootTimeUs()) - stat.started;
-		stat.fps = frames / duration.count();
+	const auto path = segmentPath(aIndex);
+	aSegment = Segment{};
+	aSegment.index = aIndex;
+
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onCreated(path.c_str());
 	}
+
+	aSegment.fd = AVI_open_output_file_buffered(const_cast<char *>(path.c_str()), nullptr,
+		writeBuffer != nullptr ? CONFIG_CAMERA_RECORDER_AVI_WRITE_BUFFER_SIZE : 0);
+
+	if (aSegment.fd == nullptr) {
+		ESP_LOGE(kTag, "Record -- unable to open output file %s (%s)", path.c_str(), AVI_strerror());
+
+		if (Catalog::checkInstance()) {
+			Catalog::getInstance().invalidate();
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+/// \brief Writes the header and the index, the write buffer's tail gets flushed on close
+void RecMjpgAvi::closeSegment(Segment &aSegment)
+{
+	const float fps = aSegment.fps();
+	const long size = AVI_MAX_LEN - AVI_bytes_remain(aSegment.fd);  // The file ends w/ the index
+	AVI_set_video(aSegment.fd, aSegment.width, aSegment.height, fps, const_cast<char *>("MJPG"));
+
+	if (AVI_close(aSegment.fd) != 0) {
+		ESP_LOGW(kTag, "Record -- failed to finalize segment %u (%s)", aSegment.index, AVI_strerror());
+	}
+
+	ESP_LOGI(kTag, "Record -- segment %u closed, frames: %u, frame: %dx%d, fps: %f", aSegment.index,
+		static_cast<unsigned>(aSegment.frames), aSegment.width, aSegment.height, fps);
+
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onClosed(segmentPath(aSegment.index).c_str(), static_cast<std::uint32_t>(size));
+	}
+	aSegment = Segment{};
+}
+
+/// \brief Closes and removes the segment opened ahead of time, but never written to
+void RecMjpgAvi::discardSegment(Segment &aSegment)
+{
+	const auto path = segmentPath(aSegment.index);
+	AVI_close(aSegment.fd);
+	std::remove(path.c_str());
+
+	if (Catalog::checkInstance()) {
+		Catalog::getInstance().onRemoved(path.c_str());
+	}
+	aSegment = Segment{};
+}
+
+/// \brief Worker's job: updates the header, and syncs the file, so the segment is playable up to the latest frame,
+/// should the recording get interrupted. The write buffer's partial block gets written out of order, so it is done
+/// once in a while. The writer only waits for the header update, not for the syncs
+void RecMjpgAvi::checkpoint()
+{
+	const auto startedUs = Ut::bootTimeUs();
+	avi_t *fd = nullptr;
+	unsigned index = 0;
+	std::size_t frames = 0;
+
+	{
+		std::lock_guard<std::mutex> fileLock{fileMutex};
+		auto &segment = rec.current;
+
+		if (!rec.checkpointDue || segment.fd == nullptr) {
+			return;
+		}
+
+		rec.checkpointDue = false;
+		AVI_set_video(segment.fd, segment.width, segment.height, segment.fps(), const_cast<char *>("MJPG"));
+
+		if (AVI_checkpoint_write(segment.fd) == 0) {
+			fd = segment.fd;  // Only the worker closes the segments, so it stays open
+		}
+
+		segment.checkpointUs = segment.lastFrameUs;
+		index = segment.index;
+		frames = segment.frames;
+	}
+
+	if (fd == nullptr || AVI_checkpoint_sync(fd) != 0) {
+		ESP_LOGW(kTag, "Record -- checkpoint of segment %u failed (%s)", index, AVI_strerror());
+	}
+
+	ESP_LOGD(kTag, "Record -- segment %u checkpoint, frames %u, took %lld ms", index, static_cast<unsigned>(frames),
+		static_cast<long long>((Ut::bootTimeUs() - startedUs) / 1000));
+}
+
+bool RecMjpgAvi::isRolloverDue(std::size_t aFrameSize, std::int64_t aCaptureTimeUs) const
+{
+	const auto &segment = rec.current;
+
+	if (segment.frames == 0) {
+		return false;
+	}
+
+#if CONFIG_CAMERA_RECORDER_SEGMENT_DURATION_S
+	if (aCaptureTimeUs - segment.firstFrameUs
+		>= static_cast<std::int64_t>(CONFIG_CAMERA_RECORDER_SEGMENT_DURATION_S) * 1000000)
+	{
+		return true;
+	}
+#else
+	(void)aCaptureTimeUs;
+#endif
+
+	const long used = AVI_MAX_LEN - AVI_bytes_remain(segment.fd);  // Including the index
+
+	return used + static_cast<long>(aFrameSize) + kChunkOverhead > kSegmentMaxSize;
+}
+
+/// \brief Switches the writer to the segment opened ahead of time, and hands the current one over to the worker
+void RecMjpgAvi::rollover()
+{
+	std::lock_guard<std::mutex> lock{handoverMutex};
+
+	if (rec.next.fd == nullptr) {  // Keep writing to the current segment, until the next one is ready
+		if (!rec.rolloverPending) {
+			ESP_LOGW(kTag, "Record -- segment %u is due for rollover, but the next one is not ready",
+				rec.current.index);
+			rec.rolloverPending = true;
+		}
+
+		return;
+	}
+
+	if (writeBuffer != nullptr) {
+		if (AVI_set_output_buffer(rec.current.fd, nullptr) != 0) {
+			ESP_LOGW(kTag, "Record -- failed to flush segment %u (%s)", rec.current.index, AVI_strerror());
+		}
+
+		AVI_set_output_buffer(rec.next.fd, writeBuffer);
+	}
+
+	rec.finished = rec.current;
+	rec.current = rec.next;
+	rec.next = Segment{};
+	rec.rolloverPending = false;
+	segmentWorker.wake();
+}
+
+/// \brief Worker's job: finalizes the segment handed over, opens the next one, and makes the checkpoint requested
+void RecMjpgAvi::serveSegments()
+{
+	std::lock_guard<std::mutex> workerLock{workerMutex};
+	Segment finished{};
+	bool openNext = false;
+
+	{
+		std::lock_guard<std::mutex> lock{handoverMutex};
+		std::swap(finished, rec.finished);
+		openNext = rec.active && rec.next.fd == nullptr;
+	}
+
+	if (finished.fd != nullptr) {
+		closeSegment(finished);
+	}
+
+	if (openNext) {
+		Segment next{};
+
+		if (openSegment(next, rec.segments)) {
+			++rec.segments;
+			std::lock_guard<std::mutex> lock{handoverMutex};
+			rec.next = next;
+		}
+	}
+
+	checkpoint();
 }
 
 void RecMjpgAvi::onNewFrame(Sub::Key::NewFrameEvent aFrame)
 {
 	if (aFrame.get() != nullptr && aFrame->data() != nullptr && aFrame->size()) {
-		static constexpr int kNoAviError = 0;
-		stat.width = aFrame->width();
-		stat.height = aFrame->height();
-		int errorCode = AVI_write_frame(stat.fd, reinterpret_cast<char *>(const_cast<void *>(aFrame->data())), aFrame->size());
-
-		if (errorCode != kNoAviError) {
-			ESP_LOGW(kTag, "Recording -- failed to write a frame, error=%d(%s)", errorCode, AVI_strerror());
-		} else {
-			updateFps();
-			logWriting(aFrame);
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+		if (preRoll.isAvailable()) {  // Delay line: the frame goes in, the oldest one gets written
+			preRoll.push(*aFrame.get());
+			writePreRolled();
+		} else
+#endif
+		{
+			writeFrame(aFrame->data(), aFrame->size(), aFrame->width(), aFrame->height(), aFrame->captureTimeUs());
 		}
+
+		logWriting(aFrame);
 	} else {
 
 		ESP_LOGW(kTag, "Recording -- empty frame");
@@ -99,37 +346,194 @@ void RecMjpgAvi::onNewFrame(Sub::Key::NewFrameEvent aFrame)
 	}
 }
 
+void RecMjpgAvi::writeFrame(const void *aData, std::size_t aSize, int aWidth, int aHeight,
+	std::int64_t aCaptureTimeUs)
+{
+	static constexpr int kNoAviError = 0;
+	std::lock_guard<std::mutex> fileLock{fileMutex};
+
+	if (isRolloverDue(aSize, aCaptureTimeUs)) {
+		rollover();
+	}
+
+	auto &segment = rec.current;
+	int errorCode = AVI_write_frame(segment.fd, static_cast<char *>(const_cast<void *>(aData)), aSize);
+
+	if (errorCode != kNoAviError) {
+		ESP_LOGW(kTag, "Recording -- failed to write a frame, error=%d(%s)", errorCode, AVI_strerror());
+	} else {
+		if (segment.frames++ == 0) {
+			segment.firstFrameUs = aCaptureTimeUs;
+		}
+
+		segment.lastFrameUs = aCaptureTimeUs;
+		segment.width = aWidth;
+		segment.height = aHeight;
+
+		// The first one is made as soon as the frame rate is known, and it leaves the index sidecar behind
+		if (kCheckpointIntervalUs && !rec.checkpointDue
+			&& (segment.frames == 2 || aCaptureTimeUs - segment.checkpointUs >= kCheckpointIntervalUs))
+		{
+			rec.checkpointDue = true;
+			segmentWorker.wake();
+		}
+	}
+}
+
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+/// \brief Writes the oldest frame from the pre-roll ring
+/// \returns false, if the ring is empty
+bool RecMjpgAvi::writePreRolled()
+{
+	return preRoll.popFront([this](const PreRoll::Entry &aEntry, const std::uint8_t *aData) {
+		writeFrame(aData, aEntry.size, aEntry.meta.width, aEntry.meta.height, aEntry.meta.captureTimeUs);
+	});
+}
+#endif
+
 bool RecMjpgAvi::start(const char *aFilename)
 {
+	std::lock_guard<std::mutex> workerLock{workerMutex};
+
 	// Process the "already started" case
-	if (nullptr != stat.fd) {
+	if (nullptr != rec.current.fd) {
 		ESP_LOGW(kTag, "RecMjpgAvi - record has already been started");
 		return false;
 	}
 
-	if ((stat.fd = AVI_open_output_file(const_cast<char *>(aFilename))) != nullptr) {
+#if CONFIG_CAMERA_RECORDER_AVI_WRITE_BUFFER_SIZE
+	writeBuffer = static_cast<char *>(heap_caps_malloc(CONFIG_CAMERA_RECORDER_AVI_WRITE_BUFFER_SIZE,
+		MALLOC_CAP_DMA | MALLOC_CAP_8BIT));
+
+	if (writeBuffer == nullptr) {
+		ESP_LOGW(kTag, "Record -- unable to allocate the write buffer, writes will not be coalesced");
+	}
+#endif
+
+	rec.basename = aFilename;
+
+	if (rec.basename.size() > strlen(kExtension)
+		&& rec.basename.compare(rec.basename.size() - strlen(kExtension), strlen(kExtension), kExtension) == 0)
+	{
+		rec.basename.resize(rec.basename.size() - strlen(kExtension));
+	}
+
+	if (openSegment(rec.current, 0)) {
+		if (writeBuffer != nullptr) {
+			AVI_set_output_buffer(rec.current.fd, writeBuffer);
+		}
+
 		ESP_LOGI(kTag, "Record -- started: %s", aFilename);
-		stat.started = std::chrono::microseconds(Ut::bootTimeUs());
-	    stat.frames  = 0;
-	    stat.fps     = NAN;
-		Record::key.setEnabled(true);
+		rec.segments = 1;
+		rec.rolloverPending = false;
+		rec.checkpointDue = false;
+
+		{
+			std::lock_guard<std::mutex> lock{handoverMutex};
+			rec.active = true;
+		}
+
+		if (!segmentWorkerStarted) {
+			segmentWorkerStarted = true;
+			segmentWorker.start();
+		}
+
+		segmentWorker.wake();  // Open the next segment ahead of time
+		frameConsumer.setEnabled(true);
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+		preRoll.disarm();  // After the recorder has been enabled, so no frame slips through on handover
+#endif
+
 		return true;
 	} else {
 		ESP_LOGE(kTag, "Record - failed. Unable to open output file %s", aFilename);
+		heap_caps_free(writeBuffer);
+		writeBuffer = nullptr;
 	}
 	return false;
 }
 
 void RecMjpgAvi::stop()
 {
-	Record::key.setEnabled(false);
+	frameConsumer.setEnabled(false);
+
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	while (rec.current.fd != nullptr && writePreRolled()) {  // The rest of the delay line
+	}
+#endif
+
+	std::lock_guard<std::mutex> workerLock{workerMutex};  // Wait for the worker to get done w/ the previous segment
+	Segment finished{};
+	Segment next{};
+
+	{
+		std::lock_guard<std::mutex> lock{handoverMutex};
+		rec.active = false;
+		std::swap(finished, rec.finished);
+		std::swap(next, rec.next);
+	}
 
-	calculateFps();
-	if (stat.fd) {
-		AVI_set_video(stat.fd, stat.width, stat.height, stat.fps, const_cast<char *>("MJPG"));
-		AVI_close(stat.fd);
-		ESP_LOGI(kTag, "Record -- stopped, frame: %dx%d, fps: %f", stat.width, stat.height, stat.fps);
+	if (finished.fd != nullptr) {
+		closeSegment(finished);
 	}
 
-	stat.fd = nullptr;
+	if (rec.current.fd != nullptr) {
+		logStats();
+		closeSegment(rec.current);
+		ESP_LOGI(kTag, "Record -- stopped, segments: %u", rec.segments - (next.fd != nullptr ? 1 : 0));
+	}
+
+	if (next.fd != nullptr) {
+		discardSegment(next);
+	}
+
+	heap_caps_free(writeBuffer);  // Only after the files have been closed, as the tail is flushed on close
+	writeBuffer = nullptr;
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	preRoll.arm();
+#endif
+}
+
+void RecMjpgAvi::recover(const char *aPath)
+{
+	{
+		std::lock_guard<std::mutex> workerLock{workerMutex};  // Wait for the worker to get done w/ the segment
+		std::lock_guard<std::mutex> lock{handoverMutex};
+
+		const std::size_t length = rec.basename.size();
+
+		// One of the ongoing recording's segments, "<basename>.avi", or "<basename>_<index>.avi"
+		if (rec.active && strncasecmp(aPath, rec.basename.c_str(), length) == 0
+			&& (aPath[length] == '.' || aPath[length] == '_'))
+		{
+			return;
+		}
+	}
+
+	const auto startedUs = Ut::bootTimeUs();
+	const long frames = AVI_recover(const_cast<char *>(aPath), kRecoveryFps);
+
+	if (frames > 0) {
+		struct stat st{};
+		stat(aPath, &st);
+		ESP_LOGI(kTag, "Recovery -- %s, frames: %ld, took %lld ms", aPath, frames,
+			static_cast<long long>((Ut::bootTimeUs() - startedUs) / 1000));
+
+		if (Catalog::checkInstance()) {
+			Catalog::getInstance().onClosed(aPath, static_cast<std::uint32_t>(st.st_size));
+		}
+	} else if (frames < 0 && (AVI_errno == AVI_ERR_NO_VIDS || AVI_errno == AVI_ERR_NO_MOVI)) {
+		// A segment opened ahead of time, or a recording interrupted before its first frame
+		std::string sidecar{aPath};
+		sidecar.replace(sidecar.rfind('.'), std::string::npos, AVI_INDEX_SIDECAR_SUFFIX);
+		std::remove(aPath);
+		std::remove(sidecar.c_str());
+		ESP_LOGI(kTag, "Recovery -- %s has no frames, removed", aPath);
+
+		if (Catalog::checkInstance()) {
+			Catalog::getInstance().onRemoved(aPath);
+		}
+	} else if (frames < 0) {
+		ESP_LOGW(kTag, "Recovery -- %s failed (%s)", aPath, AVI_strerror());
+	}
 }
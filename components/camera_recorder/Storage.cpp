@@ -11,20 +11,15 @@
 #define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
 #include <esp_log.h>
 
+#include "camera_recorder/Catalog.hpp"
 #include "camera_recorder/Storage.hpp"
 #include "camera_recorder/camera_recorder.hpp"
-#include "utility/al/String.hpp"
 #include "utility/LogSection.hpp"
-#include "sd_fat.h"
-#include <dirent.h>
 #include <sdkconfig.h>
 #include <esp_log.h>
 
 namespace CameraRecorder {
 
-/// \brief Counts frames stored on SD card
-/// \return `ESP_ERR_NOT_FOUND` if no storage is available
-///
 Storage::Storage() : Mod::ModuleBase{Mod::Module::Camera}
 {
 	ESP_LOGI(CameraRecorder::kDebugTag, "initializing Storage");
@@ -49,31 +44,27 @@ void Storage::getFieldValue(Mod::Fld::Req aRequest, Mod::Fld::OnResponseCallback
 	}
 }
 
+/// \brief Counts photos and videos stored on SD card. Answered by `Catalog`, so the card is only scanned once
+/// after it has been mounted
+/// \return `ESP_ERR_NOT_FOUND` if no storage is available
 esp_err_t Storage::countFrames(unsigned &aCountOut)
 {
 	GS_UTILITY_LOG_SECTIONV(CameraRecorder::kDebugTag, "Storage::countFrames");
-	esp_err_t ret = ESP_ERR_NOT_FOUND;
-
-	auto *dp = opendir(CONFIG_SD_FAT_MOUNT_POINT);
-	dirent *ep;
+	Catalog::Summary summary{};
 	aCountOut = 0;
 
-	if (nullptr != dp) {
-		while ((ep = readdir(dp))) {
-			ESP_LOGV(CameraRecorder::kDebugTag, "scanning a directory entry %s", ep->d_name);
+	if (!Catalog::checkInstance()) {
+		return ESP_ERR_NOT_FOUND;
+	}
 
-			aCountOut += Ut::Al::checkEndswith(ep->d_name, ".jpg") +
-				Ut::Al::checkEndswith(ep->d_name, ".jpeg") + Ut::Al::checkEndswith(ep->d_name, ".JPG") +
-				Ut::Al::checkEndswith(ep->d_name, ".JPEG") + Ut::Al::checkEndswith(ep->d_name, ".avi") +
-				Ut::Al::checkEndswith(ep->d_name, ".AVI");
-		}
+	const esp_err_t ret = Catalog::getInstance().summary(summary);
 
-		ret = ESP_OK;
+	if (ret == ESP_OK) {
+		aCountOut = summary.count();
 	} else {
-		ESP_LOGW(CameraRecorder::kDebugTag, "Storage::countFrames unable to open directory");
+		ESP_LOGW(CameraRecorder::kDebugTag, "Storage::countFrames unable to access the storage");
 	}
 
-
 	return ret;
 }
 
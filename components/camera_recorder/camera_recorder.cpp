@@ -10,6 +10,8 @@
 #define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_CAMERA_RECORDER_DEBUG_LEVEL)
 #include <esp_log.h>
 
+#include "camera_recorder/Catalog.hpp"
+#include "camera_recorder/RecBurst.hpp"
 #include "camera_recorder/RecFrame.hpp"
 #include "camera_recorder/RecMjpgAvi.hpp"
 #include "camera_recorder/StopRecordingWifiDisconnectHandler.hpp"
@@ -23,10 +25,14 @@ const char *kDebugTag = "[camera_recorder]";
 void init()
 {
 #ifdef CONFIG_CAMERA_RECORDER_ENABLE
+	static Catalog catalog{};
 	static RecFrame recFrame{};
+	static RecBurst recBurst{};
 	static RecMjpgAvi recMjpgAvi{};
 	static Storage storage{};
 	static StopRecordingWifiDisconnectHandler stopRecordingWifiDisconnectHandler{&recMjpgAvi};
+	(void)catalog;
+	(void)recBurst;
 	(void)storage;
 	esp_log_level_set(CameraRecorder::kDebugTag, (esp_log_level_t)CONFIG_MAV_DEBUG_LEVEL);
 	ESP_LOGD(CameraRecorder::kDebugTag, "Debug log test");
@@ -0,0 +1,134 @@
+//
+// Catalog.hpp
+//
+
+#ifndef CAMERA_RECORDER_CAMERA_RECORDER_CATALOG_HPP
+#define CAMERA_RECORDER_CAMERA_RECORDER_CATALOG_HPP
+
+#include "utility/MakeSingleton.hpp"
+#include <esp_err.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sdkconfig.h>
+
+namespace CameraRecorder {
+
+/// \brief In-RAM catalog of the captures (photos and videos) stored on the SD
+/// card.
+///
+/// \details The catalog is built once, right after the card has been mounted,
+/// or on the first query, and then the recorders keep it up to date as they
+/// create and close files. Queries do not touch the card. Files added or removed by other
+/// means (e.g. FTP) are picked up after `invalidate()`, or a remount.
+///
+/// The scan also spots the recordings which have not been finalized (e.g. on
+/// a power loss), those get recovered in the background. So they are
+/// recovered after each mount, whether the catalog is queried, or not.
+class Catalog : public Ut::MakeSingleton<Catalog> {
+public:
+	static constexpr std::size_t kNameMaxLength = 16;  ///< 8.3 names w/ room to spare
+	static constexpr std::size_t kUnfinishedMax = 4;  ///< A recording leaves up to 3 segments behind
+
+	struct Entry {
+		char name[kNameMaxLength];
+		std::uint32_t size;  ///< 0, while the file is being written
+	};
+
+	struct Summary {
+		unsigned photos;
+		unsigned videos;
+		std::uint64_t bytes;
+
+		unsigned count() const
+		{
+			return photos + videos;
+		}
+	};
+
+	Catalog();
+
+	/// \returns `ESP_ERR_NOT_FOUND`, if no storage is available
+	esp_err_t summary(Summary &aOut);
+
+	/// \brief Invokes `aCallback(const Entry &)` for up to `CONFIG_CAMERA_RECORDER_CATALOG_LATEST` latest captures,
+	/// the newest one first
+	/// \returns `ESP_ERR_NOT_FOUND`, if no storage is available
+	template <class F>
+	esp_err_t forEachLatest(F &&aCallback)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		const esp_err_t err = ensureBuilt();
+
+		for (std::size_t i = latestCount; err == ESP_OK && i > 0; --i) {
+			aCallback(static_cast<const Entry &>(latest[(latestFirst + i - 1) % latest.size()]));
+		}
+
+		return err;
+	}
+
+	/// \brief A file is about to be created, or overwritten. Only photos and videos (.jpg, .jpeg, .avi) are taken
+	/// into account. Call it before opening the file, so an overwritten one is not counted twice. Should the file
+	/// fail to open, `invalidate()` the catalog
+	void onCreated(const char *aPath);
+
+	/// \brief A capture file has been written, and closed
+	void onClosed(const char *aPath, std::uint32_t aSize);
+
+	void onRemoved(const char *aPath);
+
+	/// \brief Makes the catalog get rebuilt on the next query
+	void invalidate();
+
+private:
+	enum class Kind {
+		None,
+		Photo,
+		Video,
+	};
+
+	static Kind kind(const char *aName);
+	static const char *basename(const char *aPath);
+	static void onMounted(void *aInstance);
+	static void onScanned(const char *aName, std::uint32_t aSize, void *aInstance);
+
+	/// \pre The mutex is taken
+	esp_err_t ensureBuilt();
+
+	/// \pre The mutex is taken
+	bool isValid() const;
+
+	/// \brief Counts the file in, and puts it into the "latest" window
+	/// \pre The mutex is taken
+	void add(const char *aName, std::uint32_t aSize);
+
+	/// \brief Puts the file into the "latest" window w/o counting it in, the oldest one drops out, if it is full
+	/// \pre The mutex is taken
+	void addLatest(const char *aName, std::uint32_t aSize);
+
+	/// \pre The mutex is taken
+	Entry *find(const char *aName);
+
+	/// \pre The mutex is taken
+	void addUnfinished(const char *aName, std::uint32_t aSize);
+
+	/// \brief Hands the unfinished recordings over to `RecMjpgAvi::recover` through the work queue
+	/// \pre The mutex is taken
+	void scheduleRecovery();
+
+private:
+	std::mutex mutex;
+	bool built;
+	unsigned generation;  ///< Mount generation the catalog has been built for, see `sdFatGeneration`
+	Summary total;
+	std::array<Entry, CONFIG_CAMERA_RECORDER_CATALOG_LATEST> latest;  ///< Circular, the oldest one goes first
+	std::size_t latestFirst;
+	std::size_t latestCount;
+	std::array<Entry, kUnfinishedMax> unfinished;  ///< Recordings w/ index sidecars left behind, or w/o frames
+	std::size_t unfinishedCount;
+};
+
+}  // namespace CameraRecorder
+
+#endif  // CAMERA_RECORDER_CAMERA_RECORDER_CATALOG_HPP
@@ -0,0 +1,99 @@
+//
+// PreRoll.hpp
+//
+
+#ifndef CAMERA_RECORDER_CAMERA_RECORDER_PREROLL_HPP
+#define CAMERA_RECORDER_CAMERA_RECORDER_PREROLL_HPP
+
+#include "cam/FrameRing.hpp"
+#include "utility/cont/ByteRing.hpp"
+#include <cstdint>
+#include <mutex>
+#include <sdkconfig.h>
+
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+
+namespace CameraRecorder {
+
+/// \brief Keeps the last `CONFIG_CAMERA_RECORDER_PREROLL_S` seconds of
+/// frames in a PSRAM ring, so a recording may begin before it has been
+/// requested.
+///
+/// \details While armed, frames are copied into the ring by a frame consumer
+/// of its own, and the frames older than the pre-roll window get discarded.
+/// While recording, the ring is a delay line which the recorder both feeds
+/// and drains, frame for frame, so the SD card is written at the camera's
+/// rate, rather than the whole pre-roll at once.
+class PreRoll {
+public:
+	struct Meta {
+		std::int64_t captureTimeUs;
+		int width;
+		int height;
+	};
+
+	using Ring = Ut::Cont::ByteRing<Meta, CONFIG_CAMERA_RECORDER_PREROLL_MAX_FRAMES>;
+	using Entry = Ring::Entry;
+
+	struct Stats {
+		std::size_t frames;  ///< Frames in the ring
+		std::size_t usedBytes;
+		std::size_t capacityBytes;  ///< 0, if the ring could not be allocated
+		std::uint32_t pushed;
+		std::uint32_t evicted;  ///< Frames lost before they have been written, as the ring ran out of space
+		std::uint32_t oversize;  ///< Frames larger than the ring
+	};
+
+	PreRoll();
+	~PreRoll();
+
+	/// \brief Starts collecting frames in the background
+	void arm();
+
+	/// \brief Stops collecting frames in the background. The ring is retained, and the recorder takes it over.
+	void disarm();
+
+	/// \brief The ring has been allocated
+	bool isAvailable() const;
+
+	/// \brief Copies the frame into the ring. A frame which is already there (see `disarm`) is skipped.
+	void push(Cam::Frame &);
+
+	/// \brief Invokes `aCallback(const Entry &, const std::uint8_t *data)` for the oldest frame, and discards it
+	/// \returns false, if the ring is empty
+	template <class F>
+	bool popFront(F &&aCallback)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		if (ring.empty()) {
+			return false;
+		}
+
+		aCallback(ring.front(), ring.data(ring.front()));
+		ring.pop_front();
+
+		return true;
+	}
+
+	Stats stats() const;
+
+private:
+	void onNewFrame(const Cam::FramePtr &);
+	void pushImpl(Cam::Frame &, bool aExpire);
+
+private:
+	mutable std::mutex mutex;
+	std::uint8_t *arena;
+	Ring ring;
+	Cam::FrameConsumer frameConsumer;
+	std::int64_t lastCaptureTimeUs;
+	std::uint32_t pushed;
+	std::uint32_t oversize;
+};
+
+}  // namespace CameraRecorder
+
+#endif  // CONFIG_CAMERA_RECORDER_PREROLL_S
+
+#endif  // CAMERA_RECORDER_CAMERA_RECORDER_PREROLL_HPP
@@ -0,0 +1,109 @@
+//
+// RecBurst.hpp
+//
+
+#ifndef CAMERA_RECORDER_CAMERA_RECORDER_RECBURST_HPP
+#define CAMERA_RECORDER_CAMERA_RECORDER_RECBURST_HPP
+
+#include "cam/Latency.hpp"
+#include "sub/Subscription.hpp"
+#include "utility/MakeSingleton.hpp"
+#include "utility/cont/ByteRing.hpp"
+#include "utility/thr/Semaphore.hpp"
+#include "utility/thr/Threading.hpp"
+#include <sdkconfig.h>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace CameraRecorder {
+
+/// \brief Takes a series of photos at a given interval.
+///
+/// \details Unlike `RecFrame`, which switches the camera to the photo
+/// resolution and back for every shot, the resolution is switched once per
+/// burst. Frames due are copied into a ring right in the camera thread,
+/// and they are written to the SD card by a task of its own (write-behind), so
+/// a slow card does not delay the shots that follow. If the ring runs out of
+/// space, the shot is skipped, and reported as failed. The ring is placed in
+/// PSRAM. W/o PSRAM, it is placed in internal RAM, and it is sized to hold at
+/// least two shots, or the burst is not started.
+class RecBurst : public Ut::MakeSingleton<RecBurst>, public Ut::Thr::FreertosTask {
+public:
+	struct Shot {
+		unsigned index;  ///< 0-based, within the burst
+		unsigned name;  ///< Numeric file name, "<name>.jpg"
+		bool ok;
+		std::int64_t scheduledUs;  ///< When the shot was due
+		std::int64_t captureTimeUs;  ///< When the frame has been captured, 0, if there has been none
+		std::int64_t writtenUs;  ///< When the file has been written
+	};
+
+	/// \brief Invoked from the writer's context for each shot, in order
+	using OnShot = std::function<void(const Shot &)>;
+
+	struct Request {
+		unsigned count;  ///< 0 - until `stop()`
+		std::int64_t intervalUs;
+		unsigned firstName;  ///< Shots are named "<firstName + index>.jpg"
+		OnShot onShot;
+	};
+
+	RecBurst();
+	~RecBurst();
+
+	/// \brief Switches the camera to the photo resolution, and starts taking shots. The first one is taken from the
+	/// first frame of the new resolution
+	/// \returns false, if a burst is ongoing, or it could not be started
+	bool start(Request aRequest);
+
+	/// \brief Stops taking shots. The shots taken are written nevertheless, then the resolution is restored
+	void stop();
+
+	bool isActive() const;
+
+	/// \brief Interval of the ongoing burst, 0 if there is none
+	std::int64_t intervalUs() const;
+
+	void run() override;
+
+private:
+	struct Meta {
+		unsigned index;
+		std::int64_t scheduledUs;
+		std::int64_t captureTimeUs;
+	};
+
+	using Ring = Ut::Cont::ByteRing<Meta, CONFIG_CAMERA_RECORDER_BURST_MAX_FRAMES>;
+
+	bool arenaAllocate(std::size_t aSizeMin);
+	void onNewFrame(Sub::Key::NewFrameEvent);
+	void takeShot(Cam::Frame &);
+	bool writeShot(const Ring::Entry &, const std::uint8_t *aData);
+	void reportShot(unsigned aIndex, bool aOk, std::int64_t aScheduledUs, std::int64_t aCaptureTimeUs);
+	void finish();
+
+private:
+	Sub::Key::NewFrame key;
+	mutable std::mutex mutex;  ///< Guards the ring's table, and the state below
+	std::uint8_t *arena;
+	std::size_t arenaSize;
+	Ring ring;
+	Request request;
+	std::pair<int, int> frameSizePrev;
+	bool active;
+	bool capturing;  ///< Shots are being taken, the camera thread feeds the ring
+	unsigned taken;  ///< Shots taken so far
+	unsigned reported;  ///< Shots written, or skipped, and reported
+	std::int64_t nextShotUs;  ///< When the next shot is due, 0 - on the next frame
+	std::int64_t lastFrameUs;  ///< Time of the last frame received, to detect a stalled camera
+	std::int64_t lastStreamUs;  ///< Time of the last frame received from the camera thread
+	Ut::Thr::Semaphore<1, 0> semWake;
+	bool taskStarted;
+	Cam::LatencyStats *latency;  ///< Capture to write, and write duration
+};
+
+}  // namespace CameraRecorder
+
+#endif  // CAMERA_RECORDER_CAMERA_RECORDER_RECBURST_HPP
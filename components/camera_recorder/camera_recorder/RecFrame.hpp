@@ -9,7 +9,9 @@
 #define CAMERA_RECORDER_CAMERA_RECORDER_RECFRAME_HPP
 
 #include <chrono>
+#include <utility>
 #include "Record.hpp"
+#include "cam/Latency.hpp"
 #include "utility/thr/Semaphore.hpp"
 #include "utility/MakeSingleton.hpp"
 
@@ -17,7 +19,11 @@ namespace CameraRecorder {
 
 class RecFrame : public Record, public Ut::MakeSingleton<RecFrame> {
 private:
+	using Key = Sub::Key::NewFrame;
+	Key key;
 	FILE *file;
+	long fileSize;  ///< Bytes written into `file` before it has been closed
+	Cam::LatencyStats *latency;
 	struct {
 		Ut::Thr::Semaphore<1, 0> sem;
 		std::mutex mut;
@@ -26,10 +32,20 @@ protected:
 	void onNewFrame(Sub::Key::NewFrameEvent) override;
 	static constexpr std::chrono::seconds kFrameTimeout{1};
 public:
-	using CameraRecorder::Record::Record;
+	RecFrame();
+	~RecFrame();
 
 	bool start(const char *) override;
 	void stop() override;
+
+	/// \brief Frame size photos are taken in
+	static std::pair<int, int> photoFrameSize();
+
+	/// \returns false, if the camera module has not produced a response
+	static bool readFrameSize(std::pair<int, int> &aFrameSize);
+
+	/// \brief Switches the camera's resolution. Mind that it reinitializes the camera, which takes a while
+	static bool writeFrameSize(std::pair<int, int> aFrameSize);
 };
 
 }  // namespace CameraRecorder
@@ -8,14 +8,17 @@
 #ifndef CAMERA_RECORDER_CAMERA_RECORDER_RECMJPGAVI_H
 #define CAMERA_RECORDER_CAMERA_RECORDER_RECMJPGAVI_H
 
+#include "PreRoll.hpp"
 #include "Record.hpp"
+#include "cam/FrameRing.hpp"
 #include "module/ModuleBase.hpp"
 #include "sub/Cam.hpp"
 #include "utility/MakeSingleton.hpp"
 #include "utility/thr/Semaphore.hpp"
-#include <type_traits>
-#include <chrono>
-#include <cmath>
+#include "utility/thr/Threading.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
 
 extern "C" {
 #include "avilib/avilib.h"
@@ -25,33 +28,95 @@ namespace CameraRecorder {
 
 class RecMjpgAvi : public Record, public Mod::ModuleBase, public Ut::MakeSingleton<RecMjpgAvi> {
 private:
-	static constexpr std::size_t kFrameRegCount = 200;
+	/// \brief A recording is split into segments, each one is a separate AVI file, so it never hits `AVI_MAX_LEN`
+	struct Segment {
+		avi_t *fd = nullptr;
+		unsigned index = 0;  ///< 0 for "<name>.avi", k for "<name>_<k>.avi"
+		std::int64_t firstFrameUs = 0;  ///< Capture time
+		std::int64_t lastFrameUs = 0;
+		std::size_t frames = 0;
+		int width = -1;
+		int height = -1;
+		std::int64_t checkpointUs = 0;  ///< Capture time of the frame the last checkpoint has been made at
+
+		/// \brief Frame rate as per the capture timestamps, 0, if it cannot be inferred
+		float fps() const;
+	};
+
+	/// \brief Finalizes the segments (header, index), and opens the next ones ahead of time, so a rollover only
+	/// takes the writer a pointer swap, and a flush of the write buffer's tail
+	class SegmentWorker : public Ut::Thr::FreertosTask {
+	public:
+		SegmentWorker(RecMjpgAvi &aOwner);
+		void run() override;
+		void wake();
+	private:
+		RecMjpgAvi &owner;
+		Ut::Thr::Semaphore<1, 0> semWake;
+	};
+
 	struct {
-		avi_t *fd;
-		std::chrono::microseconds started;
+		std::string basename;  ///< Path w/o the extension
+		Segment current;  ///< Written by the frame consumer
+		Segment next;  ///< Opened ahead of time, `fd` is nullptr, until it is ready
+		Segment finished;  ///< Waiting to be finalized by the worker
+		unsigned segments;  ///< Segments opened so far
+		bool active;
+		bool rolloverPending;  ///< The rollover is due, but the next segment is not ready yet
+		bool checkpointDue;  ///< Requested by the writer, made by the worker
+	} rec;
 
-		std::size_t frames = 0;
-		int width          = -1;
-		int height         = -1;
-		float fps          = NAN;
-	} stat;
+	std::mutex handoverMutex;  ///< Guards `rec.next`, and `rec.finished`
+	std::mutex workerMutex;  ///< Held by the worker, while it is busy w/ the segments
+	std::mutex fileMutex;  ///< Guards `rec.current`, and `rec.checkpointDue`, taken by the writer for every frame
 
 	struct {
 		Sub::Cam::RecordStart recordStart;
 		Sub::Cam::RecordStop recordStop;
 	} sub;
 
+	/// \brief Writing to the SD card is slow, so frames are received in a separate context. The consumer's ring
+	/// cursor is the writer's bounded queue: if the card stalls, the oldest frames get dropped
+	Cam::FrameConsumer frameConsumer;
+
+	/// \brief Coalesces AVI output into cluster-aligned writes, see `AVI_open_output_file_buffered`. Handed over from
+	/// a segment to the next one on rollover
+	char *writeBuffer;
+
+	SegmentWorker segmentWorker;
+	bool segmentWorkerStarted;
+
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	PreRoll preRoll;  ///< Frames pass through it on the way to the file
+#endif
+
 private:
-	void updateFps();
-	void calculateFps();
 	void onNewFrame(Sub::Key::NewFrameEvent) override;
+	void writeFrame(const void *aData, std::size_t aSize, int aWidth, int aHeight, std::int64_t aCaptureTimeUs);
+#if CONFIG_CAMERA_RECORDER_PREROLL_S
+	bool writePreRolled();
+#endif
 	void logWriting(Sub::Key::NewFrameEvent);
+	void logStats();
 	bool startWrap(const char *filename);
+
+	std::string segmentPath(unsigned aIndex) const;
+	bool openSegment(Segment &, unsigned aIndex);
+	void closeSegment(Segment &);
+	void discardSegment(Segment &);
+	void checkpoint();
+	bool isRolloverDue(std::size_t aFrameSize, std::int64_t aCaptureTimeUs) const;
+	void rollover();
+	void serveSegments();
 public:
 	RecMjpgAvi();
 	void getFieldValue(Mod::Fld::Req, Mod::Fld::OnResponseCallback) override;
 	bool start(const char *filename) override;
 	void stop() override;
+
+	/// \brief Finalizes a recording which has been interrupted (e.g. by a power loss), see `AVI_recover`. Files of
+	/// the ongoing recording are skipped. Takes a while, as the file gets scanned
+	void recover(const char *aPath);
 };
 
 }  // namespace CameraRecorder
@@ -13,16 +13,16 @@
 
 namespace CameraRecorder {
 
+/// \brief Base for recorders. It is up to an inheritor to decide how frames
+/// are delivered to it: synchronously from the camera thread (see
+/// `Sub::Key::NewFrame`), or through the frame ring (see `Cam::FrameConsumer`)
 class Record {
 protected:
-	using Key = Sub::Key::NewFrame;  // Smart pointer to smth. having "data()" and "size()" methods, with automatic deallocation
-	Key key;
 	virtual void onNewFrame(Sub::Key::NewFrameEvent) = 0;
 public:
-	Record();
 	virtual bool start(const char *filename) = 0;
 	virtual void stop() = 0;
-	virtual ~Record();
+	virtual ~Record() = default;
 };
 
 }  // namespace CameraRecorder
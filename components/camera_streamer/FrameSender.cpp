@@ -6,54 +6,264 @@
 //
 
 #include "FrameSender.hpp"
+#include "utility/time.hpp"
 #include <esp_log.h>
+#include <esp_system.h>
+#include <sys/time.h>
+#include <array>
 
 using namespace CameraStreamer;
 
+static constexpr const char *kTag = "[camera_streamer]";
+
 FrameSender::FrameSender(asio::ip::udp::socket &aSocket) :
 	socket(aSocket),
-	key {{&FrameSender::processFrame, this},
-		{&FrameSender::processTcpConnected, this},
-		{&FrameSender::processTcpDisconnected, this}}
+	frameConsumer{"FrameSender", &FrameSender::processFrame, this},
+	key {{&FrameSender::processTcpConnected, this},
+		{&FrameSender::processTcpDisconnected, this}},
+	clients{}
+#if CONFIG_CAMSTREAM_TRANSPORT_FRAGMENTED
+	, fragmenter{CONFIG_CAMSTREAM_FRAGMENT_DATAGRAM_SIZE, CONFIG_CAMSTREAM_FEC_GROUP_SIZE, parity}
+#endif
 {
+	asio::error_code err;
+	socket.non_blocking(true, err);  // A congested client must not stall the others
+
+	if (err) {
+		ESP_LOGW(kTag, "unable to make the socket non-blocking: %s", err.message().c_str());
+	}
 }
 
+/// \brief Sends the frame to each client whose pacer allows it, and drops it for the rest. Frames are not queued, as
+/// a queued frame would hold one of the camera's buffers
 void FrameSender::processFrame(Sub::Key::NewFrameEvent img)
 {
-	asio::error_code err;
+	std::lock_guard<std::mutex> lock{mutex};
+	const auto now = Ut::bootTimeUs();
+
 	for (auto &client : clients) {
 		if (client.enabled) {
-			socket.send_to(asio::const_buffer(img->data(), img->size()), client.endpoint, 0, err);
+			serve(client, *img, now);
 		}
 	}
 }
 
+/// \pre The mutex is taken
+void FrameSender::serve(Client &aClient, const Cam::Frame &aFrame, std::int64_t aNowUs)
+{
+	aClient.pacer.update(aNowUs);
+
+	if (!aClient.pacer.isAvailable()) {
+		++aClient.stats.dropped;
+
+		return;
+	}
+
+	std::size_t sent = 0;
+	const auto err = send(aClient, aFrame, sent);
+	aClient.pacer.consume(sent);  // Only what has made it to the stack, a frame dropped on congestion costs nothing
+
+	if (!err) {
+		++aClient.stats.sent;
+	} else if (err == asio::error::would_block || err == asio::error::no_buffer_space) {
+		// The frame has been sent partially, if at all
+		++aClient.stats.dropped;
+	} else {
+		++aClient.stats.errored;
+		ESP_LOGV(kTag, "send error: %s", err.message().c_str());
+	}
+}
+
+asio::error_code FrameSender::send(Client &aClient, const Cam::Frame &aFrame, std::size_t &aSent)
+{
+#if CONFIG_CAMSTREAM_TRANSPORT_FRAGMENTED
+	return sendFragmented(aClient, aFrame, aSent);
+#elif CONFIG_CAMSTREAM_TRANSPORT_RTP_JPEG
+	return sendRtpJpeg(aClient, aFrame, aSent);
+#else
+	return sendRaw(aClient, aFrame, aSent);
+#endif
+}
+
+asio::error_code FrameSender::sendRaw(Client &aClient, const Cam::Frame &aFrame, std::size_t &aSent)
+{
+	asio::error_code err;
+	aSent += socket.send_to(asio::const_buffer(aFrame.data(), aFrame.size()), aClient.endpoint, 0, err);
+
+	return err;
+}
+
+#if CONFIG_CAMSTREAM_TRANSPORT_FRAGMENTED
+/// \brief Sends the frame fragment-by-fragment. The header and the payload are passed to the stack as a gather list,
+/// so the frame's buffer gets referenced rather than copied.
+asio::error_code FrameSender::sendFragmented(Client &aClient, const Cam::Frame &aFrame, std::size_t &aSent)
+{
+	asio::error_code err;
+	const bool split = fragmenter.forEachFragment(aFrame.sequence(), aFrame.captureTimeUs(),
+		static_cast<const std::uint8_t *>(aFrame.data()), aFrame.size(),
+		[this, &aClient, &err, &aSent](const Proto::FragmentHeader &, const std::uint8_t *aHeader, const std::uint8_t *aPayload,
+			std::size_t aPayloadSize)
+		{
+			if (err) {  // The rest of the frame is of no use
+				return;
+			}
+
+			const std::array<asio::const_buffer, 2> buffers{{
+				asio::const_buffer{aHeader, Proto::FragmentHeader::kSize},
+				asio::const_buffer{aPayload, aPayloadSize}}};
+			aSent += socket.send_to(buffers, aClient.endpoint, 0, err);
+		});
+
+	if (!split) {
+		ESP_LOGW(kTag, "unable to split frame #%u of %u bytes", static_cast<unsigned>(aFrame.sequence()),
+			static_cast<unsigned>(aFrame.size()));
+		err = asio::error::message_size;
+	}
+
+	return err;
+}
+#endif
+
+#if CONFIG_CAMSTREAM_TRANSPORT_RTP_JPEG
+/// \brief Sends the frame as RTP/JPEG packets. Same as w/ the fragmented transport, the scan data is referenced rather
+/// than copied.
+asio::error_code FrameSender::sendRtpJpeg(Client &aClient, const Cam::Frame &aFrame, std::size_t &aSent)
+{
+	asio::error_code err;
+	const bool split = aClient.rtpJpeg.forEachPacket(aFrame.captureTimeUs(),
+		static_cast<const std::uint8_t *>(aFrame.data()), aFrame.size(),
+		[this, &aClient, &err, &aSent](const std::uint8_t *aHeader, std::size_t aHeaderSize, const std::uint8_t *aPayload,
+			std::size_t aPayloadSize)
+		{
+			if (err) {
+				return;
+			}
+
+			const std::array<asio::const_buffer, 2> buffers{{
+				asio::const_buffer{aHeader, aHeaderSize},
+				asio::const_buffer{aPayload, aPayloadSize}}};
+			aSent += socket.send_to(buffers, aClient.endpoint, 0, err);
+		});
+
+	if (!split) {
+		ESP_LOGW(kTag, "frame #%u is not a baseline JPEG RTP/JPEG can carry",
+			static_cast<unsigned>(aFrame.sequence()));
+		err = asio::error::invalid_argument;
+	}
+
+	if (Ut::bootTimeUs() - aClient.lastSenderReportUs >= CONFIG_CAMSTREAM_RTCP_INTERVAL_MS * 1000LL) {
+		sendSenderReport(aClient);
+	}
+
+	return err;
+}
+
+/// \brief Sends RTCP SR to the port next to the client's RTP port, as RFC 3550 suggests
+void FrameSender::sendSenderReport(Client &aClient)
+{
+	std::array<std::uint8_t, Proto::RtpJpegPacketizer::kSenderReportMaxSize> report;
+	timeval wallClock;
+	gettimeofday(&wallClock, nullptr);  // Only has to be monotonic, if SNTP is not used
+	aClient.lastSenderReportUs = Ut::bootTimeUs();
+	const std::size_t size = aClient.rtpJpeg.packSenderReport(report.data(),
+		Proto::RtpJpegPacketizer::toNtpTimestamp(static_cast<std::int64_t>(wallClock.tv_sec) * 1000000
+		+ wallClock.tv_usec), Proto::RtpJpegPacketizer::toRtpTimestamp(aClient.lastSenderReportUs));
+	asio::error_code err;
+	socket.send_to(asio::const_buffer{report.data(), size}, asio::ip::udp::endpoint{aClient.endpoint.address(),
+		static_cast<unsigned short>(aClient.endpoint.port() + 1)}, 0, err);
+}
+#endif
+
 void FrameSender::processTcpConnected(asio::ip::address addr, unsigned short port)
 {
 	{
 		auto ip = addr.to_string();
-		ESP_LOGI("[camera_streamer]", "stream start, client %s:%d", ip.c_str(), port);
+		ESP_LOGI(kTag, "stream start, client %s:%d", ip.c_str(), port);
 	}
 	asio::ip::udp::endpoint endpoint{addr, port};
-	for (auto &client : clients) {
-		if (client.endpoint == endpoint) {
-			client.endpoint.port(port);
-			client.enabled = true;
+	bool enabled = false;
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		Client *vacant = nullptr;
+
+		for (auto &client : clients) {
+			if (client.enabled && client.endpoint == endpoint) {
+				return;
+			} else if (!client.enabled && vacant == nullptr) {
+				vacant = &client;
+			}
+		}
+
+		if (vacant == nullptr) {
+			ESP_LOGW(kTag, "too many clients (see CONFIG_CAMSTREAM_MAX_CLIENTS), ignoring");
+
 			return;
 		}
+
+		reset(*vacant, endpoint);
+		enabled = isAnyEnabled();
 	}
-	clients.emplace_front(Client{endpoint, true});
+
+	frameConsumer.setEnabled(enabled);  // The consumer's lock is taken before ours in `processFrame`
 }
 
 void FrameSender::processTcpDisconnected(asio::ip::address addr)
 {
 	{
 		auto ip = addr.to_string();
-		ESP_LOGI("[camera_streamer]", "stream stop, client %s", ip.c_str());
+		ESP_LOGI(kTag, "stream stop, client %s", ip.c_str());
 	}
-	for (auto &client : clients) {
-		if (client.endpoint.address() == addr) {
-			client.enabled = false;
+	bool enabled = false;
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		for (auto &client : clients) {
+			if (client.enabled && client.endpoint.address() == addr) {
+				release(client);
+			}
 		}
+
+		enabled = isAnyEnabled();
+	}
+
+	frameConsumer.setEnabled(enabled);
+}
+
+/// \pre The mutex is taken
+void FrameSender::reset(Client &aClient, const asio::ip::udp::endpoint &aEndpoint)
+{
+	aClient.endpoint = aEndpoint;
+	aClient.enabled = true;
+	aClient.pacer = Ut::Al::TokenBucket{CONFIG_CAMSTREAM_CLIENT_RATE_KBPS * 1024,
+		CONFIG_CAMSTREAM_CLIENT_BURST_KB * 1024};
+	aClient.stats = decltype(aClient.stats){};
+#if CONFIG_CAMSTREAM_TRANSPORT_RTP_JPEG
+	aClient.rtpJpeg = Proto::RtpJpegPacketizer{CONFIG_CAMSTREAM_FRAGMENT_DATAGRAM_SIZE, esp_random()};
+	aClient.lastSenderReportUs = 0;
+#endif
+}
+
+/// \pre The mutex is taken
+void FrameSender::release(Client &aClient)
+{
+	ESP_LOGI(kTag, "client %s:%d, frames sent %u, dropped %u, errored %u",
+		aClient.endpoint.address().to_string().c_str(), aClient.endpoint.port(), aClient.stats.sent,
+		aClient.stats.dropped, aClient.stats.errored);
+	aClient.enabled = false;
+}
+
+/// \brief Only receive frames, when there is someone to send them to. The consumer must be toggled w/o the mutex
+/// taken
+/// \pre The mutex is taken
+bool FrameSender::isAnyEnabled() const
+{
+	bool enabled = false;
+
+	for (auto &client : clients) {
+		enabled = enabled || client.enabled;
 	}
+
+	return enabled;
 }
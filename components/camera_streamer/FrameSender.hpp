@@ -8,30 +8,70 @@
 #ifndef CAMERA_STREAMER_FRAMESENDER_HPP
 #define CAMERA_STREAMER_FRAMESENDER_HPP
 
-#include <forward_list>
 #include "Ov2640.hpp"
+#include "cam/FrameRing.hpp"
 #include "sub/Subscription.hpp"
+#include "proto/Fragment.hpp"
+#include "proto/RtpJpeg.hpp"
+#include "utility/al/TokenBucket.hpp"
+#include <array>
+#include <mutex>
+#include <sdkconfig.h>
 
 namespace CameraStreamer {
 
+/// \brief Sends frames to the clients. Each client is served independently:
+/// it has its own pacer, and the socket is non-blocking, so a client on a
+/// congested link skips frames rather than delays the others.
 class FrameSender {
 public:
 	FrameSender(asio::ip::udp::socket &);
 	void processFrame(Sub::Key::NewFrameEvent);
 	void processTcpConnected(asio::ip::address, unsigned short);
 	void processTcpDisconnected(asio::ip::address);
+private:
+	struct Client {
+		asio::ip::udp::endpoint endpoint;
+		bool enabled = false;  ///< The slot is free, if disabled
+		Ut::Al::TokenBucket pacer;
+		struct {
+			unsigned sent;
+			unsigned dropped;  ///< Not allowed by the pacer, or lost to congestion
+			unsigned errored;
+		} stats;
+#if CONFIG_CAMSTREAM_TRANSPORT_RTP_JPEG
+		Proto::RtpJpegPacketizer rtpJpeg{CONFIG_CAMSTREAM_FRAGMENT_DATAGRAM_SIZE, 0};  ///< Each client is a separate RTP session
+		std::int64_t lastSenderReportUs;
+#endif
+	};
+
+	bool isAnyEnabled() const;
+	void reset(Client &, const asio::ip::udp::endpoint &);
+	void release(Client &);
+	void serve(Client &, const Cam::Frame &, std::int64_t aNowUs);
+	/// \param aSent - incremented by the number of bytes handed over to the stack, the headers included
+	asio::error_code send(Client &, const Cam::Frame &, std::size_t &aSent);
+	asio::error_code sendRaw(Client &, const Cam::Frame &, std::size_t &aSent);
+#if CONFIG_CAMSTREAM_TRANSPORT_FRAGMENTED
+	asio::error_code sendFragmented(Client &, const Cam::Frame &, std::size_t &aSent);
+#endif
+#if CONFIG_CAMSTREAM_TRANSPORT_RTP_JPEG
+	asio::error_code sendRtpJpeg(Client &, const Cam::Frame &, std::size_t &aSent);
+	void sendSenderReport(Client &);
+#endif
 private:
 	asio::ip::udp::socket &socket;
+	Cam::FrameConsumer frameConsumer;  ///< Sending to every client takes a while, so it is performed in a separate context
 	struct {
-		Sub::Key::NewFrame        newFrame;
 		Sub::Key::TcpConnected    tcpConnected;
 		Sub::Key::TcpDisconnected tcpDisconnected;
 	} key;
-	struct Client {
-		asio::ip::udp::endpoint endpoint;
-		bool enabled;
-	};
-	std::forward_list<Client> clients;
+	std::array<Client, CONFIG_CAMSTREAM_MAX_CLIENTS> clients;
+	std::mutex mutex;  ///< Clients are (dis)connected from the TCP control thread
+#if CONFIG_CAMSTREAM_TRANSPORT_FRAGMENTED
+	alignas(sizeof(std::size_t)) std::uint8_t parity[CONFIG_CAMSTREAM_FRAGMENT_DATAGRAM_SIZE];  ///< FEC parity of the current group
+	Proto::Fragmenter fragmenter;
+#endif
 };
 
 }  // namespace CameraStreamer
@@ -0,0 +1,43 @@
+//
+// Endian.hpp
+//
+// Big-endian (network order) serialization helpers shared by the protocols.
+//
+
+#ifndef CAMERA_STREAMER_PROTO_ENDIAN_HPP
+#define CAMERA_STREAMER_PROTO_ENDIAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CameraStreamer {
+namespace Proto {
+
+/// \returns pointer past the packed value
+template <class T>
+inline std::uint8_t *packBigEndian(std::uint8_t *aOut, T aValue)
+{
+	for (std::size_t i = 0; i < sizeof(T); ++i) {
+		aOut[i] = static_cast<std::uint8_t>(aValue >> (8 * (sizeof(T) - 1 - i)));
+	}
+
+	return aOut + sizeof(T);
+}
+
+/// \returns pointer past the unpacked value
+template <class T>
+inline const std::uint8_t *unpackBigEndian(const std::uint8_t *aIn, T &aValue)
+{
+	aValue = 0;
+
+	for (std::size_t i = 0; i < sizeof(T); ++i) {
+		aValue = static_cast<T>((aValue << 8) | aIn[i]);
+	}
+
+	return aIn + sizeof(T);
+}
+
+}  // namespace Proto
+}  // namespace CameraStreamer
+
+#endif  // CAMERA_STREAMER_PROTO_ENDIAN_HPP
@@ -0,0 +1,56 @@
+//
+// Fec.cpp
+//
+
+#include "proto/Fec.hpp"
+
+namespace CameraStreamer {
+namespace Proto {
+
+/// \brief Word type which may alias any other type, so the byte buffers can be
+/// accessed word-wise
+typedef std::size_t __attribute__((__may_alias__)) Word;
+
+void xorInto(std::uint8_t *aDst, const std::uint8_t *aSrc, std::size_t aSize)
+{
+	static constexpr std::size_t kAlignmentMask = sizeof(Word) - 1;
+
+	if (((reinterpret_cast<std::uintptr_t>(aDst) | reinterpret_cast<std::uintptr_t>(aSrc)) & kAlignmentMask) == 0) {
+		auto *dst = reinterpret_cast<Word *>(aDst);
+		const auto *src = reinterpret_cast<const Word *>(aSrc);
+		std::size_t nWords = aSize / sizeof(Word);
+
+		// Unrolled, so loads of the next words are issued while the previous ones are being processed
+		for (; nWords >= 4; nWords -= 4, dst += 4, src += 4) {
+			const Word w0 = src[0];
+			const Word w1 = src[1];
+			const Word w2 = src[2];
+			const Word w3 = src[3];
+			dst[0] ^= w0;
+			dst[1] ^= w1;
+			dst[2] ^= w2;
+			dst[3] ^= w3;
+		}
+
+		for (; nWords > 0; --nWords, ++dst, ++src) {
+			*dst ^= *src;
+		}
+
+		const std::size_t processed = aSize & ~kAlignmentMask;
+		aDst += processed;
+		aSrc += processed;
+		aSize -= processed;
+	}
+
+	xorIntoBytewise(aDst, aSrc, aSize);
+}
+
+void xorIntoBytewise(std::uint8_t *aDst, const std::uint8_t *aSrc, std::size_t aSize)
+{
+	for (std::size_t i = 0; i < aSize; ++i) {
+		aDst[i] ^= aSrc[i];
+	}
+}
+
+}  // namespace Proto
+}  // namespace CameraStreamer
@@ -0,0 +1,29 @@
+//
+// Fec.hpp
+//
+// XOR forward error correction for the fragmented transport. A parity
+// fragment is sent after each group of N data fragments, so any single
+// fragment lost within a group can be restored by the receiver.
+//
+
+#ifndef CAMERA_STREAMER_PROTO_FEC_HPP
+#define CAMERA_STREAMER_PROTO_FEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CameraStreamer {
+namespace Proto {
+
+/// \brief `aDst[i] ^= aSrc[i]`. Processes machine words, when both buffers
+/// are word-aligned, which is the case for the frame buffers and the parity
+/// buffer.
+void xorInto(std::uint8_t *aDst, const std::uint8_t *aSrc, std::size_t aSize);
+
+/// \brief Reference byte-wise implementation of `xorInto`
+void xorIntoBytewise(std::uint8_t *aDst, const std::uint8_t *aSrc, std::size_t aSize);
+
+}  // namespace Proto
+}  // namespace CameraStreamer
+
+#endif  // CAMERA_STREAMER_PROTO_FEC_HPP
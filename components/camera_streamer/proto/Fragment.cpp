@@ -0,0 +1,73 @@
+//
+// Fragment.cpp
+//
+
+#include "proto/Fragment.hpp"
+#include "proto/Endian.hpp"
+
+namespace CameraStreamer {
+namespace Proto {
+
+constexpr std::size_t FragmentHeader::kSize;
+constexpr std::uint8_t FragmentHeader::kMagic;
+constexpr std::uint8_t FragmentHeader::kVersion;
+constexpr std::size_t Fragmenter::kMaxFragments;
+
+// ------------ FragmentHeader ------------ //
+
+void FragmentHeader::pack(std::uint8_t *aOut) const
+{
+	aOut = packBigEndian(aOut, kMagic);
+	aOut = packBigEndian(aOut, kVersion);
+	aOut = packBigEndian(aOut, flags);
+	aOut = packBigEndian(aOut, fecGroupSize);
+	aOut = packBigEndian(aOut, frameId);
+	aOut = packBigEndian(aOut, fragmentIndex);
+	aOut = packBigEndian(aOut, fragmentCount);
+	aOut = packBigEndian(aOut, frameSize);
+	packBigEndian(aOut, timestampUs);
+}
+
+bool FragmentHeader::unpack(const std::uint8_t *aIn, std::size_t aSize)
+{
+	if (aSize < kSize || aIn[0] != kMagic || aIn[1] != kVersion) {
+		return false;
+	}
+
+	aIn = unpackBigEndian(aIn + 2, flags);
+	aIn = unpackBigEndian(aIn, fecGroupSize);
+	aIn = unpackBigEndian(aIn, frameId);
+	aIn = unpackBigEndian(aIn, fragmentIndex);
+	aIn = unpackBigEndian(aIn, fragmentCount);
+	aIn = unpackBigEndian(aIn, frameSize);
+	unpackBigEndian(aIn, timestampUs);
+
+	return true;
+}
+
+// ------------ Fragmenter ------------ //
+
+Fragmenter::Fragmenter(std::size_t aDatagramSize, std::uint8_t aFecGroupSize, std::uint8_t *aParityBuffer) :
+	fragmentPayloadSize{aDatagramSize > FragmentHeader::kSize ? aDatagramSize - FragmentHeader::kSize : 1},
+	groupSize{aParityBuffer == nullptr ? std::uint8_t{0} : aFecGroupSize},
+	parity{aParityBuffer}
+{
+}
+
+std::uint8_t Fragmenter::fecGroupSize() const
+{
+	return groupSize;
+}
+
+std::size_t Fragmenter::payloadSize() const
+{
+	return fragmentPayloadSize;
+}
+
+std::size_t Fragmenter::fragmentCount(std::size_t aFrameSize) const
+{
+	return (aFrameSize + fragmentPayloadSize - 1) / fragmentPayloadSize;
+}
+
+}  // namespace Proto
+}  // namespace CameraStreamer
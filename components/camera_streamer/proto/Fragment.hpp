@@ -0,0 +1,140 @@
+//
+// Fragment.hpp
+//
+// Fragmented frame transport. Each frame is split into datagrams which fit
+// into the link's MTU. Each datagram is prefixed with `FragmentHeader`.
+//
+
+#ifndef CAMERA_STREAMER_PROTO_FRAGMENT_HPP
+#define CAMERA_STREAMER_PROTO_FRAGMENT_HPP
+
+#include "proto/Fec.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace CameraStreamer {
+namespace Proto {
+
+/// \brief Fragment header. Fields are encoded big-endian.
+///
+/// \details Layout:
+/// offset  size  field
+/// 0       1     magic, `kMagic`
+/// 1       1     version, `kVersion`
+/// 2       1     flags, see `Flag`
+/// 3       1     FEC group size, N (0, if FEC is disabled)
+/// 4       4     frame id, increases monotonically w/ each frame
+/// 8       2     fragment index (group index for parity fragments)
+/// 10      2     data fragment count
+/// 12      4     frame size, bytes
+/// 16      8     capture timestamp, us since the camera's boot
+struct FragmentHeader {
+	static constexpr std::size_t kSize = 24;
+	static constexpr std::uint8_t kMagic = 0xcf;
+	static constexpr std::uint8_t kVersion = 1;
+
+	enum Flag : std::uint8_t {
+		FlagNone = 0,
+		FlagParity = 1 << 0,  ///< XOR of data fragments [N * index; N * (index + 1)), zero-padded
+	};
+
+	std::uint8_t flags;
+	std::uint8_t fecGroupSize;
+	std::uint32_t frameId;
+	std::uint16_t fragmentIndex;
+	std::uint16_t fragmentCount;
+	std::uint32_t frameSize;
+	std::uint64_t timestampUs;
+
+	/// \pre `aOut` is at least `kSize` bytes long
+	void pack(std::uint8_t *aOut) const;
+
+	/// \returns false, if the buffer is too short, or magic / version mismatch
+	bool unpack(const std::uint8_t *aIn, std::size_t aSize);
+};
+
+/// \brief Splits a frame into fragments. Fragments reference the frame's
+/// buffer, so the payload is never copied. When FEC is enabled, a parity
+/// fragment follows each group of data fragments.
+class Fragmenter {
+public:
+	/// \param aDatagramSize - max. size of a datagram, including the header
+	/// \param aFecGroupSize - number of data fragments per parity fragment, 0 disables FEC
+	/// \param aParityBuffer - `payloadSize()` bytes, word-aligned. Required, if FEC is enabled
+	explicit Fragmenter(std::size_t aDatagramSize, std::uint8_t aFecGroupSize = 0,
+		std::uint8_t *aParityBuffer = nullptr);
+
+	/// \brief Max. size of a fragment's payload
+	std::size_t payloadSize() const;
+
+	/// \brief Number of fragments a frame of `aFrameSize` will be split into
+	std::size_t fragmentCount(std::size_t aFrameSize) const;
+
+	std::uint8_t fecGroupSize() const;
+
+	/// \brief Invokes `aCallback(const FragmentHeader &, const std::uint8_t *header, const std::uint8_t *payload,
+	/// std::size_t payloadSize)` for each fragment, parity fragments included. `header` is the packed representation
+	/// of `FragmentHeader`, `FragmentHeader::kSize` bytes long. `header` and parity payloads are only valid during
+	/// the call.
+	template <class F>
+	bool forEachFragment(std::uint32_t aFrameId, std::uint64_t aTimestampUs, const std::uint8_t *aFrame,
+		std::size_t aFrameSize, F &&aCallback) const
+	{
+		const std::size_t count = fragmentCount(aFrameSize);
+
+		if (count == 0 || count > kMaxFragments) {
+			return false;
+		}
+
+		FragmentHeader header{FragmentHeader::FlagNone, groupSize, aFrameId, 0, static_cast<std::uint16_t>(count),
+			static_cast<std::uint32_t>(aFrameSize), aTimestampUs};
+		std::uint8_t packed[FragmentHeader::kSize];
+		std::size_t paritySize = 0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			const std::size_t offset = i * payloadSize();
+			const std::size_t size = std::min(aFrameSize - offset, payloadSize());
+			header.fragmentIndex = static_cast<std::uint16_t>(i);
+			header.pack(packed);
+			aCallback(static_cast<const FragmentHeader &>(header), static_cast<const std::uint8_t *>(packed),
+				aFrame + offset, size);
+
+			if (groupSize == 0) {
+				continue;
+			}
+
+			// The first fragment of a group initializes the parity, so the buffer does not have to be zeroed
+			if (i % groupSize == 0) {
+				std::memcpy(parity, aFrame + offset, size);
+				paritySize = size;
+			} else {
+				xorInto(parity, aFrame + offset, size);
+			}
+
+			if (i % groupSize == groupSize - 1u || i == count - 1) {
+				FragmentHeader parityHeader{header};
+				parityHeader.flags = FragmentHeader::FlagParity;
+				parityHeader.fragmentIndex = static_cast<std::uint16_t>(i / groupSize);
+				parityHeader.pack(packed);
+				aCallback(static_cast<const FragmentHeader &>(parityHeader), static_cast<const std::uint8_t *>(packed),
+					static_cast<const std::uint8_t *>(parity), paritySize);
+			}
+		}
+
+		return true;
+	}
+
+	static constexpr std::size_t kMaxFragments = 0xffff;
+
+private:
+	std::size_t fragmentPayloadSize;
+	std::uint8_t groupSize;
+	std::uint8_t *parity;
+};
+
+}  // namespace Proto
+}  // namespace CameraStreamer
+
+#endif  // CAMERA_STREAMER_PROTO_FRAGMENT_HPP
@@ -0,0 +1,290 @@
+//
+// RtpJpeg.cpp
+//
+
+#include "proto/RtpJpeg.hpp"
+#include "proto/Endian.hpp"
+#include <cstring>
+
+namespace CameraStreamer {
+namespace Proto {
+
+constexpr std::size_t JpegScan::kQuantTableSize;
+constexpr std::uint8_t RtpJpegPacketizer::kPayloadType;
+constexpr std::uint32_t RtpJpegPacketizer::kClockRateHz;
+constexpr std::size_t RtpJpegPacketizer::kRtpHeaderSize;
+constexpr std::size_t RtpJpegPacketizer::kJpegHeaderSize;
+constexpr std::size_t RtpJpegPacketizer::kRestartHeaderSize;
+constexpr std::size_t RtpJpegPacketizer::kQuantHeaderSize;
+constexpr std::size_t RtpJpegPacketizer::kMaxHeaderSize;
+constexpr std::size_t RtpJpegPacketizer::kSenderReportMaxSize;
+
+namespace Marker {
+
+static constexpr std::uint8_t kSoi = 0xd8;
+static constexpr std::uint8_t kEoi = 0xd9;
+static constexpr std::uint8_t kSof0 = 0xc0;  ///< Baseline DCT
+static constexpr std::uint8_t kDht = 0xc4;
+static constexpr std::uint8_t kDqt = 0xdb;
+static constexpr std::uint8_t kDri = 0xdd;
+static constexpr std::uint8_t kSos = 0xda;
+
+/// \brief Markers w/o a length field
+static bool isStandalone(std::uint8_t aMarker)
+{
+	return aMarker == 0x01 || (aMarker >= 0xd0 && aMarker <= kEoi);  // TEM, RSTn, SOI, EOI
+}
+
+/// \brief Start of frame markers other than baseline (SOF1-SOF15, except DHT, JPG, DAC)
+static bool isUnsupportedSof(std::uint8_t aMarker)
+{
+	return aMarker > kSof0 && aMarker <= 0xcf && aMarker != kDht && aMarker != 0xc8 && aMarker != 0xcc;
+}
+
+}  // namespace Marker
+
+// ------------ JpegScan ------------ //
+
+bool JpegScan::parse(const std::uint8_t *aJpeg, std::size_t aSize)
+{
+	static constexpr std::uint16_t kMaxDimension = 2040;  // 8 * 255, RTP/JPEG stores size in 8-pixel blocks
+
+	if (aSize < 4 || aJpeg[0] != 0xff || aJpeg[1] != Marker::kSoi) {
+		return false;
+	}
+
+	bool hasFrameHeader = false;
+	quantTables[0] = quantTables[1] = nullptr;
+	restartInterval = 0;
+	const std::uint8_t *it = aJpeg + 2;
+	const std::uint8_t *const end = aJpeg + aSize;
+
+	while (it + 2 <= end) {
+		if (it[0] != 0xff) {
+			return false;
+		}
+
+		const std::uint8_t marker = it[1];
+
+		if (marker == 0xff) {  // Fill byte
+			++it;
+
+			continue;
+		} else if (Marker::isStandalone(marker)) {
+			it += 2;
+
+			continue;
+		}
+
+		if (it + 4 > end) {
+			return false;
+		}
+
+		std::uint16_t length;
+		unpackBigEndian(it + 2, length);
+		const std::uint8_t *segment = it + 4;
+		const std::uint8_t *const segmentEnd = it + 2 + length;
+
+		if (length < 2 || segmentEnd > end) {
+			return false;
+		}
+
+		if (marker == Marker::kDqt) {
+			while (segment + 1 + kQuantTableSize <= segmentEnd) {
+				const std::uint8_t precision = segment[0] >> 4;
+				const std::uint8_t id = segment[0] & 0x0f;
+
+				if (precision != 0) {  // 16-bit tables are not supported
+					return false;
+				}
+
+				if (id < 2) {
+					quantTables[id] = segment + 1;
+				}
+
+				segment += 1 + kQuantTableSize;
+			}
+		} else if (marker == Marker::kSof0) {
+			static constexpr std::size_t kFrameHeaderSize = 6 + 3 * 3;  // 3 components
+
+			if (length < 2 + kFrameHeaderSize || segment[5] != 3) {
+				return false;
+			}
+
+			unpackBigEndian(segment + 1, height);
+			unpackBigEndian(segment + 3, width);
+			const std::uint8_t *components = segment + 6;
+
+			// RTP/JPEG implies luma is subsampled 2x1 or 2x2, chroma is not, and the chroma components share the
+			// second quantization table
+			if (components[3 + 1] != 0x11 || components[6 + 1] != 0x11 || components[2] != 0 || components[3 + 2] != 1
+				|| components[6 + 2] != 1)
+			{
+				return false;
+			}
+
+			if (components[1] == 0x21) {
+				type = Type422;
+			} else if (components[1] == 0x22) {
+				type = Type420;
+			} else {
+				return false;
+			}
+
+			hasFrameHeader = true;
+		} else if (Marker::isUnsupportedSof(marker)) {
+			return false;
+		} else if (marker == Marker::kDri) {
+			if (length < 4) {
+				return false;
+			}
+
+			unpackBigEndian(segment, restartInterval);
+		} else if (marker == Marker::kSos) {
+			scan = segmentEnd;
+			scanSize = static_cast<std::size_t>(end - scan);
+
+			// The camera's buffer may be padded after EOI
+			for (const std::uint8_t *eoi = end - 2; eoi >= scan; --eoi) {
+				if (eoi[0] == 0xff && eoi[1] == Marker::kEoi) {
+					scanSize = static_cast<std::size_t>(eoi - scan);
+
+					break;
+				}
+			}
+
+			return hasFrameHeader && quantTables[0] != nullptr && quantTables[1] != nullptr && width > 0
+				&& height > 0 && width <= kMaxDimension && height <= kMaxDimension;
+		}
+
+		it = segmentEnd;
+	}
+
+	return false;
+}
+
+// ------------ RtpJpegPacketizer ------------ //
+
+RtpJpegPacketizer::RtpJpegPacketizer(std::size_t aDatagramSize, std::uint32_t aSsrc) :
+	datagramSize{std::max(aDatagramSize, kMaxHeaderSize + 1)},
+	synchronizationSource{aSsrc},
+	sequenceNumber{static_cast<std::uint16_t>(aSsrc)},  // RFC 3550 recommends a random initial value
+	packetCount{0},
+	octetCount{0}
+{
+}
+
+std::uint32_t RtpJpegPacketizer::toRtpTimestamp(std::int64_t aTimeUs)
+{
+	return static_cast<std::uint32_t>(aTimeUs * (kClockRateHz / 10000) / 100);
+}
+
+std::uint64_t RtpJpegPacketizer::toNtpTimestamp(std::int64_t aUnixTimeUs)
+{
+	static constexpr std::uint64_t kNtpToUnixOffsetS = 2208988800ULL;  // 70 years, 17 of them leap
+	static constexpr std::uint64_t kUsPerS = 1000000;
+	const std::uint64_t seconds = static_cast<std::uint64_t>(aUnixTimeUs) / kUsPerS + kNtpToUnixOffsetS;
+	const std::uint64_t fraction = ((static_cast<std::uint64_t>(aUnixTimeUs) % kUsPerS) << 32) / kUsPerS;
+
+	return (seconds << 32) | fraction;
+}
+
+std::size_t RtpJpegPacketizer::packSenderReport(std::uint8_t *aOut, std::uint64_t aNtpTimestamp,
+	std::uint32_t aRtpTimestamp) const
+{
+	static constexpr std::uint8_t kVersion = 2 << 6;
+	static constexpr std::uint8_t kPtSenderReport = 200;
+	static constexpr std::uint8_t kPtSourceDescription = 202;
+	static constexpr std::uint8_t kSdesCname = 1;
+	static constexpr const char *kCname = "esp32cam";
+	static constexpr std::size_t kSenderReportSize = 28;
+	std::uint8_t *it = aOut;
+
+	// SR, no report blocks, as nothing is received
+	it = packBigEndian(it, kVersion);
+	it = packBigEndian(it, kPtSenderReport);
+	it = packBigEndian(it, static_cast<std::uint16_t>(kSenderReportSize / 4 - 1));
+	it = packBigEndian(it, synchronizationSource);
+	it = packBigEndian(it, aNtpTimestamp);
+	it = packBigEndian(it, aRtpTimestamp);
+	it = packBigEndian(it, packetCount);
+	it = packBigEndian(it, octetCount);
+
+	// SDES w/ a single CNAME chunk, each compound packet must have one (RFC 3550, 6.1)
+	const std::size_t cnameSize = std::strlen(kCname);
+	const std::size_t chunkSize = (4 + 2 + cnameSize + 1 + 3) / 4 * 4;  // SSRC, CNAME, END, 32-bit padding
+	it = packBigEndian(it, static_cast<std::uint8_t>(kVersion | 1));
+	it = packBigEndian(it, kPtSourceDescription);
+	it = packBigEndian(it, static_cast<std::uint16_t>(chunkSize / 4));
+	it = packBigEndian(it, synchronizationSource);
+	it = packBigEndian(it, kSdesCname);
+	it = packBigEndian(it, static_cast<std::uint8_t>(cnameSize));
+	std::memcpy(it, kCname, cnameSize);
+	it += cnameSize;
+	const std::size_t padding = chunkSize - (4 + 2 + cnameSize);  // END is part of the padding
+	std::memset(it, 0, padding);
+	it += padding;
+
+	return static_cast<std::size_t>(it - aOut);
+}
+
+std::uint32_t RtpJpegPacketizer::ssrc() const
+{
+	return synchronizationSource;
+}
+
+std::uint32_t RtpJpegPacketizer::packets() const
+{
+	return packetCount;
+}
+
+std::uint32_t RtpJpegPacketizer::octets() const
+{
+	return octetCount;
+}
+
+std::size_t RtpJpegPacketizer::headerSizeOf(const JpegScan &aJpeg, std::size_t aOffset) const
+{
+	return kRtpHeaderSize + kJpegHeaderSize + (aJpeg.restartInterval ? kRestartHeaderSize : 0)
+		+ (aOffset == 0 ? kQuantHeaderSize + 2 * JpegScan::kQuantTableSize : 0);
+}
+
+void RtpJpegPacketizer::packHeader(std::uint8_t *aOut, const JpegScan &aJpeg, std::uint32_t aTimestamp,
+	std::size_t aOffset, bool aLast)
+{
+	static constexpr std::uint8_t kVersion = 2 << 6;
+	static constexpr std::uint8_t kMarker = 1 << 7;  ///< Last packet of the frame
+	static constexpr std::uint8_t kQDynamic = 255;  ///< Quantization tables are sent in-band, and may change
+	static constexpr std::uint16_t kRestartCountAny = 0xffff;  ///< F = 1, L = 1, count = 0x3fff, RFC 2435, 3.1.7
+
+	// RTP
+	aOut = packBigEndian(aOut, kVersion);
+	aOut = packBigEndian(aOut, static_cast<std::uint8_t>(kPayloadType | (aLast ? kMarker : 0)));
+	aOut = packBigEndian(aOut, sequenceNumber++);
+	aOut = packBigEndian(aOut, aTimestamp);
+	aOut = packBigEndian(aOut, synchronizationSource);
+
+	// RTP/JPEG main header. The fragment offset is 24-bit
+	aOut = packBigEndian(aOut, static_cast<std::uint32_t>(aOffset & 0xffffff));
+	aOut = packBigEndian(aOut, static_cast<std::uint8_t>(aJpeg.type
+		+ (aJpeg.restartInterval ? JpegScan::TypeRestartMarkersOffset : 0)));
+	aOut = packBigEndian(aOut, kQDynamic);
+	aOut = packBigEndian(aOut, static_cast<std::uint8_t>((aJpeg.width + 7) / 8));
+	aOut = packBigEndian(aOut, static_cast<std::uint8_t>((aJpeg.height + 7) / 8));
+
+	if (aJpeg.restartInterval) {
+		aOut = packBigEndian(aOut, aJpeg.restartInterval);
+		aOut = packBigEndian(aOut, kRestartCountAny);
+	}
+
+	if (aOffset == 0) {
+		aOut = packBigEndian(aOut, std::uint8_t{0});  // MBZ
+		aOut = packBigEndian(aOut, std::uint8_t{0});  // Precision, 8-bit
+		aOut = packBigEndian(aOut, static_cast<std::uint16_t>(2 * JpegScan::kQuantTableSize));
+		std::memcpy(aOut, aJpeg.quantTables[0], JpegScan::kQuantTableSize);
+		std::memcpy(aOut + JpegScan::kQuantTableSize, aJpeg.quantTables[1], JpegScan::kQuantTableSize);
+	}
+}
+
+}  // namespace Proto
+}  // namespace CameraStreamer
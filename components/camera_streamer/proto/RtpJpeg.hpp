@@ -0,0 +1,136 @@
+//
+// RtpJpeg.hpp
+//
+// RTP payload format for JPEG (RFC 2435), and RTCP sender reports (RFC 3550).
+//
+// JPEG headers are not sent. Instead, each packet carries an RTP/JPEG main
+// header (type, size, fragment offset), and the first packet of a frame also
+// carries the quantization tables. The receiver reconstructs the headers
+// assuming the standard Huffman tables (JPEG spec., Annex K.3), which is what
+// OV2640 uses.
+//
+
+#ifndef CAMERA_STREAMER_PROTO_RTPJPEG_HPP
+#define CAMERA_STREAMER_PROTO_RTPJPEG_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace CameraStreamer {
+namespace Proto {
+
+/// \brief Baseline JPEG broken down into what RTP/JPEG needs. References the
+/// parsed buffer.
+struct JpegScan {
+	static constexpr std::size_t kQuantTableSize = 64;  ///< 8-bit precision only
+
+	/// \brief RFC 2435 image type
+	enum Type : std::uint8_t {
+		Type422 = 0,  ///< YUV 4:2:2, luma sampled 2x1
+		Type420 = 1,  ///< YUV 4:2:0, luma sampled 2x2
+		TypeRestartMarkersOffset = 64,  ///< Added to the type, when DRI is present
+	};
+
+	std::uint16_t width;
+	std::uint16_t height;
+	std::uint8_t type;  ///< `Type422` or `Type420`, w/o the restart markers offset
+	std::uint16_t restartInterval;  ///< 0, if there is no DRI marker
+	const std::uint8_t *quantTables[2];  ///< Luma and chroma, zigzag order, as stored in DQT
+	const std::uint8_t *scan;  ///< Entropy-coded data following SOS
+	std::size_t scanSize;  ///< Up to, not including, EOI
+
+	/// \brief Parses the markers of a baseline, 3-component JPEG
+	/// \returns false, if the image cannot be carried by RTP/JPEG (progressive, 16-bit quantization tables,
+	/// unsupported sampling, size above 2040 px, etc.)
+	bool parse(const std::uint8_t *aJpeg, std::size_t aSize);
+};
+
+/// \brief Splits JPEG frames into RTP/JPEG packets. Packets reference the
+/// frame's scan data, so the payload is never copied.
+class RtpJpegPacketizer {
+public:
+	static constexpr std::uint8_t kPayloadType = 26;  ///< Static payload type for JPEG, RFC 3551
+	static constexpr std::uint32_t kClockRateHz = 90000;
+	static constexpr std::size_t kRtpHeaderSize = 12;
+	static constexpr std::size_t kJpegHeaderSize = 8;
+	static constexpr std::size_t kRestartHeaderSize = 4;
+	static constexpr std::size_t kQuantHeaderSize = 4;
+	static constexpr std::size_t kMaxHeaderSize = kRtpHeaderSize + kJpegHeaderSize + kRestartHeaderSize
+		+ kQuantHeaderSize + 2 * JpegScan::kQuantTableSize;
+	static constexpr std::size_t kSenderReportMaxSize = 48;  ///< SR + SDES CNAME compound packet
+
+	/// \param aDatagramSize - max. size of a datagram, including the headers
+	/// \param aSsrc - synchronization source identifier, should be random
+	RtpJpegPacketizer(std::size_t aDatagramSize, std::uint32_t aSsrc);
+
+	/// \brief Converts time (since boot, us) to the 90 kHz RTP clock
+	static std::uint32_t toRtpTimestamp(std::int64_t aTimeUs);
+
+	/// \brief Converts UNIX time, us, into 64-bit NTP timestamp (seconds since 1900, 32.32 fixed point)
+	static std::uint64_t toNtpTimestamp(std::int64_t aUnixTimeUs);
+
+	/// \brief Invokes `aCallback(const std::uint8_t *header, std::size_t headerSize, const std::uint8_t *payload,
+	/// std::size_t payloadSize)` for each packet of the frame. `header` comprises the RTP header and the RTP/JPEG
+	/// headers, and it is only valid during the call. `payload` points into `aJpeg`.
+	/// \returns false, if the frame cannot be carried by RTP/JPEG, see `JpegScan::parse`
+	template <class F>
+	bool forEachPacket(std::int64_t aCaptureTimeUs, const std::uint8_t *aJpeg, std::size_t aSize, F &&aCallback)
+	{
+		JpegScan jpeg;
+
+		if (!jpeg.parse(aJpeg, aSize) || jpeg.scanSize == 0) {
+			return false;
+		}
+
+		const std::uint32_t timestamp = toRtpTimestamp(aCaptureTimeUs);
+		std::uint8_t header[kMaxHeaderSize];
+
+		for (std::size_t offset = 0; offset < jpeg.scanSize;) {
+			const std::size_t headerSize = headerSizeOf(jpeg, offset);
+			const std::size_t payloadSize = std::min(jpeg.scanSize - offset, datagramSize - headerSize);
+			const bool last = offset + payloadSize == jpeg.scanSize;
+			packHeader(header, jpeg, timestamp, offset, last);
+			aCallback(static_cast<const std::uint8_t *>(header), headerSize,
+				static_cast<const std::uint8_t *>(jpeg.scan + offset), payloadSize);
+			offset += payloadSize;
+			++packetCount;
+			octetCount += headerSize - kRtpHeaderSize + payloadSize;
+		}
+
+		return true;
+	}
+
+	/// \brief Packs RTCP SR followed by SDES CNAME.
+	/// \param aNtpTimestamp - wall clock time of the report, see `toNtpTimestamp`
+	/// \param aRtpTimestamp - the same moment on the RTP clock, see `toRtpTimestamp`
+	/// \pre `aOut` is at least `kSenderReportMaxSize` bytes long
+	/// \returns size of the compound packet
+	std::size_t packSenderReport(std::uint8_t *aOut, std::uint64_t aNtpTimestamp, std::uint32_t aRtpTimestamp) const;
+
+	std::uint32_t ssrc() const;
+
+	/// \brief Total number of RTP packets sent
+	std::uint32_t packets() const;
+
+	/// \brief Total number of RTP payload bytes (RTP/JPEG headers included) sent
+	std::uint32_t octets() const;
+
+private:
+	/// \pre The datagram size is greater than `kMaxHeaderSize`
+	std::size_t headerSizeOf(const JpegScan &aJpeg, std::size_t aOffset) const;
+	void packHeader(std::uint8_t *aOut, const JpegScan &aJpeg, std::uint32_t aTimestamp, std::size_t aOffset,
+		bool aLast);
+
+private:
+	std::size_t datagramSize;
+	std::uint32_t synchronizationSource;
+	std::uint16_t sequenceNumber;
+	std::uint32_t packetCount;
+	std::uint32_t octetCount;
+};
+
+}  // namespace Proto
+}  // namespace CameraStreamer
+
+#endif  // CAMERA_STREAMER_PROTO_RTPJPEG_HPP
@@ -9,6 +9,7 @@
 #include <freertos/FreeRTOS.h>
 #include <memory>
 #include "CameraStream.hpp"
+#include "cam/FrameRing.hpp"
 #include "utility/time.hpp"
 #include "Ov2640.hpp"
 #include <esp_log.h>
@@ -44,6 +45,7 @@ void CameraStream::operator()()
 				lastSend = Ut::bootTimeUs() / 1000;
 			}
 
+			Cam::FrameRing::getInstance().push(img);  // Heavy consumers process the frame in their own contexts
 			Sub::Key::NewFrame::notify(img);
 			img.reset();
 			img = Cam::Camera::getInstance().getFrame();
@@ -12,6 +12,7 @@
 
 #include "http/client/file.h"
 #include "pages/pages.h"
+#include <lwip/sockets.h>
 #include <sdkconfig.h>
 
 const char *kHttpDebugTag = "[http]";
@@ -47,6 +48,24 @@ static const httpd_uri_t pages[] = {
 	},
 #endif
 
+#ifdef CONFIG_HTTP_PAGE_MJPEG_STREAM_ENABLE
+	{
+		.uri      = "/camera/stream",
+		.method   = HTTP_GET,
+		.handler  = mjpegStreamHandler,
+		.user_ctx = 0
+	},
+#endif
+
+#ifdef CONFIG_HTTP_PAGE_LATENCY_ENABLE
+	{
+		.uri      = "/camera/latency",
+		.method   = HTTP_GET,
+		.handler  = latencyPageHandler,
+		.user_ctx = 0
+	},
+#endif
+
 #ifdef HTTP_PAGE_FILE_UPLOAD_ENABLE
 	{
 		.uri      = "/fw",
@@ -65,11 +84,25 @@ static const httpd_uri_t pages[] = {
 
 static const size_t kNpages = sizeof(pages) / sizeof(httpd_uri_t);
 
+#ifdef CONFIG_HTTP_PAGE_MJPEG_STREAM_ENABLE
+/// \brief Stream sessions are served outside of the server's context, so the streamer must be notified before a
+/// session's socket gets closed (and its descriptor may be reused)
+static void onSessionClose(httpd_handle_t server, int sockfd)
+{
+	(void)server;
+	mjpegStreamOnSessionClose(sockfd);
+	close(sockfd);
+}
+#endif
+
 static httpd_handle_t startWebserver(void)
 {
 	httpd_handle_t server = NULL;
 	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 	config.stack_size += 1024;
+#ifdef CONFIG_HTTP_PAGE_MJPEG_STREAM_ENABLE
+	config.close_fn = onSessionClose;
+#endif
 
 	// Start the httpd server
 	if (httpd_start(&server, &config) == ESP_OK) {
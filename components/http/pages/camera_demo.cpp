@@ -14,7 +14,7 @@ static struct CameraSubscriber {
 
 	struct OnFrameHook {
 		std::mutex mutex;
-		std::function<void(const std::shared_ptr<Cam::Frame> &)> callback;
+		std::function<void(const Cam::FramePtr &)> callback;
 	};
 
 	/// If a subscription is active, gets triggered on a new frame posted into
@@ -75,7 +75,7 @@ extern "C" esp_err_t cameraDemoHandler(httpd_req_t *req)
 
 	res = ESP_FAIL;
 	sCameraSubscriber.waitFrameSync(
-		[&req, &res](const std::shared_ptr<Cam::Frame> &frame)
+		[&req, &res](const Cam::FramePtr &frame)
 		{
 			res = httpd_resp_send(req, static_cast<const char *>(frame->data()), frame->size());
 		});
@@ -0,0 +1,70 @@
+//
+// latency.cpp
+//
+// Reports per-consumer frame latency statistics. `/camera/latency?reset=1`
+// resets the statistics after they have been reported.
+//
+
+#include "pages.h"
+#include "cam/Latency.hpp"
+#include <cJSON.h>
+#include <cstring>
+#include <esp_err.h>
+#include <esp_http_server.h>
+
+static cJSON *histogramToJson(const Cam::LatencyStats::Histogram &aHistogram)
+{
+	auto *json = cJSON_CreateObject();
+	cJSON_AddNumberToObject(json, "count", aHistogram.count());
+	cJSON_AddNumberToObject(json, "mean_us", aHistogram.mean());
+	cJSON_AddNumberToObject(json, "p50_us", aHistogram.percentile(50));
+	cJSON_AddNumberToObject(json, "p90_us", aHistogram.percentile(90));
+	cJSON_AddNumberToObject(json, "p99_us", aHistogram.percentile(99));
+	cJSON_AddNumberToObject(json, "max_us", aHistogram.max());
+	auto *buckets = cJSON_AddArrayToObject(json, "buckets");
+
+	// Bucket `i` holds values in [2^i; 2^(i+1)) us
+	for (std::size_t i = 0; i < aHistogram.size(); ++i) {
+		cJSON_AddItemToArray(buckets, cJSON_CreateNumber(aHistogram.bucket(i)));
+	}
+
+	return json;
+}
+
+static bool isResetRequested(httpd_req_t *aReq)
+{
+	static constexpr std::size_t kQueryMaxLength = 32;
+	char query[kQueryMaxLength] = {0};
+	char value[2] = {0};
+
+	return httpd_req_get_url_query_str(aReq, query, sizeof(query)) == ESP_OK
+		&& httpd_query_key_value(query, "reset", value, sizeof(value)) == ESP_OK && value[0] == '1';
+}
+
+esp_err_t latencyPageHandler(httpd_req_t *aReq)
+{
+	auto *consumers = cJSON_CreateArray();
+
+	for (std::size_t i = 0; i < Cam::Latency::size(); ++i) {
+		const auto &stats = Cam::Latency::at(i);
+		auto *consumer = cJSON_CreateObject();
+		cJSON_AddStringToObject(consumer, "name", stats.name.load());
+		cJSON_AddNumberToObject(consumer, "last_sequence", stats.lastSequence.load());
+		cJSON_AddItemToObject(consumer, "capture_to_consume", histogramToJson(stats.captureToConsume));
+		cJSON_AddItemToObject(consumer, "consume_duration", histogramToJson(stats.consumeDuration));
+		cJSON_AddItemToArray(consumers, consumer);
+	}
+
+	if (isResetRequested(aReq)) {
+		Cam::Latency::reset();
+	}
+
+	char *json = cJSON_Print(consumers);
+	httpd_resp_set_type(aReq, "application/json");
+	esp_err_t res = httpd_resp_send(aReq, json, strlen(json));
+
+	free(json);
+	cJSON_Delete(consumers);
+
+	return res;
+}
@@ -0,0 +1,359 @@
+//
+// mjpeg_stream.cpp
+//
+// `multipart/x-mixed-replace` MJPEG stream. Usage: `/camera/stream[?fps=N]`.
+//
+// The handler only sends the response header, and hands the connection over
+// to the streamer. The streamer reads the frame ring (see `Cam::FrameRing`)
+// through a single consumer, and fans each frame out to the clients over
+// non-blocking sockets, so neither the HTTP server, nor the camera thread wait
+// for the clients. The clients share a reference to the frame, rather than
+// copy it. The ring's frames stay intact, even if the driver re-uses its
+// buffer right away (see `Cam::FrameRing::pushCopy`). A client which has not
+// yet sent the previous frame skips the new one.
+//
+
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_HTTP_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include "http.h"
+#include "pages.h"
+#include "cam/FrameRing.hpp"
+#include "utility/thr/Semaphore.hpp"
+#include "utility/thr/Threading.hpp"
+#include "utility/time.hpp"
+#include <lwip/sockets.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sdkconfig.h>
+
+#if CONFIG_HTTP_PAGE_MJPEG_STREAM_ENABLE
+
+static constexpr const char *kBoundary = "esp32camframe";
+static constexpr std::chrono::milliseconds kPollPeriod{10};
+
+static class MjpegStreamer : public Ut::Thr::FreertosTask {
+private:
+	struct Client {
+		httpd_handle_t server;
+		int fd;  ///< -1, if the slot is free
+		std::int64_t minFrameIntervalUs;  ///< Pacing
+		std::int64_t lastFrameUs;
+		Cam::FramePtr frame;  ///< The frame being sent at the moment, shared w/ the other clients. Empty, if none
+		char header[128];  ///< Part header of the frame being sent
+		std::size_t headerSize;
+		std::size_t offset;  ///< Bytes of (header + frame) sent so far
+		unsigned sent;
+		unsigned skipped;
+
+		bool isPending() const
+		{
+			return static_cast<bool>(frame);
+		}
+
+		std::size_t totalSize() const
+		{
+			return headerSize + frame->size();
+		}
+	};
+
+public:
+	MjpegStreamer() :
+		Ut::Thr::FreertosTask{"MjpegStream", CONFIG_HTTP_MJPEG_STREAM_STACK_SIZE, CONFIG_HTTP_MJPEG_STREAM_PRIORITY},
+		frameConsumer{"MjpegStream", &MjpegStreamer::onNewFrame, this},
+		started{false}
+	{
+		for (auto &client : clients) {
+			client.fd = -1;
+		}
+	}
+
+	bool isFull()
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		return std::none_of(clients.begin(), clients.end(), [](const Client &aClient) { return aClient.fd < 0; });
+	}
+
+	/// \brief Takes over the connection
+	/// \returns false, if the client table is full
+	bool add(httpd_handle_t aServer, int aFd, unsigned aFps)
+	{
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			auto it = std::find_if(clients.begin(), clients.end(),
+				[](const Client &aClient) { return aClient.fd < 0; });
+
+			if (it == clients.end()) {
+				return false;
+			}
+
+			it->server = aServer;
+			it->fd = aFd;
+			it->minFrameIntervalUs = aFps > 0 ? 1000000 / aFps : 0;
+			it->lastFrameUs = 0;
+			it->frame.reset();
+			it->offset = 0;
+			it->sent = 0;
+			it->skipped = 0;
+
+			if (!started) {
+				started = true;
+				start();
+			}
+		}
+
+		updateSubscription();
+		ESP_LOGI(kHttpDebugTag, "mjpeg stream: client fd=%d connected, fps limit %u", aFd, aFps);
+
+		return true;
+	}
+
+	/// \brief Invoked by the HTTP server, when a session gets closed, so the
+	/// descriptor is never used after it may have been reused
+	void remove(int aFd)
+	{
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+
+			for (auto &client : clients) {
+				if (client.fd == aFd) {
+					release(client);
+				}
+			}
+		}
+
+		updateSubscription();
+	}
+
+	void run() override
+	{
+		while (true) {
+			fd_set writeFds;
+			FD_ZERO(&writeFds);
+			int maxFd = -1;
+			Cam::FramePtr frame{};
+
+			{
+				std::lock_guard<std::mutex> lock{frameMutex};
+				frame.swap(latestFrame);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				dispatch(frame);
+				frame.reset();  // Only the clients it has been handed over to hold it
+
+				for (const auto &client : clients) {
+					if (client.fd >= 0 && client.isPending()) {
+						FD_SET(client.fd, &writeFds);
+						maxFd = std::max(maxFd, client.fd);
+					}
+				}
+			}
+
+			if (maxFd < 0) {  // Nothing to send, wait for a new frame
+				semFrame.try_acquire_for(std::chrono::duration_cast<std::chrono::microseconds>(kPollPeriod * 10));
+
+				continue;
+			}
+
+			timeval timeout{0, static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(kPollPeriod)
+				.count())};
+
+			if (select(maxFd + 1, nullptr, &writeFds, nullptr, &timeout) <= 0) {  // A session may have been closed concurrently, it is safe to just retry
+				continue;
+			}
+
+			bool released = false;
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+
+				for (auto &client : clients) {
+					if (client.fd >= 0 && client.isPending() && FD_ISSET(client.fd, &writeFds)) {
+						released = !sendPending(client) || released;
+					}
+				}
+			}
+
+			if (released) {
+				updateSubscription();
+			}
+		}
+	}
+
+private:
+	/// \brief Invoked from the consumer's task. Only takes a reference to the
+	/// frame, under `frameMutex`, which nothing else is done under.
+	void onNewFrame(const Cam::FramePtr &aFrame)
+	{
+		{
+			std::lock_guard<std::mutex> lock{frameMutex};
+			latestFrame = aFrame;
+		}
+
+		semFrame.release();
+	}
+
+	/// \brief Only receive frames, when there is someone to send them to. The
+	/// consumer is toggled w/o the mutexes taken, as disabling it waits for
+	/// `onNewFrame`. `subscriptionMutex` keeps concurrent toggles in order.
+	void updateSubscription()
+	{
+		std::lock_guard<std::mutex> lockSubscription{subscriptionMutex};
+		bool any = false;
+
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			any = std::any_of(clients.begin(), clients.end(), [](const Client &aClient) { return aClient.fd >= 0; });
+		}
+
+		frameConsumer.setEnabled(any);
+
+		if (!any) {
+			std::lock_guard<std::mutex> lock{frameMutex};
+			latestFrame.reset();
+		}
+	}
+
+	/// \brief Hands the frame over to the clients which are ready for it
+	/// \pre The mutex is taken
+	void dispatch(const Cam::FramePtr &aFrame)
+	{
+		if (!aFrame) {
+			return;
+		}
+
+		const auto now = Ut::bootTimeUs();
+
+		for (auto &client : clients) {
+			if (client.fd < 0 || now - client.lastFrameUs < client.minFrameIntervalUs) {
+				continue;
+			}
+
+			if (client.isPending()) {  // Still busy w/ the previous frame, drop this one for the client
+				++client.skipped;
+
+				continue;
+			}
+
+			const int headerSize = snprintf(client.header, sizeof(client.header),
+				"\r\n--%s\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %lld\r\n\r\n", kBoundary,
+				static_cast<unsigned>(aFrame->size()), static_cast<long long>(aFrame->captureTimeUs()));
+			client.headerSize = std::min<std::size_t>(headerSize, sizeof(client.header) - 1);
+			client.frame = aFrame;
+			client.offset = 0;
+			client.lastFrameUs = now;
+		}
+	}
+
+	/// \returns false, if the client has been released
+	/// \pre The mutex is taken
+	bool sendPending(Client &aClient)
+	{
+		while (aClient.offset < aClient.totalSize()) {
+			const bool isHeader = aClient.offset < aClient.headerSize;
+			const auto *data = isHeader ? reinterpret_cast<const std::uint8_t *>(aClient.header) + aClient.offset
+				: static_cast<const std::uint8_t *>(aClient.frame->data()) + (aClient.offset - aClient.headerSize);
+			const std::size_t size = isHeader ? aClient.headerSize - aClient.offset
+				: aClient.totalSize() - aClient.offset;
+			const auto nSent = send(aClient.fd, data, size, MSG_DONTWAIT);
+
+			if (nSent < 0) {
+				if (errno != EAGAIN && errno != EWOULDBLOCK) {
+					ESP_LOGI(kHttpDebugTag, "mjpeg stream: client fd=%d, send error %d, closing", aClient.fd, errno);
+					httpd_sess_trigger_close(aClient.server, aClient.fd);
+					release(aClient);
+
+					return false;
+				}
+
+				return true;
+			}
+
+			aClient.offset += nSent;
+		}
+
+		++aClient.sent;
+		aClient.frame.reset();  // Once every client has sent it, the frame goes back to the ring
+
+		return true;
+	}
+
+	/// \brief The subscription is updated by the caller, once the mutex has
+	/// been released, see `updateSubscription`
+	/// \pre The mutex is taken
+	void release(Client &aClient)
+	{
+		ESP_LOGI(kHttpDebugTag, "mjpeg stream: client fd=%d gone, frames sent %u, skipped %u", aClient.fd,
+			aClient.sent, aClient.skipped);
+		aClient.fd = -1;
+		aClient.frame.reset();
+	}
+
+private:
+	Cam::FrameConsumer frameConsumer;
+	std::array<Client, CONFIG_HTTP_MJPEG_STREAM_MAX_CLIENTS> clients;
+	Cam::FramePtr latestFrame;  ///< Not yet dispatched
+	Ut::Thr::Semaphore<1, 0> semFrame;
+	std::mutex frameMutex;  ///< Guards `latestFrame`
+	std::mutex mutex;  ///< Guards `clients`. Never taken by the consumer's task
+	std::mutex subscriptionMutex;
+	bool started;
+} sMjpegStreamer{};
+
+static unsigned parseFps(httpd_req_t *aReq)
+{
+	static constexpr std::size_t kQueryMaxLength = 32;
+	char query[kQueryMaxLength] = {0};
+	char value[8] = {0};
+
+	if (httpd_req_get_url_query_str(aReq, query, sizeof(query)) == ESP_OK
+		&& httpd_query_key_value(query, "fps", value, sizeof(value)) == ESP_OK)
+	{
+		return static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+	}
+
+	return CONFIG_HTTP_MJPEG_STREAM_FPS;
+}
+
+esp_err_t mjpegStreamHandler(httpd_req_t *aReq)
+{
+	if (sMjpegStreamer.isFull()) {  // The server is single-threaded, so the slot will not be taken in the meantime
+		ESP_LOGW(kHttpDebugTag, "mjpeg stream: too many clients (see CONFIG_HTTP_MJPEG_STREAM_MAX_CLIENTS)");
+
+		return httpd_resp_send_err(aReq, HTTPD_500_INTERNAL_SERVER_ERROR, "Too many stream clients");
+	}
+
+	static constexpr std::size_t kHeaderMaxLength = 160;
+	char header[kHeaderMaxLength];
+	const int headerLength = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+		"Content-Type: multipart/x-mixed-replace;boundary=%s\r\n"
+		"Cache-Control: no-cache\r\n"
+		"Access-Control-Allow-Origin: *\r\n\r\n", kBoundary);
+	const int fd = httpd_req_to_sockfd(aReq);
+
+	if (fd < 0 || send(fd, header, headerLength, 0) != headerLength) {
+		return ESP_FAIL;
+	}
+
+	if (!sMjpegStreamer.add(aReq->handle, fd, parseFps(aReq))) {
+		return ESP_FAIL;  // Makes the server close the session
+	}
+
+	return ESP_OK;  // The session stays open, and the streamer writes into it
+}
+
+void mjpegStreamOnSessionClose(int aFd)
+{
+	sMjpegStreamer.remove(aFd);
+}
+
+#endif  // CONFIG_HTTP_PAGE_MJPEG_STREAM_ENABLE
@@ -25,6 +25,10 @@ esp_err_t indexPageHandler(httpd_req_t *);
 esp_err_t infoPageHandler(httpd_req_t *);
 esp_err_t fwPageHandler(httpd_req_t *);
 esp_err_t fwUploadPageHandler(httpd_req_t *);
+esp_err_t latencyPageHandler(httpd_req_t *);
+esp_err_t mjpegStreamHandler(httpd_req_t *);
+/// \brief Notifies the MJPEG streamer that the session is about to be closed
+void mjpegStreamOnSessionClose(int sockfd);
 
 #ifdef __cplusplus
 }
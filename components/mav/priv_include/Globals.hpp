@@ -9,6 +9,7 @@
 #define MAV_PRIV_INCLUDE_GLOBALS_HPP
 
 #include "Mavlink.hpp"
+#include <sdkconfig.h>
 #include <cstdint>
 
 namespace Mav {
@@ -43,11 +44,16 @@ public:
 		return MAV_COMP_ID_CAMERA;
 	}
 
-	static constexpr unsigned char getCompIdTracker()
+	/// \param aTarget - tracked object's index. Each one is addressed as a camera component of its own, the range
+	/// starts at `CONFIG_MAV_COMP_ID_TRACKER_FIRST`
+	static constexpr unsigned char getCompIdTracker(unsigned aTarget = 0)
 	{
-		return MAV_COMP_ID_CAMERA2;
+		return CONFIG_MAV_COMP_ID_TRACKER_FIRST + aTarget;
 	}
 
+	static_assert(CONFIG_MAV_COMP_ID_TRACKER_FIRST + CONFIG_TRACKING_MAX_TARGETS <= 255,
+		"The trackers' component ids must fit 1 byte");
+
 	template <class TmavlinkMessage>
 	static constexpr std::size_t getMaxMessageLength()
 	{
@@ -16,6 +16,8 @@
 #include "Helper/MavlinkCommandAck.hpp"
 #include "Helper/MavlinkCommandLong.hpp"
 #include "Microservice/Camera.hpp"
+#include "cam/Latency.hpp"
+#include "camera_recorder/RecBurst.hpp"
 #include "camera_recorder/RecFrame.hpp"
 #include "mav/mav.hpp"
 #include "module/ModuleBase.hpp"
@@ -102,6 +104,11 @@ Microservice::Ret Camera::process(mavlink_message_t &aMessage, OnResponseSignatu
 
 							break;
 
+						case MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY:
+							ret = processRequestMessageDebugFloatArray(commandLong, aMessage, aOnResponse);
+
+							break;
+
 						default:
 							break;
 					}
@@ -113,6 +120,11 @@ Microservice::Ret Camera::process(mavlink_message_t &aMessage, OnResponseSignatu
 
 					break;
 
+				case MAV_CMD_IMAGE_STOP_CAPTURE:
+					ret = processCmdImageStopCapture(commandLong, aMessage, aOnResponse);
+
+					break;
+
 				case MAV_CMD_VIDEO_START_CAPTURE:
 					ret = processCmdVideoStartCapture(commandLong, aMessage, aOnResponse);
 
@@ -262,6 +274,14 @@ Microservice::Ret Camera::processRequestMessageCameraCaptureStatus(mavlink_comma
 		mavlink_camera_capture_status_t mavlinkCameraCaptureStatus {};
 		Mav::Hlpr::Cmn::fieldTimeBootMsInit(mavlinkCameraCaptureStatus);
 		mavlinkCameraCaptureStatus.image_count = history.imageCaptureCount;
+
+		if (CameraRecorder::RecBurst::checkInstance() && CameraRecorder::RecBurst::getInstance().isActive()) {
+			static constexpr std::uint8_t kImageStatusIntervalCapture = 3;  // Interval set, capture in progress
+			mavlinkCameraCaptureStatus.image_status = kImageStatusIntervalCapture;
+			mavlinkCameraCaptureStatus.image_interval =
+				static_cast<float>(CameraRecorder::RecBurst::getInstance().intervalUs()) / 1e6f;
+		}
+
 		ModuleBase::moduleFieldReadIter<Module::Camera, Fld::Field::Recording>(
 			[&mavlinkCameraCaptureStatus](bool aRecording) { mavlinkCameraCaptureStatus.video_status = aRecording; });
 		mavlink_msg_camera_capture_status_encode(Globals::getSysId(), Globals::getCompIdCamera(), &aMessage,
@@ -272,6 +292,56 @@ Microservice::Ret Camera::processRequestMessageCameraCaptureStatus(mavlink_comma
 	return Ret::Response;
 }
 
+/// \brief Reports frame latency statistics (see `Cam::Latency`). Each consumer
+/// produces 2 `DEBUG_FLOAT_ARRAY` messages: capture-to-consume (`array_id` =
+/// 2 * consumer index), and consume duration (`array_id` = 2 * consumer index
+/// + 1). `name` is the consumer's name, truncated. `data` layout: count, mean,
+/// p50, p90, p99, max (us), followed by histogram buckets, bucket `i` holding
+/// values in [2^i; 2^(i+1)) us.
+Microservice::Ret Camera::processRequestMessageDebugFloatArray(mavlink_command_long_t &aMavlinkCommandLong,
+	mavlink_message_t &aMessage, Microservice::OnResponseSignature aOnResponse)
+{
+	ESP_LOGD(Mav::kDebugTag, "Camera::processRequestMessageDebugFloatArray");
+	{
+		auto ack = Mav::Hlpr::MavlinkCommandAck::makeFrom(aMessage, aMavlinkCommandLong.command, MAV_RESULT_ACCEPTED);
+		ack.packInto(aMessage, Globals::getCompIdCamera());
+		aOnResponse(aMessage);
+	}
+
+	for (std::size_t i = 0; i < Cam::Latency::size(); ++i) {
+		const auto &stats = Cam::Latency::at(i);
+		const Cam::LatencyStats::Histogram *histograms[] = {&stats.captureToConsume, &stats.consumeDuration};
+
+		for (std::size_t kind = 0; kind < 2; ++kind) {
+			const auto &histogram = *histograms[kind];
+			mavlink_debug_float_array_t mavlinkDebugFloatArray {};
+			mavlinkDebugFloatArray.time_usec = Ut::bootTimeUs();
+			mavlinkDebugFloatArray.array_id = static_cast<std::uint16_t>(i * 2 + kind);
+			const char *name = stats.name.load();
+			std::copy_n(name, std::min<std::size_t>(std::strlen(name), sizeof(mavlinkDebugFloatArray.name)),
+				mavlinkDebugFloatArray.name);
+			const float summary[] = {static_cast<float>(histogram.count()), static_cast<float>(histogram.mean()),
+				static_cast<float>(histogram.percentile(50)), static_cast<float>(histogram.percentile(90)),
+				static_cast<float>(histogram.percentile(99)), static_cast<float>(histogram.max())};
+			static constexpr std::size_t kDataLen = sizeof(mavlinkDebugFloatArray.data)
+				/ sizeof(mavlinkDebugFloatArray.data[0]);
+			static constexpr std::size_t kSummaryLen = sizeof(summary) / sizeof(summary[0]);
+			static_assert(kSummaryLen + Cam::LatencyStats::Histogram::size() <= kDataLen, "");
+			std::copy_n(summary, kSummaryLen, mavlinkDebugFloatArray.data);
+
+			for (std::size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+				mavlinkDebugFloatArray.data[kSummaryLen + bucket] = static_cast<float>(histogram.bucket(bucket));
+			}
+
+			mavlink_msg_debug_float_array_encode(Globals::getSysId(), Globals::getCompIdCamera(), &aMessage,
+				&mavlinkDebugFloatArray);
+			aOnResponse(aMessage);
+		}
+	}
+
+	return Ret::Response;
+}
+
 Microservice::Ret Camera::processCmdImageStartCapture(mavlink_command_long_t &aMavlinkCommandLong,
 	mavlink_message_t &aMessage, Microservice::OnResponseSignature aOnResponse)
 {
@@ -288,7 +358,7 @@ Microservice::Ret Camera::processCmdImageStartCapture(mavlink_command_long_t &aM
 		aOnResponse(aMessage);
 	}
 
-	if (MAV_RESULT_ACCEPTED == imageCapture.result) {
+	if (MAV_RESULT_ACCEPTED == imageCapture.result && 1 == imageCapture.totalImages) {  // Bursts report each shot
 		ESP_LOGD(Mav::kDebugTag, "Camera::processCmdImageStartCapture, packing IMAGE_CAPTURED");
 		auto mavlinkCameraImageCaptured = Mav::Hlpr::CameraImageCaptured::make(imageCapture.sequence,
 			imageCapture.result, imageCapture.imageName.c_str());
@@ -302,6 +372,25 @@ Microservice::Ret Camera::processCmdImageStartCapture(mavlink_command_long_t &aM
 	return Ret::Response;
 }
 
+Microservice::Ret Camera::processCmdImageStopCapture(const mavlink_command_long_t &aMavlinkCommandLong,
+	mavlink_message_t &aMessage, Microservice::OnResponseSignature &aOnResponse)
+{
+	GS_UTILITY_LOG_SECTIOND(Mav::kDebugTag, "Camera::processCmdImageStopCapture");
+	auto result = MAV_RESULT_DENIED;
+
+	if (CameraRecorder::RecBurst::checkInstance() && CameraRecorder::RecBurst::getInstance().isActive()) {
+		CameraRecorder::RecBurst::getInstance().stop();
+		result = MAV_RESULT_ACCEPTED;
+	}
+
+	ESP_LOGI(Mav::kDebugTag, "Camera::processCmdImageStopCapture result %d", result);
+	Hlpr::MavlinkCommandAck::makeFrom(aMessage, aMavlinkCommandLong.command, result)
+		.packInto(aMessage, Globals::getCompIdCamera());
+	aOnResponse(aMessage);
+
+	return Ret::Response;
+}
+
 Microservice::Ret Camera::processCmdVideoStartCapture(const mavlink_command_long_t &aMavlinkCommandLong,
 	mavlink_message_t &aMessage, Microservice::OnResponseSignature &aOnResponse)
 {
@@ -469,14 +558,69 @@ Camera::ImageCapture Camera::processMakeShot(const mavlink_command_long_t &aMavl
 			history.imageCaptureSequence.push_back(imageCapture);
 		}
 	} else {
-		imageCapture.result = MAV_RESULT_UNSUPPORTED;
+		imageCapture = processMakeBurst(aMavlinkCommandLong);
+	}
+
+	return imageCapture;
+}
+
+/// \brief Takes `param3` shots (0 - until `MAV_CMD_IMAGE_STOP_CAPTURE`) every `param2` seconds. The camera's
+/// resolution is switched once for the whole burst, and each shot is reported w/ `CAMERA_IMAGE_CAPTURED` as soon as
+/// it has been written
+Camera::ImageCapture Camera::processMakeBurst(const mavlink_command_long_t &aMavlinkCommandLong)
+{
+	using namespace Mod;
+	ImageCapture imageCapture {static_cast<SequenceId>(aMavlinkCommandLong.param4),
+		static_cast<unsigned>(aMavlinkCommandLong.param3), MAV_RESULT_DENIED, ""};
+	const float interval = aMavlinkCommandLong.param2;
+
+	if (!CameraRecorder::RecBurst::checkInstance()) {
+		ESP_LOGE(Mav::kDebugTag, "%s::%s burst capturer instance is not initialized, cannot proceed", kLogPreamble,
+			__func__);
 
-		ESP_LOGW(Mav::kDebugTag, "Current implementation does not support periodic shots");
+		return imageCapture;
 	}
 
+	if (!(interval > 0.0f)) {
+		ESP_LOGW(Mav::kDebugTag, "%s::%s a burst requires a positive interval, got %f", kLogPreamble, __func__,
+			interval);
+
+		return imageCapture;
+	}
+
+	unsigned firstName = 0;
+	ModuleBase::moduleFieldReadIter<Module::Camera, Fld::Field::CaptureCount>(
+		[&firstName](unsigned aCount) { firstName = aCount; });
+	const bool started = CameraRecorder::RecBurst::getInstance().start({imageCapture.totalImages,
+		static_cast<std::int64_t>(interval * 1e6f), firstName,
+		[this](const CameraRecorder::RecBurst::Shot &aShot)
+		{
+			onBurstShot(aShot.name, aShot.ok, aShot.captureTimeUs);
+		}});
+	imageCapture.result = started ? MAV_RESULT_ACCEPTED : MAV_RESULT_FAILED;
+
+	ESP_LOGI(Mav::kDebugTag, "Camera::processMakeBurst, shots %u, interval %f s, first frame name \"%u\" "
+		"response code \"%d\"", imageCapture.totalImages, interval, firstName, imageCapture.result);
+
 	return imageCapture;
 }
 
+/// \brief `time_boot_ms` is the time the shot has actually been taken at, i.e. the frame's capture time, so the
+/// receiver may tell the per-shot latency
+void Camera::onBurstShot(unsigned aName, bool aOk, std::int64_t aCaptureTimeUs)
+{
+	auto imageCaptured = Hlpr::CameraImageCaptured::make(history.imageCaptureCount.fetch_add(aOk ? 1 : 0),
+		aOk ? 1 : 0, static_cast<int>(aName));
+
+	if (aCaptureTimeUs != 0) {
+		imageCaptured.time_boot_ms = static_cast<std::uint32_t>(aCaptureTimeUs / 1000);
+	}
+
+	mavlink_message_t mavlinkMessage;
+	imageCaptured.packInto(mavlinkMessage, Globals::getCompIdCamera());
+	notify(mavlinkMessage);
+}
+
 Camera::ImageCapture *Camera::History::findBySequence(Camera::SequenceId aSequence)
 {
 	auto it = std::find_if(imageCaptureSequence.begin(), imageCaptureSequence.end(),
@@ -12,6 +12,7 @@
 #include "DelayedSend.hpp"
 #include "utility/system/HrTimer.hpp"
 #include "utility/cont/CircularBuffer.hpp"
+#include <atomic>
 
 namespace Mav {
 namespace Mic {
@@ -29,7 +30,7 @@ private:
 
 	struct History {
 		Ut::Cont::CircularBuffer<ImageCapture, 4, true> imageCaptureSequence;  ///< Sequence numbers of processed capture requests
-		std::int32_t imageCaptureCount = 0;
+		std::atomic<std::int32_t> imageCaptureCount{0};  ///< Also updated by burst shots, from the writer's context
 		ImageCapture *findBySequence(SequenceId);
 	};
 
@@ -42,8 +43,12 @@ public:
 		OnResponseSignature aOnResponse);
 	Ret processRequestMessageCameraCaptureStatus(mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
 		OnResponseSignature aOnResponse);
+	Ret processRequestMessageDebugFloatArray(mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
+		OnResponseSignature aOnResponse);
 	Ret processCmdImageStartCapture(mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
 		OnResponseSignature aOnResponse);
+	Ret processCmdImageStopCapture(const mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
+		OnResponseSignature &aOnResponse);
 	Ret processCmdVideoStartCapture(const mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
 		OnResponseSignature &aOnResponse);
 	Ret processCmdVideoStopCapture(const mavlink_command_long_t &aMavlinkCommandLong, mavlink_message_t &aMessage,
@@ -52,6 +57,8 @@ public:
 
 private:
 	ImageCapture processMakeShot(const mavlink_command_long_t &aMavlinkCommandLong);
+	ImageCapture processMakeBurst(const mavlink_command_long_t &aMavlinkCommandLong);
+	void onBurstShot(unsigned aName, bool aOk, std::int64_t aCaptureTimeUs);
 
 private:
 	History history;
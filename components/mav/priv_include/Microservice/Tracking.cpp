@@ -23,6 +23,7 @@
 #include "utility/thr/WorkQueue.hpp"
 #include "module/ModuleBase.hpp"
 #include "mav/mav.hpp"
+#include <sdkconfig.h>
 
 GS_UTILITY_LOGV_CLASS_ASPECT_SET_ENABLED(Mav::Mic::Tracking, "messaging", 1);
 GS_UTILITY_LOGD_CLASS_ASPECT_SET_ENABLED(Mav::Mic::Tracking, "messaging", 1);
@@ -54,7 +55,7 @@ Microservice::Ret Tracking::process(mavlink_message_t &aMessage, Microservice::O
 				"target system %d  target component %d  command id %d", mavlinkCommandLong.target_system,
 				mavlinkCommandLong.target_component, mavlinkCommandLong.command);
 
-			if (mavlinkCommandLong.target_component == Globals::getCompIdTracker()
+			if (isCompIdTracker(mavlinkCommandLong.target_component)
 					&& mavlinkCommandLong.target_system == Globals::getSysId()) {
 				switch (mavlinkCommandLong.command) {
 					case MAV_CMD_SET_MESSAGE_INTERVAL:
@@ -85,17 +86,17 @@ Microservice::Ret Tracking::process(mavlink_message_t &aMessage, Microservice::O
 
 /// \brief The MAVLink tracking info message ("debug vector") only gets sent, when a tracker emits an event stating
 /// that a frame has been processed successfully. `processSetMessageInterval` enables / disables response to that
-/// event, and sends ACK according to the "command protocol".
+/// event, sets the rate the tracker publishes those events at, and sends ACK according to the "command protocol".
 Microservice::Ret Tracking::processCmdSetMessageInterval(mavlink_command_long_t &aMavlinkCommandLong,
 	mavlink_message_t &aMessage, Microservice::OnResponseSignature aOnResponse)
 {
 	auto ret = Microservice::Ret::Ignored;
 	constexpr int kTrackingDisable = -1;  // Disabled (https://mavlink.io/en/messages/common.html#MAV_CMD_SET_MESSAGE_INTERVAL)
-	constexpr int kTrackingEnablePerFrame = 0;  // Default frequency (https://mavlink.io/en/messages/common.html#MAV_CMD_SET_MESSAGE_INTERVAL)
+	constexpr int kTrackingEnableDefaultRate = 0;  // Default frequency (https://mavlink.io/en/messages/common.html#MAV_CMD_SET_MESSAGE_INTERVAL)
 	auto result = MAV_RESULT_ACCEPTED;
 
 	if (static_cast<int>(aMavlinkCommandLong.param1) == MAVLINK_MSG_ID_CAMERA_TRACKING_IMAGE_STATUS
-			&& aMavlinkCommandLong.target_component == Globals::getCompIdTracker()
+			&& isCompIdTracker(aMavlinkCommandLong.target_component)
 			&& aMavlinkCommandLong.target_system == Globals::getSysId()) {
 		ret = Microservice::Ret::Response;
 
@@ -106,20 +107,28 @@ Microservice::Ret Tracking::processCmdSetMessageInterval(mavlink_command_long_t
 
 				break;
 
-			case kTrackingEnablePerFrame:
-				// Enable event response
+			case kTrackingEnableDefaultRate:
+				// Enable event response at the default rate
+				result = setTelemetryPeriod(CONFIG_TRACKING_TELEMETRY_PERIOD_MS * 1000) ? MAV_RESULT_ACCEPTED :
+					MAV_RESULT_FAILED;
 				key.onMosseTrackerUpdate.setEnabled(true);
 
 				break;
 
 			default:
-				result = MAV_RESULT_DENIED;
+				if (aMavlinkCommandLong.param2 > 0.0f) {  // Interval, us
+					result = setTelemetryPeriod(static_cast<std::uint32_t>(aMavlinkCommandLong.param2)) ?
+						MAV_RESULT_ACCEPTED : MAV_RESULT_FAILED;
+					key.onMosseTrackerUpdate.setEnabled(result == MAV_RESULT_ACCEPTED);
+				} else {
+					result = MAV_RESULT_DENIED;
+				}
 		}
 	}
 
 	{
 		auto ack = Hlpr::MavlinkCommandAck::makeFrom(aMessage, aMavlinkCommandLong.command, result);
-		ack.packInto(aMessage, Globals::getCompIdTracker());
+		ack.packInto(aMessage, aMavlinkCommandLong.target_component);
 		aOnResponse(aMessage);
 	}
 
@@ -162,7 +171,7 @@ Microservice::Ret Tracking::processCmdCameraTrackRectangle(mavlink_command_long_
 		GS_UTILITY_LOGD_CLASS_ASPECT(Mav::kDebugTag, Tracking, "messaging",
 			"Tracking: left %d  top %d  right %d  bottom %d  frame height %d  frame width %d", topLeftX, topLeftY,
 			bottomRightX, bottomRightY, cameraState.frameHeight, cameraState.frameWidth);
-		bool notified = false;
+		bool notified = selectTarget(aMavlinkCommandLong.target_component);
 		// The tracking module is not async, safe to not to implement a waiting routine
 		Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Tracking, Mod::Fld::Field::Roi>(rect,
 			[&result, &notified](Mod::Fld::WriteResp aResp) mutable
@@ -175,14 +184,14 @@ Microservice::Ret Tracking::processCmdCameraTrackRectangle(mavlink_command_long_
 			});
 
 		if (!notified) {
-			ESP_LOGW(Mav::kDebugTag, "Unable to access tracking module");
+			ESP_LOGW(Mav::kDebugTag, "Unable to access tracking module, or select the target");
 			result = MAV_RESULT_FAILED;
 		}
 	}
 
 	{
 		auto ack = Hlpr::MavlinkCommandAck::makeFrom(aMessage, aMavlinkCommandLong.command, result);
-		ack.packInto(aMessage, Globals::getCompIdTracker());
+		ack.packInto(aMessage, aMavlinkCommandLong.target_component);
 		aOnResponse(aMessage);
 	}
 
@@ -198,16 +207,20 @@ Microservice::Ret Tracking::processCmdCameraStopTracking(mavlink_command_long_t
 	mavlink_message_t &aMessage, Microservice::OnResponseSignature aOnResponse)
 {
 	auto result = MAV_RESULT_FAILED;
-	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Tracking, Mod::Fld::Field::Initialized>(false,
-		[&result](Mod::Fld::WriteResp aResp) mutable
-		{
-			if (aResp.isOk()) {
-				result = MAV_RESULT_ACCEPTED;
-			}
-		});
+
+	if (selectTarget(aMavlinkCommandLong.target_component)) {
+		Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Tracking, Mod::Fld::Field::Initialized>(false,
+			[&result](Mod::Fld::WriteResp aResp) mutable
+			{
+				if (aResp.isOk()) {
+					result = MAV_RESULT_ACCEPTED;
+				}
+			});
+	}
+
 	{
 		auto ack = Hlpr::MavlinkCommandAck::makeFrom(aMessage, aMavlinkCommandLong.command, result);
-		ack.packInto(aMessage, Globals::getCompIdTracker());
+		ack.packInto(aMessage, aMavlinkCommandLong.target_component);
 		aOnResponse(aMessage);
 	}
 
@@ -251,7 +264,40 @@ void Tracking::onMosseTrackerUpdate(Sub::Trk::MosseTrackerUpdate aMosseTrackerUp
 	mavlinkCameraTrackingImageStatus.point_x = std::numeric_limits<float>::quiet_NaN();
 	mavlinkCameraTrackingImageStatus.point_y = std::numeric_limits<float>::quiet_NaN();
 	mavlinkCameraTrackingImageStatus.radius = std::numeric_limits<float>::quiet_NaN();
-	notify(DelayedSendAsyncCtx{Globals::getSysId(), Globals::getCompIdTracker(), mavlinkCameraTrackingImageStatus});
+	notify(DelayedSendAsyncCtx{Globals::getSysId(), Globals::getCompIdTracker(aMosseTrackerUpdate.target),
+		mavlinkCameraTrackingImageStatus});
+}
+
+bool Tracking::setTelemetryPeriod(std::uint32_t aPeriodUs)
+{
+	bool success = false;
+	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Tracking, Mod::Fld::Field::TelemetryPeriod>(aPeriodUs,
+		[&success](Mod::Fld::WriteResp aResp) mutable
+		{
+			success = aResp.isOk();
+		});
+
+	return success;
+}
+
+bool Tracking::isCompIdTracker(int aCompId)
+{
+	return aCompId >= Globals::getCompIdTracker() && aCompId < Globals::getCompIdTracker(CONFIG_TRACKING_MAX_TARGETS);
+}
+
+/// \brief Makes the target the subsequent tracking module requests address. The tracking module is not async, so the
+/// selection holds until the request has been made
+bool Tracking::selectTarget(int aCompId)
+{
+	bool success = false;
+	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Tracking, Mod::Fld::Field::Target>(
+		static_cast<std::int32_t>(aCompId - Globals::getCompIdTracker()),
+		[&success](Mod::Fld::WriteResp aResp) mutable
+		{
+			success = aResp.isOk();
+		});
+
+	return success;
 }
 
 void Tracking::CameraState::fetch()
@@ -35,12 +35,18 @@ namespace Mic {
 /// - CAMERA_TRACKING_IMAGE_STATUS (https://mavlink.io/en/messages/common.html#CAMERA_TRACKING_IMAGE_STATUS)
 /// 	- Used as per the protocol
 /// - MAV_CMD_SET_MESSAGE_INTERVAL (https://mavlink.io/en/messages/common.html#MAV_CMD_SET_MESSAGE_INTERVAL)
-/// 	- `param2`: only `-1` and `0` values are supported
+/// 	- `param2`:
 /// 		- `-1` - Do not track
-/// 		- `0` - Send message on every frame
+/// 		- `0` - Send message at the default rate, `CONFIG_TRACKING_TELEMETRY_PERIOD_MS`
+/// 		- `> 0` - Interval, us. Only the newest state of each target is sent once an interval
 /// - MAV_CMD_ACK (https://mavlink.io/en/messages/common.html#MAV_CMD_ACK)
 /// 	- Used as per the protocol
 ///
+/// Each of the `CONFIG_TRACKING_MAX_TARGETS` tracked objects is addressed as a camera component of its own,
+/// `Globals::getCompIdTracker(target)`, as CAMERA_TRACKING_IMAGE_STATUS has no field to tell them apart. The ids
+/// start at `CONFIG_MAV_COMP_ID_TRACKER_FIRST` (MAV_COMP_ID_CAMERA2 by default), w/ more than one target, the range
+/// has to be kept clear of the system's other cameras.
+///
 /// Sequence to start tracking:
 /// - Client sends MAV_CMD_CAMERA_TRACK_RECTANGLE
 /// - Tracker responds MAV_CMD_ACK
@@ -90,6 +96,11 @@ public:
 		OnResponseSignature aOnResponse);
 	void onMosseTrackerUpdate(Sub::Trk::MosseTrackerUpdate);
 private:
+	static bool isCompIdTracker(int aCompId);
+	static bool selectTarget(int aCompId);
+	/// \brief Sets the period the tracker publishes its updates w/
+	static bool setTelemetryPeriod(std::uint32_t aPeriodUs);
+
 	Key key;
 	CameraState cameraState;
 };
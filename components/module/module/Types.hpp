@@ -31,6 +31,14 @@ enum class Module : std::uint8_t {
 	/// Fields, semantics:
 	/// - Initialized - set FALSE to disable tracking.
 	/// - Roi - bounding rectangle. Set to activate or reset tracking algorithm.
+	/// - Target - the target (0 to `CONFIG_TRACKING_MAX_TARGETS - 1`) the subsequent Roi and Initialized writes
+	///   address. -1 - every target, only valid for Initialized.
+	/// - RecoveryTime, RecoveryCost - read-only. Re-acquisition of the selected target after it has been lost: the time
+	///   the latest one has taken, ms, and the search time per frame, us.
+	/// - TelemetryPeriod - the tracker's updates are published once a period, us, only the newest one of each target.
+	///   0 - every update.
+	/// - CorePin, Priority - policy of the tracker's worker threads, see `Trk::Workers`. The priority is applied to
+	///   the running threads, the pinning can only be changed before the first tracker has been made.
 	Tracking,
 	/// \brief Wi-Fi access point
 	WifiAp,
@@ -63,6 +71,12 @@ enum class Field : std::uint8_t {
 	Password,  ///< Password. Wi-Fi STA, or AP
 	RestoreState,  ///< If set, the module will attempt to restore its state (which resides in some non-volatile storage)
 	Mac,  ///< Mac address of Wi-Fi network
+	CorePin,  ///< Cores threads are pinned to. Module=Tracking - (1st, 2nd) worker thread, -1 - not pinned
+	Priority,  ///< Priority of threads. Module=Tracking - worker threads
+	Target,  ///< Object addressed by the subsequent requests. Module=Tracking - tracked object's index, -1 - all
+	RecoveryTime,  ///< Time a recovery has taken, ms
+	RecoveryCost,  ///< CPU time a recovery takes per frame, us
+	TelemetryPeriod,  ///< Period of publishing state updates, us
 };
 
 template <class T>
@@ -89,6 +103,12 @@ template <Module I> struct GetType<Field::StringIdentifier, I> : StoreType<std::
 template <Module I> struct GetType<Field::Password, I> : StoreType<std::string> {};
 template <Module I> struct GetType<Field::RestoreState, I> : StoreType<std::int32_t> {};
 template <Module I> struct GetType<Field::Mac, I> : StoreType<std::array<std::uint8_t, 6> *> {};
+template <> struct GetType<Field::CorePin, Module::Tracking> : StoreType<std::pair<int, int>> {};
+template <> struct GetType<Field::Priority, Module::Tracking> : StoreType<std::int32_t> {};
+template <> struct GetType<Field::Target, Module::Tracking> : StoreType<std::int32_t> {};
+template <> struct GetType<Field::RecoveryTime, Module::Tracking> : StoreType<std::uint32_t> {};
+template <> struct GetType<Field::RecoveryCost, Module::Tracking> : StoreType<std::uint32_t> {};
+template <> struct GetType<Field::TelemetryPeriod, Module::Tracking> : StoreType<std::uint32_t> {};
 
 struct Variant : public Mod::Variant {
 	using Mod::Variant::Variant;
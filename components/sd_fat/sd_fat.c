@@ -13,6 +13,7 @@
 #include <diskio_impl.h>
 #include <freertos/FreeRTOS.h>
 #include <esp_log.h>
+#include "sd_fat.h"
 
 #ifndef FF_DRV_NOT_USED
 # define FF_DRV_NOT_USED 0xFF
@@ -24,6 +25,10 @@ static BYTE pdrv = FF_DRV_NOT_USED;  // Not Used
 static const char *kTag = "[sd_fat]";
 static FATFS *sFatfs = NULL;
 static char fatDrivePath[] = {'\0', ':', '\0'};
+static unsigned sGeneration = 0;
+static unsigned sGenerationMounted = ~0u;  ///< Generation the mount callback has been invoked for
+static void (*sOnMounted)(void *) = NULL;
+static void *sOnMountedArg = NULL;
 
 static esp_err_t deinitializeSlot();
 static esp_err_t mountFat();
@@ -301,6 +306,14 @@ bool sdFatInit()
 
 	ESP_LOGI(kTag, "initializing SD card -- success");
 
+	if (sGenerationMounted != sGeneration) {
+		sGenerationMounted = sGeneration;
+
+		if (sOnMounted != NULL) {
+			sOnMounted(sOnMountedArg);
+		}
+	}
+
 	return true;
 }
 
@@ -342,10 +355,49 @@ bool sdFatDeinit()
 	}
 
 	sdFatStateReset();
+	++sGeneration;
 
 	return (err == ESP_OK);
 }
 
+unsigned sdFatGeneration()
+{
+	return sGeneration;
+}
+
+void sdFatSetOnMounted(void (*aCallback)(void *aArg), void *aArg)
+{
+	sOnMountedArg = aArg;
+	sOnMounted = aCallback;
+}
+
+bool sdFatForEachFile(void (*aCallback)(const char *aName, uint32_t aSize, void *aArg), void *aArg)
+{
+	if (sdFatStateIsReset()) {
+		return false;
+	}
+
+	FF_DIR dir;
+	FILINFO info;
+	FRESULT res = f_opendir(&dir, fatDrivePath);
+
+	if (res != FR_OK) {
+		ESP_LOGW(kTag, "sdFatForEachFile (open directory) -- FATFS error %d", (int)res);
+
+		return false;
+	}
+
+	while ((res = f_readdir(&dir, &info)) == FR_OK && info.fname[0] != '\0') {
+		if (!(info.fattrib & AM_DIR)) {
+			aCallback(info.fname, (uint32_t)info.fsize, aArg);
+		}
+	}
+
+	f_closedir(&dir);
+
+	return (res == FR_OK);
+}
+
 /// \brief Attemps to write to a file. May be used as an indication that
 /// configuration has completed successfully.
 static esp_err_t sdFatWriteTest()
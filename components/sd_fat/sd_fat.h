@@ -11,6 +11,9 @@
 #ifndef SDFTP_SDFTP_H
 #define SDFTP_SDFTP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +21,22 @@ extern "C" {
 bool sdFatInit();
 bool sdFatDeinit();
 
+/// \brief Incremented every time the card gets unmounted, so a cache of the
+/// file system's contents may tell, whether it is still valid
+unsigned sdFatGeneration();
+
+/// \brief Sets the callback invoked from `sdFatInit` in the caller's context,
+/// once the card has been mounted anew, i.e. w/ a new generation. Only one
+/// callback is supported.
+void sdFatSetOnMounted(void (*aCallback)(void *aArg), void *aArg);
+
+/// \brief Invokes `aCallback` for each file in the root directory. The
+/// directory is read through FATFS directly, so the sizes come w/o a `stat`
+/// per file.
+/// \returns false, if the card is not mounted, or the directory could not be
+/// read
+bool sdFatForEachFile(void (*aCallback)(const char *aName, uint32_t aSize, void *aArg), void *aArg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -44,11 +44,11 @@ using NoLockKey = Rr::Util::Key<Tsignature, NoSyncTrait, std::list, Ttopic>;
 
 namespace Key {
 
-using NewFrameEvent = const typename std::shared_ptr<Cam::Frame> &;
+using NewFrameEvent = const Cam::FramePtr &;
 
 // Obsolete Rr::Subscription::Key
 using TcpConnected     = IndKey<void(asio::ip::address, Port), Topic::TcpConnected>;
-using NewFrame         = IndKey<void(NewFrameEvent), Topic::NewFrame>;  // TODO: considering frame rate, using `shared_ptr` is not a very smart move: mind the allocations it entails
+using NewFrame         = IndKey<void(NewFrameEvent), Topic::NewFrame>;
 using TcpDisconnected  = IndKey<void(asio::ip::address), Topic::TcpDisconnected>;
 using WifiDisconnected = IndKey<void(asio::ip::address), Topic::WifiDisconnected>;
 
@@ -25,6 +25,8 @@ struct MosseTrackerUpdate {
 	int roiHeight;
 	/// False means the tracker has lost the target. It can be updated w/ a new ROI.
 	bool stateOk;
+	/// Index of the tracked object, see `Mod::Fld::Field::Target`
+	int target;
 };
 
 using OnMosseTrackerUpdate = IndKey<void(MosseTrackerUpdate)>;
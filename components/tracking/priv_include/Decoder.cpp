@@ -0,0 +1,114 @@
+//
+// Decoder.cpp
+//
+
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_TRACKING_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include "tracking/tracking.hpp"
+#include "Decoder.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace Trk {
+
+Decoder::Decoder(unsigned aScale) :
+	scale{static_cast<jpg_scale_t>(std::min<unsigned>(std::max<unsigned>(aScale, JPG_SCALE_2X), JPG_SCALE_MAX))},
+	jpeg{nullptr},
+	jpegSize{0},
+	buffer{},
+	capacity{0},
+	nrows{0},
+	ncols{0}
+{
+}
+
+bool Decoder::decode(const std::uint8_t *aJpeg, std::size_t aSize)
+{
+	jpeg = aJpeg;
+	jpegSize = aSize;
+	const bool ok = esp_jpg_decode(aSize, scale, onRead, onWrite, this) == ESP_OK;
+	jpeg = nullptr;
+
+	return ok && nrows > 0 && ncols > 0;
+}
+
+std::size_t Decoder::onRead(void *aDecoder, std::size_t aOffset, std::uint8_t *aBuffer, std::size_t aSize)
+{
+	Decoder &decoder = *static_cast<Decoder *>(aDecoder);
+
+	if (aOffset >= decoder.jpegSize) {
+		return 0;
+	}
+
+	aSize = std::min(aSize, decoder.jpegSize - aOffset);
+
+	if (aBuffer != nullptr) {  // Otherwise, the input is skipped
+		std::memcpy(aBuffer, decoder.jpeg + aOffset, aSize);
+	}
+
+	return aSize;
+}
+
+void Decoder::release()
+{
+	buffer.reset();
+	capacity = 0;
+	nrows = 0;
+	ncols = 0;
+}
+
+void Decoder::allocate(std::size_t aSize)
+{
+	buffer.reset();  // Before the new one, so the old one's memory may be reused
+	buffer.reset(new (std::nothrow) std::uint8_t[aSize]);
+	capacity = buffer ? aSize : 0;
+}
+
+/// \brief Converts RGB888 to luma, ITU-R BT.601 fixed point
+bool Decoder::onWrite(void *aDecoder, std::uint16_t aX, std::uint16_t aY, std::uint16_t aW, std::uint16_t aH,
+	std::uint8_t *aData)
+{
+	Decoder &decoder = *static_cast<Decoder *>(aDecoder);
+
+	if (aData == nullptr) {
+		if (aX == 0 && aY == 0) {  // Start. The size of the downscaled image is known
+			const std::size_t size = static_cast<std::size_t>(aW) * aH;
+
+			if (size > decoder.capacity) {
+				decoder.allocate(size);
+
+				if (!decoder.buffer) {
+					ESP_LOGW(Trk::kDebugTag, "Decoder: failed to allocate %u B for %ux%u frames",
+						static_cast<unsigned>(size), static_cast<unsigned>(aW), static_cast<unsigned>(aH));
+				}
+			}
+
+			decoder.nrows = decoder.buffer ? aH : 0;
+			decoder.ncols = decoder.buffer ? aW : 0;
+
+			return static_cast<bool>(decoder.buffer);
+		}
+
+		return true;
+	}
+
+	if (aX + aW > decoder.ncols || aY + aH > decoder.nrows) {
+		return false;
+	}
+
+	for (int row = 0; row < aH; ++row) {
+		std::uint8_t *out = decoder.buffer.get() + (aY + row) * decoder.ncols + aX;
+
+		for (int col = 0; col < aW; ++col, aData += 3) {
+			out[col] = static_cast<std::uint8_t>((77 * aData[0] + 150 * aData[1] + 29 * aData[2]) >> 8);
+		}
+	}
+
+	return true;
+}
+
+}  // namespace Trk
@@ -0,0 +1,71 @@
+//
+// Decoder.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_DECODER_HPP_)
+#define TRACKING_PRIV_INCLUDE_DECODER_HPP_
+
+#include <esp_jpg_decode.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Trk {
+
+/// \brief Decodes JPEG frames into downscaled 8-bit grayscale images, so the camera may keep on producing JPEG for
+/// the streamer, and the recorder while the target is being tracked.
+///
+/// \details Downscaling is done by the decoder itself (tjpgd), which skips the high frequency coefficients. At 1/8,
+/// only the DC coefficients are used, and no IDCT is performed at all.
+///
+/// \details The image is stored on the heap. The buffer is allocated on the first frame of a tracking session, it only
+/// grows w/ the frame size, and it is released once the session is over, see `release()`. `esp_jpg_decode` uses a
+/// static work area, so there must not be more than one decoding at a time.
+class Decoder {
+public:
+	/// \param aScale 1 / 2^`aScale`, [1; 3]
+	Decoder(unsigned aScale);
+
+	/// \returns false, if the frame could not be decoded
+	bool decode(const std::uint8_t *aJpeg, std::size_t aSize);
+
+	/// \brief Frees the image's buffer. The next decoding allocates it anew
+	void release();
+
+	std::uint8_t *data()
+	{
+		return buffer.get();
+	}
+
+	/// \brief The latest decoded image's
+	int rows() const
+	{
+		return nrows;
+	}
+
+	int cols() const
+	{
+		return ncols;
+	}
+
+private:
+	void allocate(std::size_t aSize);
+	static std::size_t onRead(void *aDecoder, std::size_t aOffset, std::uint8_t *aBuffer, std::size_t aSize);
+	/// \brief Outputs a block of RGB888 pixels. W/ `aData == nullptr`, marks the beginning (x = y = 0), or the end
+	/// of the image
+	static bool onWrite(void *aDecoder, std::uint16_t aX, std::uint16_t aY, std::uint16_t aW, std::uint16_t aH,
+		std::uint8_t *aData);
+
+private:
+	jpg_scale_t scale;
+	const std::uint8_t *jpeg;  ///< The frame being decoded
+	std::size_t jpegSize;
+	std::unique_ptr<std::uint8_t[]> buffer;
+	std::size_t capacity;
+	int nrows;
+	int ncols;
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_DECODER_HPP_
@@ -0,0 +1,89 @@
+//
+// Motion.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_MOTION_HPP_)
+#define TRACKING_PRIV_INCLUDE_MOTION_HPP_
+
+#include <cmath>
+
+namespace Trk {
+
+/// \brief Constant-velocity (alpha-beta) filter on the target's center.
+///
+/// \details The tracker's measurements are noisy, and may be missing for some frames (e.g. when the tracker is not
+/// updated on every frame, or the measurement is not trusted), so the time between measurements is passed explicitly,
+/// in frames.
+class Motion {
+public:
+	struct Point {
+		float x;
+		float y;
+	};
+
+	/// \param aAlpha Position gain, (0; 1]
+	/// \param aBeta Velocity gain, (0; 1]
+	Motion(float aAlpha = 0.5f, float aBeta = 0.2f) :
+		alpha{aAlpha},
+		beta{aBeta},
+		position{0.0f, 0.0f},
+		speed{0.0f, 0.0f},
+		initialized{false}
+	{
+	}
+
+	/// \brief Starts over at the position, w/ no velocity
+	void reset(Point aPosition)
+	{
+		position = aPosition;
+		speed = {0.0f, 0.0f};
+		initialized = true;
+	}
+
+	/// \param aFrames Frames passed since the previous measurement
+	void update(Point aMeasured, unsigned aFrames = 1)
+	{
+		if (!initialized) {
+			reset(aMeasured);
+
+			return;
+		}
+
+		const float dt = static_cast<float>(aFrames > 0 ? aFrames : 1);
+		const Point predicted = predict(aFrames);
+		const Point residual{aMeasured.x - predicted.x, aMeasured.y - predicted.y};
+		position = {predicted.x + alpha * residual.x, predicted.y + alpha * residual.y};
+		speed = {speed.x + beta * residual.x / dt, speed.y + beta * residual.y / dt};
+	}
+
+	/// \brief Expected position in `aFrames` frames after the latest measurement
+	Point predict(unsigned aFrames = 1) const
+	{
+		const float dt = static_cast<float>(aFrames);
+
+		return {position.x + speed.x * dt, position.y + speed.y * dt};
+	}
+
+	/// \brief Pixels per frame
+	Point velocity() const
+	{
+		return speed;
+	}
+
+	/// \brief Pixels per frame
+	float speedAbs() const
+	{
+		return std::sqrt(speed.x * speed.x + speed.y * speed.y);
+	}
+
+private:
+	float alpha;
+	float beta;
+	Point position;
+	Point speed;
+	bool initialized;
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_MOTION_HPP_
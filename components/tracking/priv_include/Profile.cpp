@@ -12,6 +12,7 @@
 #include "module/ModuleBase.hpp"
 #include "tracking/tracking.hpp"
 #include "Profile.hpp"
+#include "bench/Metrics.hpp"
 #include "port/Thread.hpp"
 #include "utility/LogSection.hpp"
 #include "utility/time.hpp"
@@ -44,14 +45,8 @@ struct FpsCounter {
 	float onFrame()
 	{
 		timestamps.push_back(std::chrono::microseconds{Ut::bootTimeUs()});
-		float ret = 0.0f;
 
-		if (timestamps.size() > 1) {
-			ret = static_cast<float>(timestamps.size() + timestamps.capacity()) / (static_cast<float>((timestamps.back()
-				- timestamps.front()).count()) / 1000000.0f);
-		}
-
-		return ret;
+		return Bench::fps(timestamps.size(), (timestamps.back() - timestamps.front()).count());
 	}
 };
 
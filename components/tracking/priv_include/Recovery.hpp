@@ -0,0 +1,188 @@
+//
+// Recovery.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_RECOVERY_HPP_)
+#define TRACKING_PRIV_INCLUDE_RECOVERY_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace Trk {
+
+/// \brief Re-acquires a lost target by a coarse search over the whole frame.
+///
+/// \details A decimated template of the target is captured while it is tracked well. Once the target is lost, the
+/// template is matched (zero-normalized cross-correlation) against the frame at every `stride`-th position. The
+/// search is split into bands of rows, one band per frame, so the cost per frame is bounded. Once the whole frame has
+/// been swept, the best match is reported, if it is good enough.
+///
+/// \details 8-bit grayscale frames, row-major, w/o padding. No memory is allocated.
+class Recovery {
+public:
+	static constexpr int kTemplateSideMax = 16;  ///< Template side, decimated samples
+	static constexpr int kStrideMin = 2;  ///< Decimation, pixels
+	static constexpr float kScoreMin = 0.7f;  ///< ZNCC of a match
+
+	struct Match {
+		int row;  ///< Top left corner of the ROI, pixels
+		int col;
+		float score;
+	};
+
+	Recovery() :
+		samples{},
+		nrows{0},
+		ncols{0},
+		stride{kStrideMin},
+		roiRows{0},
+		roiCols{0},
+		mean{0.0f},
+		norm{0.0f},
+		sweepRow{0},
+		best{0, 0, -1.0f}
+	{
+	}
+
+	/// \brief Captures the template of the ROI
+	/// \returns false, if the ROI does not fit the frame, or has no texture
+	bool capture(const std::uint8_t *aFrame, int aFrameRows, int aFrameCols, int aRow, int aCol, int aRows, int aCols)
+	{
+		if (aRow < 0 || aCol < 0 || aRows <= 0 || aCols <= 0 || aRow + aRows > aFrameRows
+				|| aCol + aCols > aFrameCols) {
+			return false;
+		}
+
+		const int side = std::max(aRows, aCols);
+		const int sideMax = kTemplateSideMax;  // `std::min` would ODR-use the constant
+		stride = std::max((side + sideMax - 1) / sideMax, static_cast<int>(kStrideMin));
+		nrows = std::min(sideMax, aRows / stride);
+		ncols = std::min(sideMax, aCols / stride);
+		roiRows = aRows;
+		roiCols = aCols;
+		float sum = 0.0f;
+		float sumSq = 0.0f;
+
+		for (int r = 0; r < nrows; ++r) {
+			for (int c = 0; c < ncols; ++c) {
+				const std::uint8_t value = aFrame[(aRow + r * stride) * aFrameCols + aCol + c * stride];
+				samples[r * kTemplateSideMax + c] = value;
+				sum += value;
+				sumSq += static_cast<float>(value) * value;
+			}
+		}
+
+		const float n = static_cast<float>(nrows * ncols);
+		mean = n > 0.0f ? sum / n : 0.0f;
+		norm = n > 0.0f ? std::sqrt(std::max(sumSq - n * mean * mean, 0.0f)) : 0.0f;
+
+		if (!hasTemplate()) {
+			nrows = 0;
+			ncols = 0;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	bool hasTemplate() const
+	{
+		return nrows > 0 && ncols > 0 && norm > 1.0f;
+	}
+
+	/// \brief Starts a new sweep
+	void start()
+	{
+		sweepRow = 0;
+		best = {0, 0, -1.0f};
+	}
+
+	/// \brief Matches the template at the candidate positions of the next band of rows
+	/// \param aSweepFrames Number of steps (frames) the sweep is split into
+	/// \returns true, if the sweep is complete
+	bool step(const std::uint8_t *aFrame, int aFrameRows, int aFrameCols, int aSweepFrames)
+	{
+		const int rows = candidateRows(aFrameRows);
+		const int rowsPerStep = aSweepFrames > 1 ? (rows + aSweepFrames - 1) / aSweepFrames : rows;
+		const int rowEnd = std::min(rows, sweepRow + std::max(rowsPerStep, 1));
+		const int colEnd = aFrameCols - roiCols;
+
+		for (; sweepRow < rowEnd; ++sweepRow) {
+			const int row = sweepRow * stride;
+
+			for (int col = 0; col <= colEnd; col += stride) {
+				const float score = zncc(aFrame, aFrameCols, row, col);
+
+				if (score > best.score) {
+					best = {row, col, score};
+				}
+			}
+		}
+
+		return sweepRow >= candidateRows(aFrameRows);
+	}
+
+	/// \brief Valid once the sweep is complete
+	bool found() const
+	{
+		return best.score >= kScoreMin;
+	}
+
+	const Match &match() const
+	{
+		return best;
+	}
+
+private:
+	int candidateRows(int aFrameRows) const
+	{
+		return aFrameRows >= roiRows ? (aFrameRows - roiRows) / stride + 1 : 0;
+	}
+
+	float zncc(const std::uint8_t *aFrame, int aFrameCols, int aRow, int aCol) const
+	{
+		float sum = 0.0f;
+		float sumSq = 0.0f;
+		float cross = 0.0f;
+
+		for (int r = 0; r < nrows; ++r) {
+			const std::uint8_t *row = aFrame + (aRow + r * stride) * aFrameCols + aCol;
+			const std::uint8_t *sample = &samples[r * kTemplateSideMax];
+
+			for (int c = 0; c < ncols; ++c) {
+				const float value = row[c * stride];
+				sum += value;
+				sumSq += value * value;
+				cross += value * static_cast<float>(sample[c]);
+			}
+		}
+
+		const float n = static_cast<float>(nrows * ncols);
+		const float normCandidate = std::sqrt(std::max(sumSq - sum * sum / n, 0.0f));
+
+		if (normCandidate < 1.0f) {  // No texture
+			return -1.0f;
+		}
+
+		return (cross - sum * mean) / (normCandidate * norm);
+	}
+
+private:
+	std::array<std::uint8_t, kTemplateSideMax * kTemplateSideMax> samples;
+	int nrows;  ///< Template size, decimated samples
+	int ncols;
+	int stride;  ///< Decimation, pixels
+	int roiRows;  ///< ROI size the template has been captured from, pixels
+	int roiCols;
+	float mean;  ///< Template's
+	float norm;  ///< Template's, sqrt(sum((x - mean)^2))
+	int sweepRow;  ///< Next candidate row, decimated
+	Match best;
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_RECOVERY_HPP_
@@ -0,0 +1,260 @@
+//
+// Target.cpp
+//
+
+#include "Target.hpp"
+#include <algorithm>
+
+namespace Trk {
+
+static constexpr float kRecentreSpeedMin = 2.0f;  ///< Pixels per frame. A slower lost target is not looked for
+static constexpr float kSteadyPsrFactor = 3.0f;  ///< Steady target's PSR, multiple of the lower threshold
+static constexpr float kSteadyShiftFraction = 0.125f;  ///< Steady target's shift over the stride, fraction of the ROI side
+static constexpr unsigned kTemplatePeriod = 16;  ///< Frames between recovery template captures
+
+/// \brief Keeps the ROI inside the frame, w/ a margin of 1 pixel, see `Tracking::targetInit`
+static void roiClamp(Mosse::Tp::Roi &aRoi, const Mosse::Tp::Image &aImage)
+{
+	aRoi.origin(0) = std::min<Eigen::Index>(std::max<Eigen::Index>(aRoi.origin(0), 1),
+		aImage.rows() - aRoi.size(0) - 1);
+	aRoi.origin(1) = std::min<Eigen::Index>(std::max<Eigen::Index>(aRoi.origin(1), 1),
+		aImage.cols() - aRoi.size(1) - 1);
+}
+
+static Motion::Point roiCenter(const Mosse::Tp::Roi &aRoi)
+{
+	return {static_cast<float>(aRoi.origin(1)) + static_cast<float>(aRoi.size(1)) / 2.0f,
+		static_cast<float>(aRoi.origin(0)) + static_cast<float>(aRoi.size(0)) / 2.0f};
+}
+
+bool Target::init(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi)
+{
+	trackerInit(aImage, aRoi);
+	quality.reset();
+	motion.reset(roiCenter(aRoi));
+	nFramesUnmeasured = 0;
+	nFramesSkipped = 0;
+	recentre = false;
+	recentred = false;
+	recovering = false;
+	step = Step::None;
+
+	return capture(aImage, aRoi);
+}
+
+Target::Event Target::preprocess(Mosse::Tp::Image &aImage, const Params &aParams)
+{
+	++nFramesUnmeasured;
+
+	if (!quality.isOk() && recovery.hasTemplate()) {  // Do not update blindly, look for it
+		return recover(aImage, aParams);
+	}
+
+	if (recentre) {
+		recentreAt(aImage);
+		step = Step::Predicted;
+
+		return Event::Recentred;
+	}
+
+	if (++nFramesSkipped < stride(aParams.strideMax)) {  // Steady target. Skip the update
+		step = Step::Predicted;
+
+		return Event::None;
+	}
+
+	nFramesSkipped = 0;
+
+	// Refresh the template, while the target is tracked well
+	if (++nFramesTemplate >= kTemplatePeriod && quality.psr >= kSteadyPsrFactor * quality.lowerThreshold()) {
+		capture(aImage, predict());
+	}
+
+	workingAreaReset();
+	workingArea.initialize(tracker->imageCropWorkingArea(aImage));
+	step = Step::Updated;
+
+	return Event::None;
+}
+
+Target::Event Target::update()
+{
+	tracker->update(*workingArea.getInstance(), true);
+	const float psr = std::max(tracker->lastPsr(), 0.0f);
+
+	if (measure(psr) && quality.update(psr)) {
+		return Event::QualityDropped;
+	}
+
+	return Event::None;
+}
+
+/// \brief The working area is released, as it may own a buffer
+Mosse::Tp::Roi Target::conclude()
+{
+	const auto roi = step == Step::Predicted ? predict() : tracker->roi();
+	step = Step::None;
+	workingAreaReset();
+
+	return roi;
+}
+
+/// \brief A low PSR is not trusted. A target moving fast enough may have left the search window, in which case the
+/// tracker is re-centered at the predicted position once, before the quality latch is tripped
+bool Target::measure(float aPsr)
+{
+	if (aPsr >= quality.lowerThreshold()) {
+		motion.update(roiCenter(tracker->roi()), nFramesUnmeasured);
+		nFramesUnmeasured = 0;
+		recentred = false;
+
+		return true;
+	}
+
+	if (!recentred && motion.speedAbs() >= kRecentreSpeedMin) {
+		quality.psr = aPsr;
+		recentre = true;
+
+		return false;
+	}
+
+	return true;
+}
+
+/// \brief A target w/ a high PSR which is expected to move by a small fraction of its size over the stride is steady
+unsigned Target::stride(unsigned aStrideMax) const
+{
+	const auto roi = tracker->roi();
+	const float side = static_cast<float>(std::min(roi.size(0), roi.size(1)));
+	const bool steady = quality.isOk() && quality.psr >= kSteadyPsrFactor * quality.lowerThreshold()
+		&& motion.speedAbs() * static_cast<float>(aStrideMax) < side * kSteadyShiftFraction;
+
+	return steady ? aStrideMax : 1;
+}
+
+/// \brief The ROI of the size the tracker has, centered at the predicted position
+Mosse::Tp::Roi Target::predict() const
+{
+	Mosse::Tp::Roi roi = tracker->roi();
+	const auto center = motion.predict(nFramesUnmeasured);
+	roi.origin(0) = static_cast<Eigen::Index>(center.y - static_cast<float>(roi.size(0)) / 2.0f);
+	roi.origin(1) = static_cast<Eigen::Index>(center.x - static_cast<float>(roi.size(1)) / 2.0f);
+
+	return roi;
+}
+
+/// \brief The working area may own a buffer, and `DelayedInitialization` does not destroy the instance it replaces
+void Target::workingAreaReset()
+{
+	if (workingArea.isInitialized()) {
+		workingArea.getInstance()->~WorkingArea();
+		workingArea.instance = nullptr;
+	}
+}
+
+/// \brief The factory allocates a new instance on each call, and the library provides no way to release it. So the
+/// tracker is made once, and re-initialized from then on. On the firmware, its worker threads are spawned w/ the
+/// current policy, see `Trk::Workers`
+void Target::trackerMake()
+{
+	tracker = &Mosse::getFp16AbRawF32BufDynAlloc();
+}
+
+/// \brief The working area is destroyed first, as it depends on the tracker's previous ROI
+void Target::trackerInit(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi)
+{
+	workingAreaReset();
+
+	if (tracker == nullptr) {
+		trackerMake();
+	}
+
+	tracker->init(aImage, aRoi);
+}
+
+/// \brief Captures the template the target will be looked for w/, once it has been lost
+bool Target::capture(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi)
+{
+	nFramesTemplate = 0;
+
+	return recovery.capture(aImage.data(), static_cast<int>(aImage.rows()), static_cast<int>(aImage.cols()),
+		static_cast<int>(aRoi.origin(0)), static_cast<int>(aRoi.origin(1)), static_cast<int>(aRoi.size(0)),
+		static_cast<int>(aRoi.size(1)));
+}
+
+/// \brief Makes a step of the search for the lost target. The search is spread over `Params::sweepFrames` frames. If
+/// there is no match, it starts over
+Target::Event Target::recover(Mosse::Tp::Image &aImage, const Params &aParams)
+{
+	const auto startUs = aParams.nowUs();
+	Event event = Event::None;
+
+	if (!recovering) {
+		recovering = true;
+		lostUs = startUs;
+		sweepUs = 0;
+		nSweepFrames = 0;
+		recovery.start();
+		event = Event::Lost;
+	}
+
+	step = Step::Searching;
+
+	if (recovery.step(aImage.data(), static_cast<int>(aImage.rows()), static_cast<int>(aImage.cols()),
+			aParams.sweepFrames)) {
+		if (recovery.found()) {
+			Mosse::Tp::Roi roi = tracker->roi();
+			roi.origin(0) = recovery.match().row;
+			roi.origin(1) = recovery.match().col;
+			roiClamp(roi, aImage);
+			trackerInit(aImage, roi);
+			quality.reset();
+			motion.reset(roiCenter(roi));
+			nFramesUnmeasured = 0;
+			nFramesSkipped = 0;
+			recentred = false;
+			recovering = false;
+			recoveryTimeMs = static_cast<std::uint32_t>((aParams.nowUs() - lostUs) / 1000);
+			event = Event::Reacquired;
+		} else {
+			recovery.start();
+		}
+	}
+
+	sweepUs += aParams.nowUs() - startUs;
+	++nSweepFrames;
+	recoveryCostUs = static_cast<std::uint32_t>(sweepUs / nSweepFrames);
+
+	return event;
+}
+
+/// \brief Re-initializes the tracker at the predicted position
+void Target::recentreAt(Mosse::Tp::Image &aImage)
+{
+	Mosse::Tp::Roi roi = predict();
+	roiClamp(roi, aImage);
+	trackerInit(aImage, roi);
+	recentre = false;
+	recentred = true;
+}
+
+bool Target::Quality::update(float aPsr)
+{
+	// TODO. W/ current optimization settings, the PSR differs drastically from that of non-optimized code. Hence the need for clamping
+	psr = std::max(aPsr, 0.0f);
+	const bool tripped = ok && psr < lowerThreshold();
+
+	if (psr < lowerThreshold()) {
+		ok = false;
+	}
+
+	return tripped;
+}
+
+void Target::Quality::reset()
+{
+	psr = 0.0f;
+	ok = true;
+}
+
+}  // namespace Trk
@@ -0,0 +1,129 @@
+//
+// Target.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_TARGET_HPP_)
+#define TRACKING_PRIV_INCLUDE_TARGET_HPP_
+
+#include "utility/cont/DelayedInitialization.hpp"
+#include "Motion.hpp"
+#include "Recovery.hpp"
+#include <embmosse/Mosse.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace Trk {
+
+/// \brief The per-frame steps of a single target: the decision on what to do w/ the frame (update the tracker, skip
+/// the update, re-center the tracker, look for the lost target), the tracker's update, the motion, and the quality
+/// latch.
+///
+/// \details Only depends on the MOSSE library, and the standard one, so the bench (test/tracking_bench) replays
+/// recorded sequences through the very same code the firmware runs, see `Trk::Tracking`. The caller is in charge of
+/// the threads, and of the logging, see `Event`.
+class Target {
+public:
+	/// \brief What has been done on the current frame
+	enum class Step {
+		None,
+		Updated,  ///< The working area has been cropped, the tracker is to be updated, see `update`
+		Predicted,  ///< The ROI has been predicted
+		Searching,  ///< The target has been lost, and is being looked for
+	};
+
+	/// \brief Worth reporting
+	enum class Event {
+		None,
+		Lost,  ///< The search for the target has started
+		Reacquired,  ///< The target has been found, the tracker has been re-initialized at the match
+		Recentred,  ///< The tracker has been re-initialized at the predicted position
+		QualityDropped,  ///< The quality latch has tripped
+	};
+
+	struct Params {
+		unsigned strideMax;  ///< Frames a steady target is updated once in
+		int sweepFrames;  ///< Frames the search for the lost target is spread over, see `Trk::Recovery::step`
+		std::int64_t (*nowUs)();  ///< Clock the recovery is timed by
+	};
+
+	/// \brief Encapsulates quiality monitoring
+	struct Quality {
+		/// \brief peak-to-sidelobe ratio
+		float psr;
+		/// \brief Latch. Once the lower quality threshold has been exceeded, this value must be reset.
+		bool ok;
+		/// \returns true, if the latch has tripped
+		bool update(float aPsr);
+		void reset();
+		inline bool isOk() const
+		{
+			return ok;
+		}
+		float lowerThreshold() const
+		{
+			return 0.1;
+		}
+	};
+
+	using WorkingArea = std::decay<decltype(std::declval<Mosse::Tracker &>().imageCropWorkingArea(
+		std::declval<Mosse::Tp::Image &>()))>::type;
+
+	/// \brief (Re-)initializes the tracker w/ the ROI, and starts tracking over
+	/// \pre The ROI fits the frame
+	/// \returns false, if the recovery template could not be captured
+	bool init(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi);
+
+	/// \brief The per-frame pass. Decides on what to do w/ the frame, and crops the working area, if the tracker is to
+	/// be updated. See `step`
+	Event preprocess(Mosse::Tp::Image &aImage, const Params &aParams);
+
+	/// \brief Updates the tracker on the working area cropped by `preprocess`
+	/// \pre `step == Step::Updated`
+	Event update();
+
+	/// \brief Ends the frame
+	/// \returns the ROI to publish, the updated, or the predicted one
+	/// \pre `step != Step::None`
+	Mosse::Tp::Roi conclude();
+
+	Quality quality{0.0f, true};
+	Mosse::Tracker *tracker = nullptr;  ///< Made once, never released, see `Target::trackerMake`
+	Ut::Cont::DelayedInitialization<WorkingArea> workingArea;  ///< Cropped from the current frame
+	Step step = Step::None;
+	Motion motion;
+	unsigned nFramesUnmeasured = 0;  ///< Frames since the motion has been measured last
+	unsigned nFramesSkipped = 0;  ///< Frames since the tracker has been updated last
+	bool recentre = false;  ///< The tracker is to be re-initialized at the predicted position on the next frame
+	bool recentred = false;  ///< The tracker has been re-centered, and has not found the target since
+	Recovery recovery;
+	unsigned nFramesTemplate = 0;  ///< Frames since the recovery template has been captured
+	bool recovering = false;
+	std::int64_t lostUs = 0;  ///< When the target has been lost
+	std::int64_t sweepUs = 0;  ///< Time spent on the search since the target has been lost
+	unsigned nSweepFrames = 0;  ///< Frames the target has been looked for on
+	std::atomic<std::uint32_t> recoveryTimeMs{0};  ///< Time the latest re-acquisition has taken
+	std::atomic<std::uint32_t> recoveryCostUs{0};  ///< Mean search time per frame, the latest, or the ongoing one
+
+	/// \brief Updates the motion, if the measurement is trusted
+	/// \returns false, if the tracker has to be re-centered
+	bool measure(float aPsr);
+	/// \brief Number of frames the tracker is updated once in
+	unsigned stride(unsigned aStrideMax) const;
+	Mosse::Tp::Roi predict() const;
+
+	void workingAreaReset();
+
+private:
+	void trackerMake();
+	void trackerInit(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi);
+	bool capture(Mosse::Tp::Image &aImage, const Mosse::Tp::Roi &aRoi);
+	Event recover(Mosse::Tp::Image &aImage, const Params &aParams);
+	void recentreAt(Mosse::Tp::Image &aImage);
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_TARGET_HPP_
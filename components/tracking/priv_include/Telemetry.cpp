@@ -0,0 +1,92 @@
+//
+// Telemetry.cpp
+//
+
+// Override debug level.
+// https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-reference/system/log.html#_CPPv417esp_log_level_setPKc15esp_log_level_t
+#define LOG_LOCAL_LEVEL ((esp_log_level_t)CONFIG_TRACKING_DEBUG_LEVEL)
+#include <esp_log.h>
+
+#include "tracking/tracking.hpp"
+#include "utility/time.hpp"
+#include "utility/thr/WorkQueue.hpp"
+#include "Telemetry.hpp"
+
+namespace Trk {
+
+static constexpr std::uint32_t kStatsReportPeriod = 100;  ///< Publications between coalescing reports
+
+Telemetry::Telemetry() :
+	slots{},
+	periodUs{CONFIG_TRACKING_TELEMETRY_PERIOD_MS * 1000},
+	draining{false},
+	publishedUs{0},
+	nPublished{0}
+{
+}
+
+void Telemetry::post(const Sub::Trk::MosseTrackerUpdate &aUpdate)
+{
+	if (aUpdate.target >= 0 && aUpdate.target < static_cast<int>(slots.size())) {
+		slots[aUpdate.target].post(aUpdate);
+	}
+}
+
+void Telemetry::publish()
+{
+	const auto nowUs = Ut::bootTimeUs();
+
+	if (nowUs - publishedUs < static_cast<std::int64_t>(periodUs.load())) {
+		return;
+	}
+
+	// The previous publication is still in the queue. It will pick the newest updates up anyway
+	if (draining.exchange(true)) {
+		return;
+	}
+
+	publishedUs = nowUs;
+
+	if (Ut::Thr::Wq::MediumPriority::checkInstance()) {
+		Ut::Thr::Wq::MediumPriority::getInstance().push([this]() { drain(); });
+	} else {
+		draining = false;
+	}
+}
+
+std::uint32_t Telemetry::period() const
+{
+	return periodUs.load();
+}
+
+void Telemetry::setPeriod(std::uint32_t aPeriodUs)
+{
+	periodUs = aPeriodUs;
+}
+
+/// \brief Notified from the work queue to spare the tracker's task stack expenses
+void Telemetry::drain()
+{
+	draining = false;
+
+	for (auto &slot : slots) {
+		Sub::Trk::MosseTrackerUpdate update{};
+
+		if (slot.take(update)) {
+			Sub::Trk::OnMosseTrackerUpdate::notify(update);
+		}
+	}
+
+	if (++nPublished % kStatsReportPeriod == 0) {
+		std::uint32_t nPosted = 0;
+
+		for (const auto &slot : slots) {
+			nPosted += slot.posted();
+		}
+
+		ESP_LOGD(Trk::kDebugTag, "Telemetry: updates posted %u, publications %u", static_cast<unsigned>(nPosted),
+			static_cast<unsigned>(nPublished));
+	}
+}
+
+}  // namespace Trk
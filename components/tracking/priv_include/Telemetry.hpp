@@ -0,0 +1,50 @@
+//
+// Telemetry.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_TELEMETRY_HPP_)
+#define TRACKING_PRIV_INCLUDE_TELEMETRY_HPP_
+
+#include "sub/Tracking.hpp"
+#include "utility/cont/Mailbox.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <sdkconfig.h>
+
+namespace Trk {
+
+/// \brief Rate-controlled publisher of `Sub::Trk::MosseTrackerUpdate`.
+///
+/// \details The tracker's task overwrites the latest update of each target in a slot of its own on every frame, w/o
+/// allocating anything. At most once a period, a single work queue task is pushed, which notifies the subscribers w/
+/// the newest update of each target. The updates overwritten in the meantime are never published.
+class Telemetry {
+public:
+	Telemetry();
+
+	/// \brief Tracker's task. Replaces the target's latest update
+	void post(const Sub::Trk::MosseTrackerUpdate &aUpdate);
+
+	/// \brief Tracker's task. Pushes the publishing work queue task, if the period has passed since the previous one
+	void publish();
+
+	/// \brief Publishing period, us. 0 - publish every update
+	std::uint32_t period() const;
+	void setPeriod(std::uint32_t aPeriodUs);
+
+private:
+	/// \brief Work queue task. Notifies the subscribers w/ the latest updates
+	void drain();
+
+private:
+	std::array<Ut::Cont::Mailbox<Sub::Trk::MosseTrackerUpdate>, CONFIG_TRACKING_MAX_TARGETS> slots;
+	std::atomic<std::uint32_t> periodUs;
+	std::atomic<bool> draining;  ///< The work queue task has been pushed, and has not been run yet
+	std::int64_t publishedUs;  ///< When the work queue task has been pushed last
+	std::uint32_t nPublished;
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_TELEMETRY_HPP_
@@ -19,6 +19,7 @@
 #include "sub/Tracking.hpp"
 #include <embmosse/Mosse.hpp>
 #include "Tracking.hpp"
+#include <cstring>
 
 GS_UTILITY_LOGD_CLASS_ASPECT_SET_ENABLED(Trk::Tracking, "state machine", 1);
 GS_UTILITY_LOGV_CLASS_ASPECT_SET_ENABLED(Trk::Tracking, "state machine", 1);
@@ -29,21 +30,38 @@ namespace Trk {
 
 extern Mosse::Port::Thread &mosseThreadApi();
 
+static constexpr std::uint32_t kStatsReportPeriod = 100;  ///< Tracker updates between frame drop reports
+static constexpr Target::Params kTargetParams{CONFIG_TRACKING_UPDATE_STRIDE_MAX, CONFIG_TRACKING_RECOVERY_SWEEP_FRAMES,
+	&Ut::bootTimeUs};
+
 Tracking::Tracking() :
 	ModuleBase{Mod::Module::Tracking},
-	tracker{nullptr},
+	Ut::Thr::FreertosTask{"Tracker", CONFIG_TRACKING_TASK_STACK_SIZE, CONFIG_TRACKING_TASK_PRIORITY, CorePin::Core0},
+	workers{},
+	targets{},
+	targetSelected{0},
 	state{State::Disabled},
 	key{{&Tracking::onFrame, this}},
-	spinlock{Spinlock::Done},
-	quality{0.0f, true}
+	mailbox{},
+	semFrame{},
+	busy{false},
+	nFramesDropped{0},
+	helper{*this},
+	telemetry{},
+	decoder{CONFIG_TRACKING_JPEG_SCALE},
+	latency{Cam::Latency::registerConsumer("Tracking")}
 {
+	Ut::Thr::FreertosTask::start();
 }
 
-/// \brief When in tracking mode, processes the new frame searching for the new ROI center.
+/// \brief When in tracking mode, hands the new frame over to the tracker's task.
 void Tracking::onFrame(Sub::Key::NewFrameEvent aFrame)
 {
 	assert(nullptr != aFrame.get());
 	GS_UTILITY_LOGV_CLASS_ASPECT(Trk::kDebugTag, Tracking, "frame", "onFrame");
+	// While tracking, latency is recorded by the tracker's task
+	Cam::LatencyProbe latencyProbe{state == State::Disabled || state >= State::TrackerRunningFirst ? nullptr : latency,
+		*aFrame};
 
 	switch (state) {
 		case State::CamConfStart: {
@@ -51,26 +69,24 @@ void Tracking::onFrame(Sub::Key::NewFrameEvent aFrame)
 
 			break;
 		}
-		case State::TrackerInitFirst:
-			state = State::TrackerInit;
-
-			break;
 		// TODO: Handle CamConfFailed
-		case State::TrackerInit: {
-			onFrameTrackerInit(aFrame);
-
-			break;
-		}
-		case State::TrackerRunningFirst:
+		case State::TrackerRunningFirst:  // The frame may have been captured before the camera has been reconfigured. Skip it
 			GS_UTILITY_LOGD_CLASS_ASPECT(Trk::kDebugTag, Tracking, "state machine", "state TrackerRunningFirst");
 			cameraState.currentInit();
 			state = State::TrackerRunning;
-			// Fall through
+
+			break;
+
 		case State::TrackerRunning: {
 			onFrameTrackerRunning(aFrame);
 
 			break;
 		}
+		case State::Disabled:
+			decoder.release();  // The session is over. The decoder is only used by the camera thread
+
+			break;
+
 		default:
 			break;
 	}
@@ -80,6 +96,18 @@ void Tracking::onFrameCamConfStart(Sub::Key::NewFrameEvent)
 {
 	GS_UTILITY_LOGD_CLASS_ASPECT(Trk::kDebugTag, Tracking, "state machine", "state CamConfStart");
 	cameraState.snapshotInit();
+	cameraState.decode = false;
+
+#if CONFIG_TRACKING_JPEG_DECODE
+	if (cameraState.snapshot.pixformat != nullptr && std::strcmp(cameraState.snapshot.pixformat, "jpeg") == 0) {
+		ESP_LOGI(Trk::kDebugTag, "Tracking: tracking on JPEG frames decoded at 1/%d, the camera's mode is left intact",
+			1 << CONFIG_TRACKING_JPEG_SCALE);
+		cameraState.decode = true;
+		state = State::TrackerRunningFirst;
+
+		return;
+	}
+#endif
 
 	// Initialize the camera, switch it to grayscale mode, because this is the only format the algorithm can work with
 	if (Ut::Thr::Wq::MediumPriority::checkInstance()) {
@@ -92,7 +120,7 @@ void Tracking::onFrameCamConfStart(Sub::Key::NewFrameEvent)
 					{
 						if (aWriteResp.isOk()) {
 							ESP_LOGI(Trk::kDebugTag, "Tracking: switched camera to grayscale mode");
-							state = State::TrackerInit;
+							state = State::TrackerRunningFirst;
 						} else {
 							ESP_LOGE(Trk::kDebugTag,
 								"Tracking: failed to switch the camera to grayscale mode %s",
@@ -104,98 +132,347 @@ void Tracking::onFrameCamConfStart(Sub::Key::NewFrameEvent)
 	}
 }
 
-void Tracking::onFrameTrackerInit(Sub::Key::NewFrameEvent aFrame)
+/// \brief Makes the per-frame pass, while the frame is still valid, and hands the working areas over to the
+/// tracker's task. Never blocks: if the tracker's task is busy w/ the previous frame, the frame is dropped
+void Tracking::onFrameTrackerRunning(Sub::Key::NewFrameEvent aFrame)
 {
-	GS_UTILITY_LOGD_CLASS_ASPECT(Trk::kDebugTag, Tracking, "state machine", "state TrackerInit");
+	GS_UTILITY_LOGV_CLASS_ASPECT(Trk::kDebugTag, Tracking, "state machine", "state TrackerRunning");
 
-	if (static_cast<bool>(aFrame)) {
+	if (!static_cast<bool>(aFrame)) {
+		return;
+	}
 
-		assert(aFrame.get()->data() != nullptr);
-		if (tracker == nullptr) {
-			ESP_LOGI(Trk::kDebugTag, "Tracking: initializing tracker. Frame size: %dx%d", aFrame.get()->width(),
-				aFrame.get()->height());
-			tracker = &Mosse::getFp16AbRawF32BufDynAlloc();
-		}
+	if (busy.exchange(true, std::memory_order_acquire)) {
+		nFramesDropped.fetch_add(1, std::memory_order_relaxed);
+		ESP_LOGV(Trk::kDebugTag, "Tracking: tracker is behind, dropped a frame");
 
-		ESP_LOGI(Trk::kDebugTag, "initializing tracker");
-		Mosse::Tp::Image image{static_cast<std::uint8_t *>(aFrame.get()->data()), aFrame.get()->height(),
+		return;
+	}
+
+	if (cameraState.decode && !frameDecode(*aFrame.get())) {
+		busy.store(false, std::memory_order_release);
+
+		return;
+	}
+
+	// A JPEG frame has been decoded, see `Tracking::frameDecode`
+	Mosse::Tp::Image image = cameraState.decode ?
+		Mosse::Tp::Image{decoder.data(), decoder.rows(), decoder.cols()} :
+		Mosse::Tp::Image{static_cast<std::uint8_t *>(aFrame.get()->data()), aFrame.get()->height(),
 			aFrame.get()->width()};
-		Mosse::Tp::Roi r = this->roi.asAbsolute();
-
-		// The ROI has to fit frame size
-		if (!(r.origin(0) > 0 && r.origin(1) > 0 && r.size(0) > 0 && r.size(1) > 0
-				&& r.origin(0) + r.size(0) < aFrame.get()->width()
-				&& r.origin(1) + r.size(1) < aFrame.get()->height())) {
-			ESP_LOGW(Trk::kDebugTag, "Tracking: failed to initialize tracker, as ROI does not fit the frame"
-				"left up (%d, %d)  right bottom (%d, %d)  frame size (%d, %d)", r.origin(0), r.origin(1),
-				r.origin(0) + r.size(0), r.origin(1) + r.size(1),
-				aFrame.get()->width(), aFrame.get()->height());
-			state = State::Disabled;
-			cameraState.apply();  /// Restore camera state
-		} else {
-			ESP_LOGI(Trk::kDebugTag, "Tracking: initializing tracker w/ a new ROI  left up (%d, %d)  "
-				"right bottom (%d, %d)  frame size (%d, %d)", r.origin(0), r.origin(1), r.origin(0) + r.size(0),
-				r.origin(1) + r.size(1), aFrame.get()->width(), aFrame.get()->height());
-			tracker->init(image, r);
-			state = State::TrackerRunningFirst;
-			ESP_LOGI(Trk::kDebugTag, "Tracking: initialized tracker w/ a new ROI");
+	mailbox.post(Pass{preprocess(image), aFrame->sequence(), aFrame->captureTimeUs()});
+	semFrame.release();
+}
+
+void Tracking::run()
+{
+	std::uint32_t nUpdates = 0;
+
+	while (true) {
+		semFrame.acquire();
+		Pass pass{};
+
+		if (!mailbox.take(pass)) {
+			continue;
+		}
+
+		if (state != State::TrackerRunning) {  // Tracking has been stopped, or re-initialized in the meantime
+			busy.store(false, std::memory_order_release);
+
+			continue;
+		}
+
+		// The latency is measured from the capture, the pass made by the camera thread included
+		Cam::LatencyProbe latencyProbe{latency, pass.sequence, pass.captureTimeUs};
+		const std::size_t nTargets = pass.nUpdates;
+
+		if (nTargets > 1) {
+			helper.updateAsync();
+		}
+
+		if (nTargets > 0) {
+			updateLane(0);
+		}
+
+		if (nTargets > 1) {
+			helper.wait();
+		}
+
+		notify();
+		busy.store(false, std::memory_order_release);
+
+		if (++nUpdates % kStatsReportPeriod == 0) {
+			ESP_LOGD(Trk::kDebugTag, "Tracking: frames tracked %u, dropped %u", static_cast<unsigned>(mailbox.posted()),
+				static_cast<unsigned>(nFramesDropped.load(std::memory_order_relaxed)));
 		}
-	} else {
-		ESP_LOGW(Trk::kDebugTag, "Tracking: nullptr frame");
 	}
 }
 
-void Tracking::onFrameTrackerRunning(Sub::Key::NewFrameEvent aFrame)
+/// \brief The working areas are cloned (see `MOSSE_MEM_CLONE_IMAGE_WORKING_AREA`), so the frame is not needed for the
+/// updates. The crop depends on the ROI the previous update has produced, hence `busy`.
+std::size_t Tracking::preprocess(Mosse::Tp::Image &aImage)
 {
-	GS_UTILITY_LOGV_CLASS_ASPECT(Trk::kDebugTag, Tracking, "state machine", "state TrackerRunning");
+	std::size_t nUpdates = 0;
 
-	if (static_cast<bool>(aFrame)) {
-		Mosse::Tp::Image image{static_cast<std::uint8_t *>(aFrame.get()->data()), aFrame.get()->height(),
-			aFrame.get()->width()};
+	for (auto &target : targets) {
+		switch (target.state) {
+			case Target::State::Init: {
+				// The target may have been stopped, or re-assigned in the meantime
+				auto expected = Target::State::Init;
+				target.state.compare_exchange_strong(expected,
+					targetInit(target, aImage) ? Target::State::Running : Target::State::Idle);
+
+				break;
+			}
+
+			case Target::State::Running:
+				if (targetPreprocess(target, aImage)) {
+					target.lane = nUpdates % kLanes;  // Running targets are dealt round-robin
+					++nUpdates;
+				}
+
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if (disableIfIdle()) {
+		cameraStateApplyAsync();
+	}
+
+	return nUpdates;
+}
+
+bool Tracking::targetInit(Target &aTarget, Mosse::Tp::Image &aImage)
+{
+	const int frameHeight = static_cast<int>(aImage.rows());
+	const int frameWidth = static_cast<int>(aImage.cols());
+	Mosse::Tp::Roi r{{0, 0}, {0, 0}};
 
-		while (spinlock == Spinlock::Wait) {
-			ESP_LOGV(Trk::kDebugTag, "Tracking: waiting for spinlock");
+	{
+		std::lock_guard<std::mutex> lock{aTarget.roiMutex};
+		r = aTarget.roi.asAbsolute({frameWidth, frameHeight});
+	}
+
+	// The ROI has to fit frame size
+	if (!(r.origin(0) > 0 && r.origin(1) > 0 && r.size(0) > 0 && r.size(1) > 0
+			&& r.origin(0) + r.size(0) < frameHeight
+			&& r.origin(1) + r.size(1) < frameWidth)) {
+		ESP_LOGW(Trk::kDebugTag, "Tracking: failed to initialize tracker, as ROI does not fit the frame  "
+			"left up (%d, %d)  right bottom (%d, %d)  frame size (%d, %d)", r.origin(1), r.origin(0),
+			r.origin(1) + r.size(1), r.origin(0) + r.size(0), frameWidth, frameHeight);
+
+		return false;
+	}
+
+	ESP_LOGI(Trk::kDebugTag, "Tracking: initializing tracker #%d w/ a new ROI  left up (%d, %d)  "
+		"right bottom (%d, %d)  frame size (%d, %d)", static_cast<int>(&aTarget - &targets[0]), r.origin(1),
+		r.origin(0), r.origin(1) + r.size(1), r.origin(0) + r.size(0), frameWidth, frameHeight);
+
+	if (!aTarget.init(aImage, r)) {
+		ESP_LOGV(Trk::kDebugTag, "Tracking: failed to capture the template of target #%d",
+			static_cast<int>(&aTarget - &targets[0]));
+	}
+
+	return true;
+}
+
+bool Tracking::targetPreprocess(Target &aTarget, Mosse::Tp::Image &aImage)
+{
+	const int targetId = static_cast<int>(&aTarget - &targets[0]);
+
+	switch (aTarget.preprocess(aImage, kTargetParams)) {
+		case Target::Event::Lost:
+			ESP_LOGI(Trk::kDebugTag, "Tracking: lost target #%d, searching", targetId);
+
+			break;
+
+		case Target::Event::Reacquired: {
+			const auto roi = aTarget.tracker->roi();
+			ESP_LOGI(Trk::kDebugTag, "Tracking: re-acquired target #%d at (%d, %d) in %u ms, score %.2f", targetId,
+				static_cast<int>(roi.origin(1)), static_cast<int>(roi.origin(0)),
+				static_cast<unsigned>(aTarget.recoveryTimeMs), aTarget.recovery.match().score);
+
+			break;
+		}
+
+		case Target::Event::Recentred: {
+			const auto roi = aTarget.tracker->roi();
+			ESP_LOGD(Trk::kDebugTag, "Tracking: re-centering tracker #%d at (%d, %d)", targetId,
+				static_cast<int>(roi.origin(1)), static_cast<int>(roi.origin(0)));
+
+			break;
 		}
 
-		auto imageWorkingArea = tracker->imageCropWorkingArea(image);
-		spinlock = Spinlock::Wait;
-
-		if (Ut::Thr::Wq::MediumPriority::checkInstance()) {
-			// Detach from the current thread to release the buffer (the frame buffer is synchronized w/ a mutex)
-			Ut::Thr::Wq::MediumPriority::getInstance().push(
-				[this, imageWorkingArea]() mutable
-				{
-					ESP_LOGV(Trk::kDebugTag, "Tracking: updating tracker");
-					tracker->update(imageWorkingArea, true);
-					spinlock = Spinlock::Done;
-					auto nextRoi = tracker->roi();
-					quality.update(tracker->lastPsr());
-					Sub::Trk::MosseTrackerUpdate mosseTrackerUpdate{
-						cameraState.current.frameSize.second,  // frameHeight
-						cameraState.current.frameSize.first,  // frameWidth
-						nextRoi.origin(1),  // roiX (col)
-						nextRoi.origin(0),  // roiY (row)
-						nextRoi.size(1),  // roiWidth (# of rows)
-						nextRoi.size(1),  // roiHeight (# of columns)
-						quality.isOk()  // stateOk
-					};
-					// Notify through WQ to spare stack expenses
-					Ut::Thr::Wq::MediumPriority::getInstance().push(
-						[mosseTrackerUpdate]()
-						{
-							Sub::Trk::OnMosseTrackerUpdate::notify(mosseTrackerUpdate);
-						});
-					ESP_LOGV(Trk::kDebugTag, "Tracking: updated tracker, psr %.3f", tracker->lastPsr());
-				},
-				Ut::Thr::Wq::TaskPrio::Tracker);
+		default:
+			break;
+	}
+
+	return aTarget.step == Target::Step::Updated;
+}
+
+/// \brief Made on the camera thread, as the driver may re-use the frame's buffer once the frame has been delivered
+bool Tracking::frameDecode(Cam::Frame &aFrame)
+{
+	if (!decoder.decode(static_cast<const std::uint8_t *>(aFrame.data()), aFrame.size())) {
+		ESP_LOGW(Trk::kDebugTag, "Tracking: failed to decode a frame, skipping");
+
+		return false;
+	}
+
+	cameraState.current.frameSize = {decoder.cols(), decoder.rows()};
+
+	return true;
+}
+
+void Tracking::updateLane(std::size_t aLane)
+{
+	for (auto &target : targets) {
+		if (target.state != Target::State::Running || target.step != Target::Step::Updated || target.lane != aLane) {
+			continue;
+		}
+
+		ESP_LOGV(Trk::kDebugTag, "Tracking: updating tracker");
+
+		if (target.update() == Target::Event::QualityDropped) {
+			ESP_LOGW(Trk::kDebugTag, "Tracking: threshold PSR %.3f, current PSR %.3f", target.quality.lowerThreshold(),
+				target.quality.psr);
+		}
+
+		ESP_LOGV(Trk::kDebugTag, "Tracking: updated tracker, psr %.3f", target.tracker->lastPsr());
+	}
+}
+
+void Tracking::notify()
+{
+	for (auto &target : targets) {
+		if (target.step == Target::Step::None) {
+			continue;
+		}
+
+		const auto nextRoi = target.conclude();
+		Sub::Trk::MosseTrackerUpdate mosseTrackerUpdate{
+			cameraState.current.frameSize.second,  // frameHeight
+			cameraState.current.frameSize.first,  // frameWidth
+			nextRoi.origin(1),  // roiX (col)
+			nextRoi.origin(0),  // roiY (row)
+			nextRoi.size(1),  // roiWidth (# of columns)
+			nextRoi.size(0),  // roiHeight (# of rows)
+			target.quality.isOk(),  // stateOk
+			static_cast<int>(&target - &targets[0])  // target
+		};
+
+		telemetry.post(mosseTrackerUpdate);
+	}
+
+	telemetry.publish();
+}
+
+bool Tracking::disableIfIdle()
+{
+	for (auto &target : targets) {
+		if (target.state != Target::State::Idle) {
+			return false;
+		}
+	}
+
+	if (state.exchange(State::Disabled) == State::Disabled) {
+		return false;
+	}
+
+	ESP_LOGI(Trk::kDebugTag, "Tracking: no targets left, stopping");
+
+	return true;
+}
+
+void Tracking::cameraStateApplyAsync()
+{
+	if (Ut::Thr::Wq::MediumPriority::checkInstance()) {
+		Ut::Thr::Wq::MediumPriority::getInstance().push(
+			[this]()
+			{
+				cameraState.apply();  // Restore the camera's previous state
+			});
+	}
+}
+
+Tracking::Target *Tracking::targetSelectedGet()
+{
+	const int target = targetSelected;
+
+	return target >= 0 && target < static_cast<int>(targets.size()) ? &targets[target] : nullptr;
+}
+
+void Tracking::getFieldValue(Mod::Fld::Req aReq, Mod::Fld::OnResponseCallback aOnResponse)
+{
+	switch (aReq.field) {
+		case Mod::Fld::Field::CorePin:
+			aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::CorePin>(workers.corePin()));
+
+			break;
+
+		case Mod::Fld::Field::Priority:
+			aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::Priority>(workers.priority()));
+
+			break;
+
+		case Mod::Fld::Field::Target:
+			aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::Target>(
+				static_cast<std::int32_t>(targetSelected)));
+
+			break;
+
+		case Mod::Fld::Field::TelemetryPeriod:
+			aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::TelemetryPeriod>(telemetry.period()));
+
+			break;
+
+		case Mod::Fld::Field::RecoveryTime:
+		case Mod::Fld::Field::RecoveryCost: {
+			const Target *target = targetSelectedGet();
+
+			if (target == nullptr) {
+				break;
+			}
+
+			if (aReq.field == Mod::Fld::Field::RecoveryTime) {
+				aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::RecoveryTime>(
+					target->recoveryTimeMs.load()));
+			} else {
+				aOnResponse(makeResponse<Mod::Module::Tracking, Mod::Fld::Field::RecoveryCost>(
+					target->recoveryCostUs.load()));
+			}
+
+			break;
 		}
+		default:
+			break;
 	}
 }
 
-/// \brief Implements tracker control API: deinitialize, initialize (a.k.a set ROI)
+/// \brief Implements tracker control API: select target, deinitialize, initialize (a.k.a set ROI), workers' policy
 void Tracking::setFieldValue(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb)
 {
 	switch (aReq.field) {
+		case Mod::Fld::Field::CorePin:
+		case Mod::Fld::Field::Priority:
+			setFieldValueWorkers(aReq, aCb);
+
+			break;
+
+		case Mod::Fld::Field::Target:
+			setFieldValueTarget(aReq, aCb);
+
+			break;
+
+		case Mod::Fld::Field::TelemetryPeriod:
+			telemetry.setPeriod(aReq.variant.getUnchecked<Mod::Module::Tracking, Mod::Fld::Field::TelemetryPeriod>());
+			aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Ok});
+
+			break;
+
 		case Mod::Fld::Field::Initialized: {
 			setFieldValueInitialized(aReq, aCb);
 			break;
@@ -210,27 +487,41 @@ void Tracking::setFieldValue(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseC
 	}
 }
 
+void Tracking::setFieldValueTarget(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb)
+{
+	const std::int32_t target = aReq.variant.getUnchecked<Mod::Module::Tracking, Mod::Fld::Field::Target>();
+
+	if (target < kTargetAll || target >= static_cast<std::int32_t>(targets.size())) {
+		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::OutOfRange, "Tracking: no such target"});
+
+		return;
+	}
+
+	targetSelected = target;
+	aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Ok});
+}
+
 void Tracking::setFieldValueInitialized(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb)
 {
 	const bool initialized = aReq.variant.getUnchecked<Mod::Module::Tracking, Mod::Fld::Field::Initialized>();
 
 	if (!initialized) {  // Request to deinitialize the tracker
-		bool success = true;
+		bool stopped = false;
 		auto requestResult = Mod::Fld::RequestResult::Ok;
 		const char *resultMessage = nullptr;
 
-		if (state != State::Disabled) {
-			state = State::Disabled;
-			success = cameraState.apply();  // Restore the camera's previous state
-
-			if (!success) {
-				resultMessage = "Failed to restore camera state";
+		for (auto &target : targets) {
+			if (targetSelected == kTargetAll || &target == targetSelectedGet()) {
+				stopped = target.state.exchange(Target::State::Idle) != Target::State::Idle || stopped;
 			}
-		} else {
+		}
+
+		if (!stopped && state == State::Disabled) {
 			requestResult = Mod::Fld::RequestResult::Other;
 			resultMessage = "Ignoring tracking stop request, as it is already stopped";
 			ESP_LOGW(Trk::kDebugTag, "%s", resultMessage);
-			success = false;
+		} else if (disableIfIdle() && !cameraState.apply()) {
+			resultMessage = "Failed to restore camera state";
 		}
 
 		aCb(Mod::Fld::WriteResp{requestResult, resultMessage});
@@ -240,6 +531,14 @@ void Tracking::setFieldValueInitialized(Mod::Fld::WriteReq aReq, Mod::Fld::OnWri
 
 void Tracking::setFieldValueRoi(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb)
 {
+	Target *target = targetSelectedGet();
+
+	if (target == nullptr) {
+		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::OutOfRange, "Tracking: no target selected"});
+
+		return;
+	}
+
 	std::array<std::uint16_t, 4> rectXywh = aReq.variant.getUnchecked<
 		Mod::Module::Tracking, Mod::Fld::Field::Roi>();  // (x, y, width, height)
 	Mosse::Tp::Roi roiAbsoluteRchw{{rectXywh[1], rectXywh[0]}, {rectXywh[3], rectXywh[2]}};  // (row, col, nrows=height, ncols=width)
@@ -249,26 +548,98 @@ void Tracking::setFieldValueRoi(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteRespon
 
 	if (!success) {
 		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Other, "Failed to get camera state"});
+
+		return;
 	}
 
+	Roi roi{};
 	success = roi.normalizedInit(roiAbsoluteRchw);
 
 	// The (re)initialization has completed. Notify the caller
 	if (success) {
+		{
+			std::lock_guard<std::mutex> lock{target->roiMutex};  // The tracker's task may be reading it
+			target->roi = roi;
+		}
+
 		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Ok});
-		quality.reset();
 	} else {
 		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Other, "ROI error"});
 		ESP_LOGW(Trk::kDebugTag, "Failed to initialize ROI");
+
+		return;
 	}
 
-	if (stateIsCameraConfigured()) {
-		state = State::TrackerInit;
-	} else {
+	target->state = Target::State::Init;  // The tracker gets initialized by the tracker's task on the next frame
+
+	if (!stateIsCameraConfigured()) {
 		state = State::CamConfStart;
 	}
 }
 
+void Tracking::setFieldValueWorkers(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb)
+{
+	bool success = false;
+
+	switch (aReq.field) {
+		case Mod::Fld::Field::CorePin:
+			if (workers.isStarted()) {
+				aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Other,
+					"Tracker workers' policy: the threads have been pinned already"});
+
+				return;
+			}
+
+			success = workers.setCorePin(aReq.variant.getUnchecked<Mod::Module::Tracking, Mod::Fld::Field::CorePin>());
+
+			break;
+
+		case Mod::Fld::Field::Priority:
+			success = workers.setPriority(
+				aReq.variant.getUnchecked<Mod::Module::Tracking, Mod::Fld::Field::Priority>());
+
+			break;
+
+		default:
+			break;
+	}
+
+	if (success) {
+		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::Ok});
+	} else {
+		aCb(Mod::Fld::WriteResp{Mod::Fld::RequestResult::OutOfRange, "Tracker workers' policy: value out of range"});
+	}
+}
+
+Tracking::Helper::Helper(Tracking &aTracking) :
+	Ut::Thr::FreertosTask{"TrackerHelper", CONFIG_TRACKING_TASK_STACK_SIZE, CONFIG_TRACKING_TASK_PRIORITY,
+		CorePin::Core1},
+	tracking{aTracking},
+	semStart{},
+	semDone{}
+{
+	Ut::Thr::FreertosTask::start();
+}
+
+void Tracking::Helper::updateAsync()
+{
+	semStart.release();
+}
+
+void Tracking::Helper::wait()
+{
+	semDone.acquire();
+}
+
+void Tracking::Helper::run()
+{
+	while (true) {
+		semStart.acquire();
+		tracking.updateLane(kLaneHelper);
+		semDone.release();
+	}
+}
+
 /// \brief Initializes relative (`normalized`) ROI from the absolute one, taking the current frame size into account
 bool Tracking::Roi::normalizedInit(const Mosse::Tp::Roi &absolute)
 {
@@ -298,23 +669,21 @@ bool Tracking::Roi::normalizedInit(const Mosse::Tp::Roi &absolute)
 	return ret;
 }
 
-/// \brief Converts relative (`normalized`) ROI to the absolute one, taking the current frame size into account.
+/// \brief Converts relative (`normalized`) ROI to the absolute one, taking the size of the frame the tracker works on
+/// into account.
 ///
 /// \brief This kind of scaling is required, because the camera's frame size may (and will) change during its
-/// reconfiguration for the needs of tracking.
-Mosse::Tp::Roi Tracking::Roi::asAbsolute()
+/// reconfiguration for the needs of tracking, and decoded JPEG frames are downscaled.
+Mosse::Tp::Roi Tracking::Roi::asAbsolute(std::pair<int, int> aFrameSize)
 {
 	constexpr int kUninitialized = 0;
-	std::pair<int, int> frameSize{kUninitialized, kUninitialized};
-	Mod::ModuleBase::moduleFieldReadIter<Mod::Module::Camera, Mod::Fld::Field::FrameSize>(
-		[&frameSize](std::pair<int, int> aFrameSize) mutable { frameSize = aFrameSize; });
 	Mosse::Tp::Roi roi{{0, 0}, {0, 0}};
 
-	if (frameSize.first != kUninitialized) {
-		roi.origin(0) = static_cast<Eigen::Index>(frameSize.second * normalized.row);
-		roi.origin(1) = static_cast<Eigen::Index>(frameSize.first * normalized.col);
-		roi.size(0) = static_cast<Eigen::Index>(normalized.nrows * frameSize.second);
-		roi.size(1) = static_cast<Eigen::Index>(normalized.ncols * frameSize.first);
+	if (aFrameSize.first != kUninitialized) {
+		roi.origin(0) = static_cast<Eigen::Index>(aFrameSize.second * normalized.row);
+		roi.origin(1) = static_cast<Eigen::Index>(aFrameSize.first * normalized.col);
+		roi.size(0) = static_cast<Eigen::Index>(normalized.nrows * aFrameSize.second);
+		roi.size(1) = static_cast<Eigen::Index>(normalized.ncols * aFrameSize.first);
 	}
 
 	return roi;
@@ -374,6 +743,10 @@ void Tracking::CameraState::currentInit()
 /// \brief Restores camera state using the module API
 bool Tracking::CameraState::apply()
 {
+	if (decode) {  // Nothing to restore
+		return true;
+	}
+
 	bool success = true;
 	Mod::ModuleBase::moduleFieldWriteIter<Mod::Module::Camera, Mod::Fld::Field::FrameFormat>(snapshot.pixformat,
 		[this, &success](Mod::Fld::WriteResp aResp)
@@ -395,24 +768,4 @@ bool Tracking::CameraState::apply()
 	return success;
 }
 
-void Tracking::Quality::update(float aPsr)
-{
-	// TODO. W/ current optimization settings, the PSR differs drastically from that of non-optimized code. Hence the need for clamping
-	psr = Ut::Al::clamp(aPsr, 0.0f, std::numeric_limits<float>::infinity());
-
-	if (psr < lowerThreshold()) {
-		if (ok) {
-			ESP_LOGW(Trk::kDebugTag, "Tracking: threshold PSR %.3f, current PSR %.3f", lowerThreshold(), psr);
-		}
-
-		ok = false;
-	}
-}
-
-void Tracking::Quality::reset()
-{
-	psr = 0.0f;
-	ok = true;
-}
-
 }  // namespace Trk
@@ -8,19 +8,22 @@
 #if !defined(TRACKING_PRIV_INCLUDE_TRACKING_HPP_)
 #define TRACKING_PRIV_INCLUDE_TRACKING_HPP_
 
+#include "cam/Latency.hpp"
 #include "sub/Subscription.hpp"
 #include "module/ModuleBase.hpp"
-
-namespace Mosse {
-
-class Tracker;
-
-namespace Tp {
-
-class Roi;
-
-}  // namespace Tp
-}  // namespace Mosse
+#include "utility/cont/Mailbox.hpp"
+#include "utility/thr/Semaphore.hpp"
+#include "utility/thr/Threading.hpp"
+#include "Decoder.hpp"
+#include "Target.hpp"
+#include "Telemetry.hpp"
+#include "Workers.hpp"
+#include <embmosse/Mosse.hpp>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <sdkconfig.h>
 
 namespace Trk {
 
@@ -29,16 +32,41 @@ namespace Trk {
 ///
 /// \details For more information please refer to the MOSSE paper
 /// https://ieeexplore.ieee.org/abstract/document/5539960, or the underlying implementation.
-class Tracking : Mod::ModuleBase {
+///
+/// \details While tracking, the camera thread makes the per-frame pass (see below), which crops (clones) the working
+/// areas, and posts them to the tracker's task through a single-slot mailbox. So the frame is not used after it has
+/// been delivered, as the driver may be refilling its buffer already. The camera thread never waits for the tracker:
+/// a frame which arrives, while the tracker's task is still updating the targets, is dropped, and counted.
+///
+/// \details Up to `CONFIG_TRACKING_MAX_TARGETS` targets are tracked at once, each w/ its own ROI, quality latch, and
+/// stream of `Sub::Trk::MosseTrackerUpdate`. The target the `Roi` and `Initialized` fields address is selected w/
+/// the `Target` field. The per-frame pass (initializing the new targets, cropping every target's working area) is
+/// done once, then the targets are dealt between the tracker's task (pinned to core 0), and a helper task (pinned to
+/// core 1). Each tracker also splits its update w/ a worker thread of its own, those are pinned round-robin over the
+/// cores as the trackers get made, see `Trk::Workers`, so a target's update is not confined to its task's core.
+///
+/// \details The crop is centered on the ROI the previous update has found. Each target's center is fed into a
+/// `Trk::Motion` predictor. When a moving target is lost (low PSR), the tracker is re-centered where the target is
+/// expected to be before the quality latch is tripped. A steady target w/ a high PSR is only updated once in
+/// `CONFIG_TRACKING_UPDATE_STRIDE_MAX` frames, its ROI is predicted in between.
+///
+/// \details Once the quality latch has tripped, the tracker is not updated anymore. Instead, the target is looked for
+/// over the whole frame w/ the template captured while it was tracked well, see `Trk::Recovery`. The tracker is
+/// re-initialized at the match. The time it has taken, and the search cost per frame are reported through the
+/// `RecoveryTime` and `RecoveryCost` fields.
+///
+/// \details The updates are published at the rate set by the `TelemetryPeriod` field, only the newest one of each
+/// target, see `Trk::Telemetry`.
+///
+/// \details If the camera produces JPEG, it is not switched to grayscale (`CONFIG_TRACKING_JPEG_DECODE`). Instead, the
+/// camera thread decodes each frame downscaled into a grayscale image of its own, see `Trk::Decoder`, so the video
+/// stream, and the recording go on while tracking. The ROIs are published in the coordinates of the decoded image.
+/// The decoded image's buffer is only held during a tracking session.
+class Tracking : Mod::ModuleBase, public Ut::Thr::FreertosTask {
 private:
-	/// \brief Binary spinlock variable
-	///
-	/// \details It's been established experimentally that frame capturing and frame processing take roughly the same
-	/// time. So using a spinlock does not entail the risk of priority inversion.
-	enum class Spinlock {
-		Wait,
-		Done,
-	};
+	static constexpr std::size_t kLanes = 2;  ///< Tasks the targets are updated by: the tracker's task, and the helper
+	static constexpr std::size_t kLaneHelper = 1;
+	static constexpr int kTargetAll = -1;  ///< Stop request addresses every target
 
 	/// \brief Stores a universal representation of a ROI and provides an API for conversions
 	struct Roi {
@@ -51,7 +79,8 @@ private:
 		} normalized = {0.0f, 0.0f, 0.0f, 0.0f};
 
 		bool normalizedInit(const Mosse::Tp::Roi &absolute);  ///< Converts absolute to normalized ROI using the currently used frame size
-		Mosse::Tp::Roi asAbsolute();  ///< Converts normalized to absolute ROI using the currently used frame size
+		/// \brief Converts normalized to absolute ROI in the frame of the size (width, height) the tracker works on
+		Mosse::Tp::Roi asAbsolute(std::pair<int, int> aFrameSize);
 	};
 
 	/// \brief Subscription keys
@@ -64,8 +93,6 @@ private:
 		Disabled,
 		CamConfStart,  ///< Tracker will only work with u8 frames, so the camera has to be configured appropriately
 		CamConfFailed,
-		TrackerInitFirst,
-		TrackerInit,  ///< Initialize tracker with a first ROI
 		TrackerRunningFirst,  ///< Certain set-up routines have to be performed before tracking can be started. Hence the use of an additional state
 		TrackerRunning
 	};
@@ -80,33 +107,54 @@ private:
 		struct {
 			std::pair<int, int> frameSize = {};
 		} current;
+		bool decode = false;  ///< JPEG frames are decoded for the tracker, the camera has not been reconfigured
 
 		bool snapshotInit();
 		void currentInit();
 		bool apply();  ///< Restores camera state
 	};
 
-	/// \brief Encapsulates quiality monitoring
-	struct Quality {
-		/// \brief peak-to-sidelobe ratio
-		float psr;
-		/// \brief Latch. Once the lower quality threshold has been exceeded, this value must be reset.
-		bool ok;
-		void update(float aPsr);
-		inline void reset();
-		inline bool isOk() const
-		{
-			return ok;
-		}
-		float lowerThreshold() const
-		{
-			return 0.1;
-		}
+	/// \brief A tracked object. The per-frame steps are made by `Trk::Target`, the threads, and the ROI requests are
+	/// taken care of here
+	struct Target : Trk::Target {
+		enum class State {
+			Idle,
+			Init,  ///< The ROI has been set, the tracker is to be initialized on the next frame
+			Running,
+		};
+
+		std::atomic<State> state{State::Idle};
+		Roi roi;
+		std::mutex roiMutex;  ///< The ROI is written through the module API, and read by the camera thread
+		std::size_t lane = 0;  ///< Task the target is updated by on the current frame
+	};
+
+	/// \brief Handed over from the camera thread to the tracker's task, once the working areas have been cropped
+	struct Pass {
+		std::size_t nUpdates;  ///< Targets to update
+		std::uint32_t sequence;  ///< The frame's, see `Cam::Frame`
+		std::int64_t captureTimeUs;
+	};
+
+	/// \brief Updates its share of the targets in parallel w/ the tracker's task
+	class Helper : public Ut::Thr::FreertosTask {
+	public:
+		Helper(Tracking &aTracking);
+		void updateAsync();  ///< Starts updating the targets of its lane
+		void wait();  ///< Waits until the targets of its lane have been updated
+		void run() override;
+	private:
+		Tracking &tracking;
+		Ut::Thr::Semaphore<1, 0> semStart;
+		Ut::Thr::Semaphore<1, 0> semDone;
 	};
+
 public:
 	Tracking();
 	void onFrame(Sub::Key::NewFrameEvent);  ///< Subscription handler
+	void run() override;  ///< Tracker's task
 protected:
+	void getFieldValue(Mod::Fld::Req aReq, Mod::Fld::OnResponseCallback aOnResponse) override;
 	void setFieldValue(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb) override;
 private:
 	inline bool stateIsCameraConfigured() const
@@ -116,21 +164,56 @@ private:
 	/// \brief Delegate function. \sa `Tracking::onFrame`
 	void onFrameCamConfStart(Sub::Key::NewFrameEvent aFrame);
 	/// \brief Delegate function. \sa `Tracking::onFrame`
-	void onFrameTrackerInit(Sub::Key::NewFrameEvent aFrame);
-	/// \brief Delegate function. \sa `Tracking::onFrame`
 	void onFrameTrackerRunning(Sub::Key::NewFrameEvent aFrame);
 	/// \brief Delegate function. \sa `Tracking::setFieldValue`
 	void setFieldValueInitialized(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb);
 	/// \brief Delegate function. \sa `Tracking::setFieldValue`
 	void setFieldValueRoi(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb);
+	/// \brief Delegate function. \sa `Tracking::setFieldValue`
+	void setFieldValueTarget(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb);
+	/// \brief Delegate function. \sa `Tracking::setFieldValue`
+	void setFieldValueWorkers(Mod::Fld::WriteReq aReq, Mod::Fld::OnWriteResponseCallback aCb);
+	/// \brief Camera thread's delegate. The per-frame pass shared by the targets. Initializes the new ones, and crops
+	/// the working areas of the running ones
+	/// \pre The tracker's task is idle, see `busy`
+	/// \returns the number of targets to update
+	std::size_t preprocess(Mosse::Tp::Image &aImage);
+	/// \brief Camera thread's delegate. Initializes the target's tracker w/ its ROI
+	/// \returns false, if the ROI does not fit the frame
+	bool targetInit(Target &aTarget, Mosse::Tp::Image &aImage);
+	/// \brief Camera thread's delegate. Makes the per-frame step of the running target, see `Trk::Target::preprocess`
+	/// \returns true, if the target is to be updated
+	bool targetPreprocess(Target &aTarget, Mosse::Tp::Image &aImage);
+	/// \brief Camera thread's delegate. Decodes the JPEG frame
+	/// \returns false, if the frame could not be decoded
+	bool frameDecode(Cam::Frame &aFrame);
+	/// \brief Updates the running targets assigned to the lane
+	void updateLane(std::size_t aLane);
+	/// \brief Posts the running targets' updated, or predicted ROIs for publishing
+	void notify();
+	/// \brief Stops the tracking, if there are no targets left. The camera state is to be restored by the caller
+	/// \returns true, if the tracking has been stopped
+	bool disableIfIdle();
+	/// \brief Restores the camera state from the work queue, as the tracker's task must not reconfigure the camera
+	void cameraStateApplyAsync();
+	Target *targetSelectedGet();
 private:
-	Mosse::Tracker *tracker;
-	State state;
+	Workers workers;
+	std::array<Target, CONFIG_TRACKING_MAX_TARGETS> targets;
+	std::atomic<int> targetSelected;  ///< Target addressed by the `Roi` and `Initialized` fields
+	std::atomic<State> state;
 	Key key;
-	Spinlock spinlock;
-	Roi roi;
+	Ut::Cont::Mailbox<Pass> mailbox;  ///< The working areas cropped from the latest frame
+	Ut::Thr::Semaphore<1, 0> semFrame;  ///< Signals the tracker's task that a pass has been posted
+	/// \brief Set by the camera thread before the per-frame pass, cleared by the tracker's task once the targets have
+	/// been updated. So the targets are never touched by both at once
+	std::atomic<bool> busy;
+	std::atomic<std::uint32_t> nFramesDropped;  ///< Frames which have arrived, while the tracker's task was busy
+	Helper helper;
+	Telemetry telemetry;
+	Decoder decoder;  ///< Only used by the camera thread
 	CameraState cameraState;
-	Quality quality;
+	Cam::LatencyStats *latency;
 };
 
 }  // namespace Trk
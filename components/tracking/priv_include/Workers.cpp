@@ -0,0 +1,115 @@
+//
+// Workers.cpp
+//
+
+#include "utility/thr/Threading.hpp"
+#include "Workers.hpp"
+#include <sdkconfig.h>
+
+namespace Trk {
+
+static constexpr int kCores = 2;
+
+Workers::Workers() :
+	mutex{},
+	cores{0, 1},
+	prio{CONFIG_TRACKING_WORKER_PRIORITY},
+	threadId{0},
+	tasks{}
+{
+}
+
+std::pair<int, int> Workers::corePin() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return cores;
+}
+
+bool Workers::setCorePin(std::pair<int, int> aCorePin)
+{
+	auto isValid = [](int aCore) { return aCore == kCoreNone || (aCore >= 0 && aCore < kCores); };
+
+	if (!isValid(aCorePin.first) || !isValid(aCorePin.second)) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (threadId != 0) {
+		return false;
+	}
+
+	cores = aCorePin;
+
+	return true;
+}
+
+int Workers::priority() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return prio;
+}
+
+bool Workers::setPriority(int aPriority)
+{
+	if (aPriority <= Ut::Thr::FreertosTask::PriorityLowest || aPriority > Ut::Thr::FreertosTask::PriorityHighest) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+	prio = aPriority;
+
+	for (auto task : tasks) {
+		if (task != nullptr) {
+			vTaskPrioritySet(task, static_cast<UBaseType_t>(prio));
+		}
+	}
+
+	return true;
+}
+
+bool Workers::isStarted() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return threadId != 0;
+}
+
+Workers::ThreadParams Workers::nextThread()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const int core = threadId % kThreads == 0 ? cores.first : cores.second;
+	++threadId;
+
+	return {core, prio, CONFIG_TRACKING_WORKER_STACK_SIZE};
+}
+
+void Workers::onThreadStarted(xTaskHandle aTask)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	for (auto &task : tasks) {
+		if (task == nullptr) {
+			task = aTask;
+
+			return;
+		}
+	}
+}
+
+void Workers::onThreadFinished(xTaskHandle aTask)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	for (auto &task : tasks) {
+		if (task == aTask) {
+			task = nullptr;
+
+			return;
+		}
+	}
+}
+
+}  // namespace Trk
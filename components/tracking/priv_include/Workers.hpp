@@ -0,0 +1,74 @@
+//
+// Workers.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_WORKERS_HPP_)
+#define TRACKING_PRIV_INCLUDE_WORKERS_HPP_
+
+#include "utility/MakeSingleton.hpp"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace Trk {
+
+/// \brief Policy of the threads the MOSSE tracker parallelizes its updates over.
+///
+/// \details The tracker splits the frame chunks between the managing thread (the one calling `update`), and the
+/// worker threads it spawns through `Trk::Thread`. The worker threads' core pinning and priority are set at runtime
+/// through the Tracking module fields. The split is the library's own.
+///
+/// \details The worker threads are spawned, as the trackers are made, round-robin over the cores: the tracker made
+/// first gets its worker pinned to the first core, the one made next -- to the second one, and so on. A tracker is
+/// made once per target, and lives on (see `Target::trackerMake`). A change of priority is applied to the running
+/// worker threads. FreeRTOS cannot move a running task to another core, so the pinning can only be changed before
+/// the first tracker has been made.
+class Workers : public Ut::MakeSingleton<Workers> {
+public:
+	static constexpr std::size_t kThreads = 2;  ///< Threads the frame chunks are split between, the managing one included
+	static constexpr int kCoreNone = -1;
+
+	struct ThreadParams {
+		int core;  ///< `kCoreNone`, if not pinned
+		int priority;
+		int stack;
+	};
+
+	Workers();
+
+	/// \brief Cores the worker threads are pinned to, in the order they get spawned
+	std::pair<int, int> corePin() const;
+	/// \pre No worker thread has been spawned yet, see `isStarted`
+	bool setCorePin(std::pair<int, int> aCorePin);
+	int priority() const;
+	/// \brief Sets the priority of the worker threads, the running ones included
+	bool setPriority(int aPriority);
+
+	/// \returns true, if a worker thread has been spawned, so the pinning is fixed
+	bool isStarted() const;
+
+	/// \brief Parameters of the next worker thread the tracker spawns, see `Trk::Thread::start`
+	ThreadParams nextThread();
+
+	/// \brief Registers the spawned worker thread, so the changes of the policy are applied to it
+	void onThreadStarted(xTaskHandle aTask);
+	void onThreadFinished(xTaskHandle aTask);
+
+private:
+	static constexpr std::size_t kTasksMax = CONFIG_TRACKING_MAX_TARGETS * kThreads;
+
+	mutable std::mutex mutex;
+	std::pair<int, int> cores;
+	int prio;
+	std::size_t threadId;  ///< Worker threads spawned so far, each tracker's get the next core
+	std::array<xTaskHandle, kTasksMax> tasks;  ///< Running worker threads, nullptr - free slot
+};
+
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_WORKERS_HPP_
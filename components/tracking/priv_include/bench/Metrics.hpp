@@ -0,0 +1,147 @@
+//
+// Metrics.hpp
+//
+
+#if !defined(TRACKING_PRIV_INCLUDE_BENCH_METRICS_HPP_)
+#define TRACKING_PRIV_INCLUDE_BENCH_METRICS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Trk {
+namespace Bench {
+
+/// \brief Axis-aligned rectangle, pixels
+struct Rect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+/// \brief Intersection over union, [0; 1]
+inline float iou(const Rect &aLhs, const Rect &aRhs)
+{
+	const int left = std::max(aLhs.x, aRhs.x);
+	const int top = std::max(aLhs.y, aRhs.y);
+	const int right = std::min(aLhs.x + aLhs.width, aRhs.x + aRhs.width);
+	const int bottom = std::min(aLhs.y + aLhs.height, aRhs.y + aRhs.height);
+
+	if (right <= left || bottom <= top) {
+		return 0.0f;
+	}
+
+	const float intersection = static_cast<float>(right - left) * static_cast<float>(bottom - top);
+	const float areaUnion = static_cast<float>(aLhs.width) * static_cast<float>(aLhs.height)
+		+ static_cast<float>(aRhs.width) * static_cast<float>(aRhs.height) - intersection;
+
+	return areaUnion > 0.0f ? intersection / areaUnion : 0.0f;
+}
+
+/// \brief Frame rate over a series of frame timestamps
+/// \param aTimestamps Number of timestamps. They span `aTimestamps - 1` frame intervals
+/// \param aSpanUs Time between the first, and the last timestamp
+inline float fps(std::size_t aTimestamps, std::int64_t aSpanUs)
+{
+	if (aTimestamps < 2 || aSpanUs <= 0) {
+		return 0.0f;
+	}
+
+	return static_cast<float>(aTimestamps - 1) * 1000000.0f / static_cast<float>(aSpanUs);
+}
+
+/// \brief Accumulates per-update measurements of a tracker run over a recorded sequence
+class Report {
+public:
+	struct Sample {
+		std::uint32_t latencyUs;  ///< Duration of the target's step on the frame, see `Trk::Target`
+		float psr;
+		float iou;  ///< W/ the ground truth ROI
+		bool ok;  ///< Quality latch state, see `Trk::Target::Quality`
+	};
+
+	void onUpdate(const Sample &aSample)
+	{
+		samples.push_back(aSample);
+	}
+
+	const std::vector<Sample> &trace() const
+	{
+		return samples;
+	}
+
+	std::size_t updates() const
+	{
+		return samples.size();
+	}
+
+	/// \brief Nearest-rank percentile of the update latency
+	std::uint32_t latencyPercentileUs(float aPercent) const
+	{
+		if (samples.empty()) {
+			return 0;
+		}
+
+		std::vector<std::uint32_t> latencies{};
+		latencies.reserve(samples.size());
+
+		for (const auto &sample : samples) {
+			latencies.push_back(sample.latencyUs);
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		const float rank = aPercent / 100.0f * static_cast<float>(latencies.size());
+		std::size_t id = static_cast<std::size_t>(rank);
+
+		if (static_cast<float>(id) < rank) {  // ceil
+			++id;
+		}
+
+		return latencies[std::min(std::max<std::size_t>(id, 1), latencies.size()) - 1];
+	}
+
+	/// \brief Update throughput, i.e. the frame rate the tracker alone could sustain
+	float fps() const
+	{
+		std::uint64_t totalUs = 0;
+
+		for (const auto &sample : samples) {
+			totalUs += sample.latencyUs;
+		}
+
+		return totalUs > 0 ? static_cast<float>(samples.size()) * 1000000.0f / static_cast<float>(totalUs) : 0.0f;
+	}
+
+	float iouMean() const
+	{
+		float sum = 0.0f;
+
+		for (const auto &sample : samples) {
+			sum += sample.iou;
+		}
+
+		return samples.empty() ? 0.0f : sum / static_cast<float>(samples.size());
+	}
+
+	/// \brief Share of the updates w/ IoU over the threshold
+	float successRate(float aIouThreshold = 0.5f) const
+	{
+		std::size_t n = 0;
+
+		for (const auto &sample : samples) {
+			n += static_cast<std::size_t>(sample.iou > aIouThreshold);
+		}
+
+		return samples.empty() ? 0.0f : static_cast<float>(n) / static_cast<float>(samples.size());
+	}
+
+private:
+	std::vector<Sample> samples;
+};
+
+}  // namespace Bench
+}  // namespace Trk
+
+#endif // TRACKING_PRIV_INCLUDE_BENCH_METRICS_HPP_
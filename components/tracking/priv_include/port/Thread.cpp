@@ -9,6 +9,7 @@
 #include "utility/thr/Threading.hpp"
 #include "tracking/tracking.hpp"
 #include "Thread.hpp"
+#include "Workers.hpp"
 #include <esp_log.h>
 
 std::unique_ptr<Mosse::Port::Thread> Trk::Thread::makeFromTask(Mosse::Port::Task &aTask)
@@ -23,20 +24,29 @@ void stub(void *)
 
 void Trk::Thread::start()
 {
-	static int corePin = 0;
-	static constexpr int knCores = 2;
+	Workers::ThreadParams params{Workers::kCoreNone, CONFIG_TRACKING_WORKER_PRIORITY,
+		CONFIG_TRACKING_WORKER_STACK_SIZE};
+
+	if (Workers::checkInstance()) {
+		params = Workers::getInstance().nextThread();
+	}
 
 	ESP_LOGI(Trk::kDebugTag, "Creating tracking thread");
-	auto res = xTaskCreatePinnedToCore(threadTask, NULL, 1024 * 3, this, Ut::Thr::FreertosTask::PriorityMedium,
-		&taskHandle, corePin);
+	const auto res = params.core == Workers::kCoreNone ?
+		xTaskCreate(threadTask, "TrackerWorker", params.stack, this, params.priority, &taskHandle) :
+		xTaskCreatePinnedToCore(threadTask, "TrackerWorker", params.stack, this, params.priority, &taskHandle,
+			params.core);
 
 	if (res != pdPASS) {
-		ESP_LOGE(Trk::kDebugTag, "Failed to create a tracking thread pinned to core %d", corePin);
+		ESP_LOGE(Trk::kDebugTag, "Failed to create a tracking thread pinned to core %d", params.core);
 	} else {
-		ESP_LOGI(Trk::kDebugTag, "Successfully created tracking thread pinned to core %d", corePin);
-	}
+		if (Workers::checkInstance()) {
+			Workers::getInstance().onThreadStarted(taskHandle);
+		}
 
-	corePin = (corePin + 1) % knCores;
+		ESP_LOGI(Trk::kDebugTag, "Successfully created tracking thread pinned to core %d, priority %d", params.core,
+			params.priority);
+	}
 }
 
 void Trk::Thread::threadTask(void *aInstance)
@@ -46,5 +56,10 @@ void Trk::Thread::threadTask(void *aInstance)
 	ESP_LOGI(Trk::kDebugTag, "started tracking thread");
 	instance.task()->run();
 	ESP_LOGI(Trk::kDebugTag, "finished tracking thread");
-	while (true);
+
+	if (Workers::checkInstance()) {
+		Workers::getInstance().onThreadFinished(xTaskGetCurrentTaskHandle());
+	}
+
+	vTaskDelete(nullptr);  // Nothing left to run
 }
@@ -0,0 +1,166 @@
+//
+// IntrusivePtr.hpp
+//
+
+#ifndef UTILITY_UTILITY_INTRUSIVEPTR_HPP
+#define UTILITY_UTILITY_INTRUSIVEPTR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace Ut {
+
+/// \brief Base for instances which carry their own reference counter.
+///
+/// \details Unlike `std::shared_ptr`, sharing an instance does not entail
+/// allocation of a control block. It is up to the inheritor to decide what
+/// to do, when the last reference is gone (return itself into a pool, release
+/// a driver's buffer, etc.)
+class RefCounted {
+public:
+	RefCounted() : refCount{0}
+	{
+	}
+
+	/// \brief A copy is a new instance, hence it has no references
+	RefCounted(const RefCounted &) : refCount{0}
+	{
+	}
+
+	RefCounted &operator=(const RefCounted &)
+	{
+		return *this;
+	}
+
+	void refAcquire()
+	{
+		refCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void refRelease()
+	{
+		if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			onRefCountZero();
+		}
+	}
+
+	unsigned refUseCount() const
+	{
+		return refCount.load(std::memory_order_relaxed);
+	}
+
+protected:
+	virtual ~RefCounted() = default;
+
+	/// \brief Invoked once the last `IntrusivePtr` pointing to the instance
+	/// gets destructed
+	virtual void onRefCountZero() = 0;
+
+private:
+	std::atomic<unsigned> refCount;
+};
+
+/// \brief Smart pointer over `RefCounted` instances. Mimics the subset of
+/// `std::shared_ptr` API which is used throughout the project.
+template <class T>
+class IntrusivePtr {
+public:
+	IntrusivePtr() : instance{nullptr}
+	{
+	}
+
+	IntrusivePtr(std::nullptr_t) : instance{nullptr}
+	{
+	}
+
+	explicit IntrusivePtr(T *aInstance) : instance{aInstance}
+	{
+		if (instance) {
+			instance->refAcquire();
+		}
+	}
+
+	IntrusivePtr(const IntrusivePtr &aOther) : IntrusivePtr{aOther.instance}
+	{
+	}
+
+	IntrusivePtr(IntrusivePtr &&aOther) : instance{aOther.instance}
+	{
+		aOther.instance = nullptr;
+	}
+
+	/// \brief Upcast
+	template <class U>
+	IntrusivePtr(const IntrusivePtr<U> &aOther) : IntrusivePtr{aOther.get()}
+	{
+	}
+
+	IntrusivePtr &operator=(const IntrusivePtr &aOther)
+	{
+		IntrusivePtr{aOther}.swap(*this);
+
+		return *this;
+	}
+
+	IntrusivePtr &operator=(IntrusivePtr &&aOther)
+	{
+		IntrusivePtr{std::move(aOther)}.swap(*this);
+
+		return *this;
+	}
+
+	~IntrusivePtr()
+	{
+		if (instance) {
+			instance->refRelease();
+		}
+	}
+
+	void reset()
+	{
+		IntrusivePtr{}.swap(*this);
+	}
+
+	void reset(T *aInstance)
+	{
+		IntrusivePtr{aInstance}.swap(*this);
+	}
+
+	void swap(IntrusivePtr &aOther)
+	{
+		std::swap(instance, aOther.instance);
+	}
+
+	T *get() const
+	{
+		return instance;
+	}
+
+	T *operator->() const
+	{
+		return instance;
+	}
+
+	T &operator*() const
+	{
+		return *instance;
+	}
+
+	explicit operator bool() const
+	{
+		return instance != nullptr;
+	}
+
+	unsigned useCount() const
+	{
+		return instance ? instance->refUseCount() : 0;
+	}
+
+private:
+	T *instance;
+};
+
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_INTRUSIVEPTR_HPP
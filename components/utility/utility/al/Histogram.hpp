@@ -0,0 +1,151 @@
+//
+// Histogram.hpp
+//
+
+#ifndef UTILITY_UTILITY_AL_HISTOGRAM_HPP
+#define UTILITY_UTILITY_AL_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Ut {
+namespace Al {
+
+/// \brief Histogram of durations with power-of-2 buckets. Bucket 0 holds
+/// values in [0; 2), bucket `i` holds values in [2^i; 2^(i+1)). The last
+/// bucket also accumulates everything above its lower bound.
+///
+/// \details Recording is lock-free, and it is expected to be done from one
+/// context, while the statistics may be read from any other. Readers may
+/// observe a sample being recorded partially (e.g. the counter has been
+/// increased, while the bucket has not yet), which is fine for diagnostics.
+///
+/// \tparam N - number of buckets. The default covers durations up to ~0.5 s,
+/// when recording microseconds.
+template <std::size_t N = 20>
+class Histogram {
+	static_assert(N > 1 && N < 32, "Unsupported number of buckets");
+
+public:
+	using Counter = std::uint32_t;
+	using Value = std::uint32_t;
+
+	Histogram()
+	{
+		reset();
+	}
+
+	Histogram(const Histogram &) = delete;
+	Histogram &operator=(const Histogram &) = delete;
+
+	void record(Value aValue)
+	{
+		buckets[bucketOf(aValue)].fetch_add(1, std::memory_order_relaxed);
+		total.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(aValue, std::memory_order_relaxed);
+
+		if (aValue > maxValue.load(std::memory_order_relaxed)) {
+			maxValue.store(aValue, std::memory_order_relaxed);
+		}
+	}
+
+	void reset()
+	{
+		for (auto &bucket : buckets) {
+			bucket.store(0, std::memory_order_relaxed);
+		}
+
+		total.store(0, std::memory_order_relaxed);
+		sum.store(0, std::memory_order_relaxed);
+		maxValue.store(0, std::memory_order_relaxed);
+	}
+
+	Counter count() const
+	{
+		return total.load(std::memory_order_relaxed);
+	}
+
+	Counter bucket(std::size_t aBucket) const
+	{
+		return aBucket < N ? buckets[aBucket].load(std::memory_order_relaxed) : 0;
+	}
+
+	Value max() const
+	{
+		return maxValue.load(std::memory_order_relaxed);
+	}
+
+	Value mean() const
+	{
+		const Counter n = count();
+
+		return n == 0 ? 0 : static_cast<Value>(sum.load(std::memory_order_relaxed) / n);
+	}
+
+	/// \brief Upper bound of the bucket containing the requested percentile.
+	/// Clamped by the max. recorded value, so the estimate never exceeds it.
+	/// \param aPercent - [0; 100]
+	Value percentile(unsigned aPercent) const
+	{
+		const Counter n = count();
+
+		if (n == 0) {
+			return 0;
+		}
+
+		const std::uint64_t threshold = (static_cast<std::uint64_t>(n) * aPercent + 99) / 100;
+		std::uint64_t accumulated = 0;
+
+		for (std::size_t i = 0; i < N; ++i) {
+			accumulated += bucket(i);
+
+			if (accumulated >= threshold && accumulated > 0) {
+				const Value upper = i + 1 < N ? upperBound(i) : max();
+
+				return upper < max() ? upper : max();
+			}
+		}
+
+		return max();
+	}
+
+	/// \brief Lower bound of the bucket, inclusive
+	static constexpr Value lowerBound(std::size_t aBucket)
+	{
+		return aBucket == 0 ? 0 : static_cast<Value>(1) << aBucket;
+	}
+
+	/// \brief Upper bound of the bucket, exclusive
+	static constexpr Value upperBound(std::size_t aBucket)
+	{
+		return static_cast<Value>(1) << (aBucket + 1);
+	}
+
+	static constexpr std::size_t size()
+	{
+		return N;
+	}
+
+	static std::size_t bucketOf(Value aValue)
+	{
+		std::size_t i = 0;
+
+		for (aValue >>= 1; aValue != 0 && i + 1 < N; aValue >>= 1) {
+			++i;
+		}
+
+		return i;
+	}
+
+private:
+	std::atomic<Counter> buckets[N];
+	std::atomic<Counter> total;
+	std::atomic<std::uint64_t> sum;
+	std::atomic<Value> maxValue;
+};
+
+}  // namespace Al
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_AL_HISTOGRAM_HPP
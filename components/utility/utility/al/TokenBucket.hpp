@@ -0,0 +1,78 @@
+//
+// TokenBucket.hpp
+//
+
+#ifndef UTILITY_UTILITY_AL_TOKENBUCKET_HPP
+#define UTILITY_UTILITY_AL_TOKENBUCKET_HPP
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Ut {
+namespace Al {
+
+/// \brief Token bucket rate limiter. The bucket is refilled at `rate` tokens
+/// per second up to `capacity` tokens.
+///
+/// \details A consumer may take more tokens than there are left, as long as
+/// the bucket is not empty. The debt gets paid off by the subsequent refills,
+/// so items larger than the bucket (e.g. a frame w/ a small burst size) are
+/// not starved, and the average rate still holds.
+///
+/// The time is provided by the caller, so the bucket may be driven by any
+/// clock.
+class TokenBucket {
+public:
+	/// \param aRate - tokens per second, 0 disables the limiting
+	/// \param aCapacity - max. burst, tokens
+	TokenBucket(std::uint32_t aRate = 0, std::uint32_t aCapacity = 0) :
+		rate{aRate},
+		capacity{static_cast<std::int64_t>(aCapacity) * kUsPerS},
+		level{capacity},
+		lastUpdateUs{-1}
+	{
+	}
+
+	/// \brief Refills the bucket according to the time elapsed since the
+	/// previous update
+	void update(std::int64_t aTimeUs)
+	{
+		if (lastUpdateUs >= 0 && aTimeUs > lastUpdateUs) {
+			level = std::min(capacity, level + (aTimeUs - lastUpdateUs) * static_cast<std::int64_t>(rate));
+		}
+
+		lastUpdateUs = aTimeUs;
+	}
+
+	/// \returns true, if a consumer may take tokens
+	bool isAvailable() const
+	{
+		return rate == 0 || level > 0;
+	}
+
+	void consume(std::uint32_t aTokens)
+	{
+		if (rate != 0) {
+			level -= static_cast<std::int64_t>(aTokens) * kUsPerS;
+		}
+	}
+
+	/// \brief Tokens left, negative, if in debt
+	std::int64_t tokens() const
+	{
+		return level / kUsPerS;
+	}
+
+private:
+	static constexpr std::int64_t kUsPerS = 1000000;
+
+	std::uint32_t rate;
+	std::int64_t capacity;  ///< Scaled by `kUsPerS`, so fractions of a token are not lost between updates
+	std::int64_t level;  ///< Scaled by `kUsPerS`
+	std::int64_t lastUpdateUs;
+};
+
+}  // namespace Al
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_AL_TOKENBUCKET_HPP
@@ -0,0 +1,199 @@
+//
+// ByteRing.hpp
+//
+
+#ifndef UTILITY_UTILITY_CONT_BYTERING_HPP
+#define UTILITY_UTILITY_CONT_BYTERING_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Ut {
+namespace Cont {
+
+/// \brief Ring of variable-size records (e.g. JPEG frames) in a contiguous
+/// byte arena w/ drop-oldest policy.
+///
+/// \details Records are copied into the arena, and referenced by offset and
+/// length from a fixed table, so there are no allocations per record. A
+/// record is never split: if it does not fit in the arena's tail, it is placed
+/// at the beginning, and the tail stays unused until the next lap. The oldest
+/// records get evicted, when either the arena, or the table runs out of space.
+///
+/// The arena is provided by the user (e.g. allocated from PSRAM), and it must
+/// outlive the ring. Not thread-safe.
+///
+/// \tparam Tmeta - user data stored along w/ each record
+/// \tparam N - max. number of records
+template <class Tmeta, std::size_t N>
+class ByteRing {
+	static_assert(N > 0, "Ring depth must be positive");
+
+public:
+	struct Entry {
+		std::size_t offset;  ///< Position in the arena
+		std::size_t size;
+		Tmeta meta;
+	};
+
+	ByteRing() : arena{nullptr}, arenaSize{0}, first{0}, count{0}, used{0}, nEvicted{0}
+	{
+	}
+
+	/// \brief Sets the arena, and discards the records
+	void assign(std::uint8_t *aArena, std::size_t aSize)
+	{
+		arena = aArena;
+		arenaSize = aSize;
+		clear();
+	}
+
+	void clear()
+	{
+		first = 0;
+		count = 0;
+		used = 0;
+	}
+
+	/// \brief Copies the record into the arena, evicts the oldest records, if there is not enough space
+	/// \returns false, if the record is larger than the arena
+	bool push_back(const void *aData, std::size_t aSize, const Tmeta &aMeta)
+	{
+		if (aSize > arenaSize) {
+			return false;
+		}
+
+		std::size_t offset = empty() ? 0 : back().offset + back().size;
+
+		if (offset + aSize > arenaSize) {
+			offset = 0;
+		}
+
+		while (!empty() && (count == N || overlaps(front(), offset, aSize))) {
+			pop_front();
+			++nEvicted;
+		}
+
+		if (aSize > 0) {
+			std::memcpy(arena + offset, aData, aSize);
+		}
+
+		entries[(first + count) % N] = Entry{offset, aSize, aMeta};
+		++count;
+		used += aSize;
+
+		return true;
+	}
+
+	/// \brief The record would be placed w/o evicting any other one. While it holds, the front record may be read
+	/// w/o a lock, as `push_back` does not touch it
+	bool fits(std::size_t aSize) const
+	{
+		if (aSize > arenaSize || count == N) {
+			return false;
+		}
+
+		if (empty()) {
+			return true;
+		}
+
+		std::size_t offset = back().offset + back().size;
+
+		if (offset + aSize > arenaSize) {
+			offset = 0;
+		}
+
+		return !overlaps(front(), offset, aSize);
+	}
+
+	const Entry &front() const
+	{
+		assert(!empty());
+
+		return entries[first];
+	}
+
+	const Entry &back() const
+	{
+		assert(!empty());
+
+		return entries[(first + count - 1) % N];
+	}
+
+	/// \brief Index 0 is the oldest record
+	const Entry &at(std::size_t aPos) const
+	{
+		assert(aPos < count);
+
+		return entries[(first + aPos) % N];
+	}
+
+	const std::uint8_t *data(const Entry &aEntry) const
+	{
+		return arena + aEntry.offset;
+	}
+
+	void pop_front()
+	{
+		assert(!empty());
+		used -= front().size;
+		first = (first + 1) % N;
+		--count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	/// \brief Number of records
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	static constexpr std::size_t maxSize()
+	{
+		return N;
+	}
+
+	std::size_t capacityBytes() const
+	{
+		return arenaSize;
+	}
+
+	/// \brief Bytes taken by the records, w/o the unused tail
+	std::size_t usedBytes() const
+	{
+		return used;
+	}
+
+	/// \brief Number of records evicted by `push_back`, i.e. lost before they have been popped
+	std::uint32_t evicted() const
+	{
+		return nEvicted;
+	}
+
+private:
+	static bool overlaps(const Entry &aEntry, std::size_t aOffset, std::size_t aSize)
+	{
+		return aEntry.offset < aOffset + aSize && aOffset < aEntry.offset + aEntry.size;
+	}
+
+private:
+	std::uint8_t *arena;
+	std::size_t arenaSize;
+	std::array<Entry, N> entries;
+	std::size_t first;  ///< Oldest record
+	std::size_t count;
+	std::size_t used;
+	std::uint32_t nEvicted;
+};
+
+}  // namespace Cont
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_CONT_BYTERING_HPP
@@ -0,0 +1,110 @@
+//
+// Mailbox.hpp
+//
+
+#ifndef UTILITY_UTILITY_CONT_MAILBOX_HPP
+#define UTILITY_UTILITY_CONT_MAILBOX_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace Ut {
+namespace Cont {
+
+/// \brief Single-producer, single-consumer, single-slot "latest value" mailbox.
+///
+/// \details Lock-free triple buffer: the producer and the consumer own a slot
+/// each, the third one is exchanged between them atomically. Neither side ever
+/// waits for the other. A value which has not been taken before the next one
+/// is posted is stale: it gets dropped (reset to `T{}`, so e.g. a frame handle
+/// is released right away), and counted.
+template <class T>
+class Mailbox {
+public:
+	using Counter = std::uint32_t;
+
+	Mailbox() : slots{}, back{0}, middle{1}, front{2}, nPosted{0}, nDropped{0}
+	{
+	}
+
+	Mailbox(const Mailbox &) = delete;
+	Mailbox(Mailbox &&) = delete;
+	Mailbox &operator=(const Mailbox &) = delete;
+	Mailbox &operator=(Mailbox &&) = delete;
+
+	/// \brief Producer's side. Replaces the pending value, if there is one
+	/// \returns false, if a pending value has been dropped
+	template <class U>
+	bool post(U &&aValue)
+	{
+		slots[back] = std::forward<U>(aValue);
+		const unsigned prev = middle.exchange(back | kFresh, std::memory_order_acq_rel);
+		back = prev & kIndexMask;
+		nPosted.fetch_add(1, std::memory_order_relaxed);
+
+		if (prev & kFresh) {
+			slots[back] = T{};
+			nDropped.fetch_add(1, std::memory_order_relaxed);
+
+			return false;
+		}
+
+		return true;
+	}
+
+	/// \brief Consumer's side. Moves the pending value out, if there is one
+	bool take(T &aOut)
+	{
+		if (!(middle.load(std::memory_order_acquire) & kFresh)) {
+			return false;
+		}
+
+		const unsigned prev = middle.exchange(front, std::memory_order_acq_rel);
+		front = prev & kIndexMask;
+		aOut = std::move(slots[front]);
+		slots[front] = T{};
+
+		return true;
+	}
+
+	/// \brief Consumer's side. Drops the pending value, if there is one, w/o counting it as stale
+	void clear()
+	{
+		T value{};
+		take(value);
+	}
+
+	bool pending() const
+	{
+		return middle.load(std::memory_order_acquire) & kFresh;
+	}
+
+	/// \brief Number of values posted
+	Counter posted() const
+	{
+		return nPosted.load(std::memory_order_relaxed);
+	}
+
+	/// \brief Number of values replaced before the consumer has taken them
+	Counter dropped() const
+	{
+		return nDropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr unsigned kIndexMask = 0x3;
+	static constexpr unsigned kFresh = 0x4;  ///< The exchanged slot holds a value not taken yet
+
+	T slots[3];
+	unsigned back;  ///< Producer's slot
+	std::atomic<unsigned> middle;  ///< Exchanged slot, w/ `kFresh` flag
+	unsigned front;  ///< Consumer's slot
+	std::atomic<Counter> nPosted;
+	std::atomic<Counter> nDropped;
+};
+
+}  // namespace Cont
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_CONT_MAILBOX_HPP
@@ -0,0 +1,145 @@
+//
+// Pool.hpp
+//
+
+#ifndef UTILITY_UTILITY_CONT_POOL_HPP
+#define UTILITY_UTILITY_CONT_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Ut {
+namespace Cont {
+
+/// \brief Fixed-capacity object pool. Instances are constructed in statically
+/// reserved slots, so no heap allocations are made.
+///
+/// \details Slot acquisition and release are lock-free, so a pool may be
+/// shared between a producer (e.g. camera thread) and the consumers which
+/// release instances it has produced.
+template <class T, std::size_t N>
+class Pool {
+	static_assert(N > 0, "A pool must have at least one slot");
+	using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+public:
+	static constexpr std::size_t kCapacity = N;
+
+	Pool()
+	{
+		for (auto &slotUsed : used) {
+			slotUsed.store(false);
+		}
+	}
+
+	~Pool()
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			if (used[i].load()) {
+				at(i)->~T();
+			}
+		}
+	}
+
+	Pool(const Pool &) = delete;
+	Pool(Pool &&) = delete;
+	Pool &operator=(const Pool &) = delete;
+	Pool &operator=(Pool &&) = delete;
+
+	/// \brief Constructs an instance in the first free slot.
+	/// \returns nullptr, if the pool is exhausted
+	template <class ...Ts>
+	T *tryEmplace(Ts &&...aArgs)
+	{
+		for (std::size_t i = 0; i < N; ++i) {
+			if (tryAcquire(i)) {
+				return new (static_cast<void *>(&storage[i])) T{std::forward<Ts>(aArgs)...};
+			}
+		}
+
+		return nullptr;
+	}
+
+	/// \brief Constructs an instance in a particular slot. Useful, when slots
+	/// mirror an external set of resources (e.g. driver's frame buffers).
+	/// \returns nullptr, if the slot is in use or out of range
+	template <class ...Ts>
+	T *tryEmplaceAt(std::size_t aSlot, Ts &&...aArgs)
+	{
+		if (aSlot >= N || !tryAcquire(aSlot)) {
+			return nullptr;
+		}
+
+		return new (static_cast<void *>(&storage[aSlot])) T{std::forward<Ts>(aArgs)...};
+	}
+
+	/// \brief Destructs the instance, and returns its slot back into the pool
+	/// \pre `aInstance` has been produced by this pool
+	void destroy(T *aInstance)
+	{
+		const std::size_t slot = slotOf(aInstance);
+		aInstance->~T();
+		used[slot].store(false, std::memory_order_release);
+	}
+
+	bool isUsed(std::size_t aSlot) const
+	{
+		return aSlot < N && used[aSlot].load(std::memory_order_acquire);
+	}
+
+	std::size_t countUsed() const
+	{
+		std::size_t count = 0;
+
+		for (const auto &slotUsed : used) {
+			count += slotUsed.load(std::memory_order_relaxed) ? 1 : 0;
+		}
+
+		return count;
+	}
+
+	static constexpr std::size_t capacity()
+	{
+		return N;
+	}
+
+	/// \brief Static memory footprint of the pool, in bytes
+	static constexpr std::size_t footprint()
+	{
+		return sizeof(Pool<T, N>);
+	}
+
+private:
+	bool tryAcquire(std::size_t aSlot)
+	{
+		bool expected = false;
+
+		return used[aSlot].compare_exchange_strong(expected, true, std::memory_order_acquire,
+			std::memory_order_relaxed);
+	}
+
+	T *at(std::size_t aSlot)
+	{
+		return reinterpret_cast<T *>(&storage[aSlot]);
+	}
+
+	std::size_t slotOf(const T *aInstance) const
+	{
+		return static_cast<std::size_t>(reinterpret_cast<const Storage *>(aInstance) - &storage[0]);
+	}
+
+private:
+	Storage storage[N];
+	std::atomic<bool> used[N];
+};
+
+template <class T, std::size_t N>
+constexpr std::size_t Pool<T, N>::kCapacity;
+
+}  // namespace Cont
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_CONT_POOL_HPP
@@ -0,0 +1,332 @@
+//
+// SpmcRing.hpp
+//
+
+#ifndef UTILITY_UTILITY_CONT_SPMCRING_HPP
+#define UTILITY_UTILITY_CONT_SPMCRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace Ut {
+namespace Cont {
+namespace Impl {
+
+struct SpmcRingYield {
+	void operator()()
+	{
+		std::this_thread::yield();
+	}
+};
+
+}  // namespace Impl
+
+/// \brief Single-producer, multiple-consumer ring with drop-oldest policy.
+///
+/// \details Each consumer has its own read cursor, so consumers do not affect
+/// each other, and none of them affects the producer: when a consumer lags
+/// behind for more than `N` items, the oldest items are dropped for that
+/// consumer only, and its drop counter gets increased.
+///
+/// Consumers copy items out of the ring (`T` is expected to be a cheap handle,
+/// e.g. `Cam::FramePtr`). A slot being copied from is protected by a reader
+/// counter. The producer invalidates a slot before overwriting it, and only
+/// waits for the readers which managed to enter the slot before that, which is
+/// a window of a few instructions. `Tbackoff` is invoked while waiting.
+/// `tryPush` does not wait at all, it gives up on the item instead.
+///
+/// \details An item is only kept while there are registered consumers which
+/// have not read it yet. The last one to read it (or to unregister) clears the
+/// slot, so a handle stored in the ring does not outlive its readers (e.g. a
+/// camera buffer is not held up by the ring once every consumer has got it).
+///
+/// \tparam N - ring depth
+/// \tparam Nconsumers - max. number of simultaneously registered consumers
+template <class T, std::size_t N, std::size_t Nconsumers, class Tbackoff = Impl::SpmcRingYield>
+class SpmcRing {
+	static_assert(N > 0, "Ring depth must be positive");
+	static_assert(Nconsumers > 0, "There must be at least 1 consumer");
+	static_assert(Nconsumers <= 32, "Consumers are tracked by a 32-bit mask");
+
+public:
+	using Counter = std::uint32_t;
+	static constexpr int kNoConsumer = -1;
+
+	struct ConsumerStats {
+		Counter consumed;  ///< Number of items that have been read
+		Counter dropped;  ///< Number of items overwritten before the consumer managed to read them
+		Counter lag;  ///< Number of items pending
+	};
+
+	SpmcRing() : registeredMask{0}, head{0}
+	{
+		for (auto &slot : slots) {
+			slot.seq.store(kSeqEmpty);
+			slot.readers.store(0);
+			slot.pending.store(0);
+		}
+
+		for (auto &consumer : consumers) {
+			consumer.registered.store(false);
+			consumer.cursor.store(0);
+			consumer.consumed.store(0);
+			consumer.dropped.store(0);
+		}
+	}
+
+	SpmcRing(const SpmcRing &) = delete;
+	SpmcRing(SpmcRing &&) = delete;
+	SpmcRing &operator=(const SpmcRing &) = delete;
+	SpmcRing &operator=(SpmcRing &&) = delete;
+
+	/// \brief Places the item into the ring. Never blocks on consumers. May
+	/// only be called from one thread.
+	void push(T aItem)
+	{
+		while (!write(aItem)) {
+			Tbackoff{}();
+		}
+		// The displaced item is released on return, outside of the critical window
+	}
+
+	/// \brief Same as `push`, but never waits. May only be called from the
+	/// thread `push` is called from.
+	/// \returns false, if a reader is in the slot at the moment, in which case
+	/// the item is not placed
+	bool tryPush(T aItem)
+	{
+		return write(aItem);
+	}
+
+	/// \brief Registers a new consumer. The consumer will only receive items
+	/// pushed after the registration.
+	/// \returns consumer id, or `kNoConsumer`, if the consumer table is full
+	int registerConsumer()
+	{
+		for (std::size_t i = 0; i < Nconsumers; ++i) {
+			bool expected = false;
+
+			if (consumers[i].registered.compare_exchange_strong(expected, true)) {
+				consumers[i].cursor.store(head.load(std::memory_order_acquire));
+				consumers[i].consumed.store(0);
+				consumers[i].dropped.store(0);
+				registeredMask.fetch_or(bit(i), std::memory_order_seq_cst);
+
+				return static_cast<int>(i);
+			}
+		}
+
+		return kNoConsumer;
+	}
+
+	/// \brief Releases the items the consumer has not read. Must not be called
+	/// concurrently w/ `tryPop` for the same consumer.
+	void unregisterConsumer(int aConsumer)
+	{
+		if (!isValid(aConsumer)) {
+			return;
+		}
+
+		registeredMask.fetch_and(~bit(aConsumer), std::memory_order_seq_cst);
+		consumers[aConsumer].registered.store(false);
+
+		for (auto &slot : slots) {
+			T released{};
+			slot.readers.fetch_add(1, std::memory_order_seq_cst);
+			const Counter seq = slot.seq.load(std::memory_order_seq_cst);
+
+			if (seq != kSeqEmpty && seq != kSeqWriting) {
+				release(slot, bit(aConsumer), released);
+			}
+
+			slot.readers.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	/// \brief Skips all pending items, so the next read returns an item pushed
+	/// after the call. Skipped items are not considered dropped.
+	void skipPending(int aConsumer)
+	{
+		if (isValid(aConsumer)) {
+			consumers[aConsumer].cursor.store(head.load(std::memory_order_acquire));
+		}
+	}
+
+	/// \brief Reads the next item. Only the consumer owning `aConsumer` id may
+	/// call this method with that id.
+	/// \returns false, if there are no pending items
+	bool tryPop(int aConsumer, T &aOut)
+	{
+		if (!isValid(aConsumer)) {
+			return false;
+		}
+
+		Consumer &consumer = consumers[aConsumer];
+		Counter cursor = consumer.cursor.load(std::memory_order_relaxed);
+
+		while (true) {
+			const Counter itemsPushed = head.load(std::memory_order_acquire);
+
+			if (cursor == itemsPushed) {
+				consumer.cursor.store(cursor, std::memory_order_relaxed);
+
+				return false;
+			}
+
+			if (itemsPushed - cursor > N) {  // Lapped by the producer
+				consumer.dropped.fetch_add(itemsPushed - cursor - N, std::memory_order_relaxed);
+				cursor = itemsPushed - N;
+			}
+
+			Slot &slot = slots[cursor % N];
+			bool read = false;
+			T item{};
+			T released{};  // Destroyed outside of the slot
+			slot.readers.fetch_add(1, std::memory_order_seq_cst);
+
+			if (slot.seq.load(std::memory_order_seq_cst) == cursor + 1
+					&& (slot.pending.load(std::memory_order_seq_cst) & bit(aConsumer)) != 0) {
+				item = slot.value;
+				read = true;
+				release(slot, bit(aConsumer), released);
+			}
+
+			slot.readers.fetch_sub(1, std::memory_order_release);
+			++cursor;
+
+			if (read) {
+				consumer.cursor.store(cursor, std::memory_order_relaxed);
+				consumer.consumed.fetch_add(1, std::memory_order_relaxed);
+				aOut = std::move(item);
+
+				return true;
+			} else {  // The slot is being overwritten at the moment, hence the item is lost
+				consumer.dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	ConsumerStats stats(int aConsumer) const
+	{
+		if (!isValid(aConsumer)) {
+			return {0, 0, 0};
+		}
+
+		const Consumer &consumer = consumers[aConsumer];
+		const Counter itemsPushed = head.load(std::memory_order_relaxed);
+		const Counter cursor = consumer.cursor.load(std::memory_order_relaxed);
+		const Counter lag = itemsPushed - cursor;
+
+		return {consumer.consumed.load(std::memory_order_relaxed), consumer.dropped.load(std::memory_order_relaxed),
+			lag > N ? static_cast<Counter>(N) : lag};
+	}
+
+	Counter pushed() const
+	{
+		return head.load(std::memory_order_relaxed);
+	}
+
+	static constexpr std::size_t depth()
+	{
+		return N;
+	}
+
+	static constexpr std::size_t maxConsumers()
+	{
+		return Nconsumers;
+	}
+
+private:
+	static constexpr Counter kSeqEmpty = 0;
+	static constexpr Counter kSeqWriting = ~static_cast<Counter>(0);
+
+	struct Slot {
+		std::atomic<Counter> seq;  ///< (# of the item stored) + 1
+		std::atomic<Counter> readers;
+		std::atomic<std::uint32_t> pending;  ///< Mask of the consumers which have not read the item yet
+		T value;
+	};
+
+	struct Consumer {
+		std::atomic<bool> registered;
+		std::atomic<Counter> cursor;  ///< # of the next item to read
+		std::atomic<Counter> consumed;
+		std::atomic<Counter> dropped;
+	};
+
+	static std::uint32_t bit(std::size_t aConsumer)
+	{
+		return static_cast<std::uint32_t>(1) << aConsumer;
+	}
+
+	/// \brief Makes the slot unavailable for new readers, and, unless there
+	/// are readers who have already entered it, stores the item. The displaced
+	/// item is swapped into `aItem`
+	bool write(T &aItem)
+	{
+		const Counter item = head.load(std::memory_order_relaxed);
+		Slot &slot = slots[item % N];
+		const Counter seqPrevious = slot.seq.load(std::memory_order_relaxed);
+		slot.seq.store(kSeqWriting, std::memory_order_seq_cst);
+
+		if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+			slot.seq.store(seqPrevious, std::memory_order_release);
+
+			return false;
+		}
+
+		const std::uint32_t readers = registeredMask.load(std::memory_order_seq_cst);
+
+		if (readers != 0) {
+			std::swap(slot.value, aItem);
+		} else {  // Nobody would release it
+			T empty{};
+			std::swap(slot.value, empty);
+		}
+
+		slot.pending.store(readers, std::memory_order_seq_cst);
+		slot.seq.store(item + 1, std::memory_order_release);
+		head.store(item + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/// \brief Marks the slot's item as read by the consumer. The last one
+	/// takes the item out into `aReleased`. Must be called from inside the
+	/// slot (the reader counter incremented)
+	static void release(Slot &aSlot, std::uint32_t aBit, T &aReleased)
+	{
+		if (aSlot.pending.fetch_and(~aBit, std::memory_order_seq_cst) == aBit) {
+			std::swap(aSlot.value, aReleased);
+		}
+	}
+
+	bool isValid(int aConsumer) const
+	{
+		return aConsumer >= 0 && static_cast<std::size_t>(aConsumer) < Nconsumers
+			&& consumers[aConsumer].registered.load(std::memory_order_relaxed);
+	}
+
+private:
+	Slot slots[N];
+	Consumer consumers[Nconsumers];
+	std::atomic<std::uint32_t> registeredMask;
+	std::atomic<Counter> head;  ///< # of items pushed so far
+};
+
+template <class T, std::size_t N, std::size_t Nconsumers, class Tbackoff>
+constexpr typename SpmcRing<T, N, Nconsumers, Tbackoff>::Counter SpmcRing<T, N, Nconsumers, Tbackoff>::kSeqEmpty;
+
+template <class T, std::size_t N, std::size_t Nconsumers, class Tbackoff>
+constexpr typename SpmcRing<T, N, Nconsumers, Tbackoff>::Counter SpmcRing<T, N, Nconsumers, Tbackoff>::kSeqWriting;
+
+template <class T, std::size_t N, std::size_t Nconsumers, class Tbackoff>
+constexpr int SpmcRing<T, N, Nconsumers, Tbackoff>::kNoConsumer;
+
+}  // namespace Cont
+}  // namespace Ut
+
+#endif  // UTILITY_UTILITY_CONT_SPMCRING_HPP
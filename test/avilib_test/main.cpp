@@ -0,0 +1,337 @@
+#define OHDEBUG_PORT_ENABLE 1
+#define OHDEBUG_TAGS_ENABLE "Trace"
+
+#include <OhDebug.hpp>
+
+extern "C" {
+#include "avilib/avilib.h"
+}
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static constexpr long kClusterSize = 32 * 1024;
+
+/// \brief Output directory. Point it to a mounted FAT image (`mkfs.fat -C fat.img 262144 && mount -o loop ...`) to
+/// benchmark against the actual file system
+static std::string outputPath(const char *aName)
+{
+	const char *dir = std::getenv("AVILIB_TEST_DIR");
+
+	return std::string{dir != nullptr ? dir : "."} + "/" + aName;
+}
+
+static std::vector<char> makeFrame(std::size_t aSize, unsigned aSeed)
+{
+	std::vector<char> frame(aSize);
+
+	for (std::size_t i = 0; i < aSize; ++i) {
+		frame[i] = static_cast<char>(i * 31 + aSeed);
+	}
+
+	return frame;
+}
+
+static std::vector<char> readFile(const std::string &aPath)
+{
+	std::ifstream file{aPath, std::ios::binary};
+
+	return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+struct WriteResult {
+	double seconds;
+	long writes;
+	long unalignedWrites;
+};
+
+/// \brief Writes `aFrameSizes.size()` frames, the way `RecMjpgAvi` does
+static WriteResult writeAvi(const std::string &aPath, const std::vector<std::size_t> &aFrameSizes, char *aBuffer,
+	long aBufferSize)
+{
+	std::vector<std::vector<char>> frames{};
+
+	for (std::size_t i = 0; i < aFrameSizes.size(); ++i) {
+		frames.push_back(makeFrame(aFrameSizes[i], i));
+	}
+
+	const auto started = std::chrono::steady_clock::now();
+	avi_t *avi = AVI_open_output_file_buffered(const_cast<char *>(aPath.c_str()), aBuffer, aBufferSize);
+	assert(avi != nullptr);
+
+	for (auto &frame : frames) {
+		assert(AVI_write_frame(avi, frame.data(), frame.size()) == 0);
+	}
+
+	AVI_set_video(avi, 640, 480, 25.0, const_cast<char *>("MJPG"));
+	const WriteResult result{0.0, avi->n_writes + 1, avi->n_unaligned_writes};  // + the tail, written on close
+	assert(AVI_close(avi) == 0);
+	sync();
+
+	return {std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(), result.writes,
+		result.unalignedWrites};
+}
+
+OHDEBUG_TEST("avilib, coalesced writes, cluster-aligned, same output")
+{
+	std::vector<std::size_t> frameSizes{};
+
+	for (std::size_t i = 0; i < 200; ++i) {
+		frameSizes.push_back(1 + (i * 7919) % 70000);  // Odd and even sizes, some larger than a cluster
+	}
+
+	std::vector<char> buffer(kClusterSize);
+	writeAvi(outputPath("plain.avi"), frameSizes, nullptr, 0);
+	const auto coalesced = writeAvi(outputPath("coalesced.avi"), frameSizes, buffer.data(), buffer.size());
+	const auto plainFile = readFile(outputPath("plain.avi"));
+	const auto coalescedFile = readFile(outputPath("coalesced.avi"));
+	assert(plainFile == coalescedFile);
+	assert(coalesced.unalignedWrites == 0);  // Only the tail, which is not counted in `n_unaligned_writes` yet
+	assert(static_cast<std::size_t>(coalesced.writes) <= plainFile.size() / kClusterSize + 1);
+	OHDEBUG("Trace", "file size", plainFile.size(), "coalesced writes", coalesced.writes);
+
+	// Too small a buffer falls back to unbuffered output
+	const auto fallback = writeAvi(outputPath("fallback.avi"), frameSizes, buffer.data(), 512);
+	assert(fallback.writes == 1 && readFile(outputPath("fallback.avi")) == plainFile);
+}
+
+OHDEBUG_TEST("avilib, benchmark, per-frame writes vs coalesced writes")
+{
+	static constexpr std::size_t kFrames = 500;
+	std::vector<std::size_t> frameSizes{};
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		frameSizes.push_back(20000 + (i * 7919) % 20000);  // 20-40 KiB, typical for SVGA JPEG
+	}
+
+	std::vector<char> buffer(kClusterSize);
+	const auto plain = writeAvi(outputPath("plain.avi"), frameSizes, nullptr, 0);
+	const auto coalesced = writeAvi(outputPath("coalesced.avi"), frameSizes, buffer.data(), buffer.size());
+	const auto plainFile = readFile(outputPath("plain.avi"));
+	assert(readFile(outputPath("coalesced.avi")) == plainFile);
+	assert(coalesced.unalignedWrites == 0);
+	assert(static_cast<std::size_t>(coalesced.writes) <= plainFile.size() / kClusterSize + 1);
+	const double megabytes = plainFile.size() / 1e6;
+	OHDEBUG("Trace", "per-frame writes, MB/s", megabytes / plain.seconds);
+	OHDEBUG("Trace", "coalesced, MB/s", megabytes / coalesced.seconds, "writes", coalesced.writes,
+		"unaligned", coalesced.unalignedWrites);
+
+	for (const char *name : {"plain.avi", "coalesced.avi", "fallback.avi"}) {
+		std::remove(outputPath(name).c_str());
+	}
+}
+
+OHDEBUG_TEST("avilib, index spilled to the sidecar, stitched into idx1")
+{
+	static constexpr std::size_t kFrames = 1300;  // The RAM block is spilled twice
+	const auto path = outputPath("indexed.avi");
+	std::vector<char> buffer(kClusterSize);
+	avi_t *avi = AVI_open_output_file_buffered(const_cast<char *>(path.c_str()), buffer.data(), buffer.size());
+	assert(avi != nullptr);
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		auto frame = makeFrame(100 + i % 301, i);
+		assert(AVI_write_frame(avi, frame.data(), frame.size()) == 0);
+	}
+
+	assert(avi->idx_sidecar != nullptr && avi->idx_ram < avi->max_idx);
+	const std::string sidecar{avi->idx_sidecar_name};
+	AVI_set_video(avi, 640, 480, 25.0, const_cast<char *>("MJPG"));
+	assert(AVI_close(avi) == 0);
+	assert(std::fopen(sidecar.c_str(), "rb") == nullptr);  // Removed on close
+
+	avi = AVI_open_input_file(const_cast<char *>(path.c_str()), 1);
+	assert(avi != nullptr);
+	assert(AVI_video_frames(avi) == static_cast<long>(kFrames));
+	std::vector<char> read(512);
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		const auto frame = makeFrame(100 + i % 301, i);
+		assert(AVI_read_frame(avi, read.data()) == static_cast<long>(frame.size()));
+		assert(std::equal(frame.begin(), frame.end(), read.begin()));
+	}
+
+	AVI_close(avi);
+	std::remove(path.c_str());
+}
+
+OHDEBUG_TEST("avilib, coalescing buffer handed over between files, same output")
+{
+	std::vector<std::size_t> frameSizes{};
+
+	for (std::size_t i = 0; i < 100; ++i) {
+		frameSizes.push_back(1 + (i * 7919) % 70000);
+	}
+
+	const std::vector<std::size_t> firstSizes{frameSizes.begin(), frameSizes.begin() + 50};
+	const std::vector<std::size_t> secondSizes{frameSizes.begin() + 50, frameSizes.end()};
+	writeAvi(outputPath("first_ref.avi"), firstSizes, nullptr, 0);
+	writeAvi(outputPath("second_ref.avi"), secondSizes, nullptr, 0);
+
+	// Segments of a recording: the second file is opened ahead of time, and takes the buffer over on rollover
+	std::vector<char> buffer(kClusterSize);
+	avi_t *first = AVI_open_output_file_buffered(const_cast<char *>(outputPath("first.avi").c_str()), buffer.data(),
+		buffer.size());
+	avi_t *second = AVI_open_output_file_buffered(const_cast<char *>(outputPath("second.avi").c_str()), nullptr,
+		buffer.size());
+	assert(first != nullptr && second != nullptr);
+
+	for (std::size_t i = 0; i < firstSizes.size(); ++i) {
+		auto frame = makeFrame(firstSizes[i], i);
+		assert(AVI_write_frame(first, frame.data(), frame.size()) == 0);
+	}
+
+	assert(AVI_set_output_buffer(first, nullptr) == 0);
+	assert(AVI_set_output_buffer(second, buffer.data()) == 0);
+	const long firstWrites = first->n_writes;
+
+	for (std::size_t i = 0; i < secondSizes.size(); ++i) {
+		auto frame = makeFrame(secondSizes[i], i);
+		assert(AVI_write_frame(second, frame.data(), frame.size()) == 0);
+	}
+
+	assert(second->n_unaligned_writes <= 2);  // The header, and the first block after the buffer has been attached
+	AVI_set_video(first, 640, 480, 25.0, const_cast<char *>("MJPG"));
+	AVI_set_video(second, 640, 480, 25.0, const_cast<char *>("MJPG"));
+	assert(AVI_close(first) == 0 && AVI_close(second) == 0);
+	assert(readFile(outputPath("first.avi")) == readFile(outputPath("first_ref.avi")));
+	assert(readFile(outputPath("second.avi")) == readFile(outputPath("second_ref.avi")));
+	OHDEBUG("Trace", "first segment writes", firstWrites);
+
+	for (const char *name : {"first.avi", "first_ref.avi", "second.avi", "second_ref.avi"}) {
+		std::remove(outputPath(name).c_str());
+	}
+}
+
+static void writeFile(const std::string &aPath, const std::vector<char> &aContent)
+{
+	std::ofstream file{aPath, std::ios::binary};
+	file.write(aContent.data(), aContent.size());
+}
+
+/// \brief Checks that `aPath` has exactly `aFrameSizes.size()` frames produced by `makeFrame`
+static void assertFrames(const std::string &aPath, const std::vector<std::size_t> &aFrameSizes)
+{
+	avi_t *avi = AVI_open_input_file(const_cast<char *>(aPath.c_str()), 1);
+	assert(avi != nullptr);
+	assert(AVI_video_frames(avi) == static_cast<long>(aFrameSizes.size()));
+	std::vector<char> read(70000);
+
+	for (std::size_t i = 0; i < aFrameSizes.size(); ++i) {
+		const auto frame = makeFrame(aFrameSizes[i], i);
+		assert(AVI_read_frame(avi, read.data()) == static_cast<long>(frame.size()));
+		assert(std::equal(frame.begin(), frame.end(), read.begin()));
+	}
+
+	AVI_close(avi);
+}
+
+OHDEBUG_TEST("avilib, checkpoints, recovery of a truncated recording")
+{
+	static constexpr std::size_t kFrames = 1200;
+	static constexpr std::size_t kCheckpointPeriod = 100;
+	const auto path = outputPath("live.avi");
+	std::vector<char> buffer(kClusterSize);
+	avi_t *avi = AVI_open_output_file_buffered(const_cast<char *>(path.c_str()), buffer.data(), buffer.size());
+	assert(avi != nullptr);
+	AVI_set_video(avi, 640, 480, 25.0, const_cast<char *>("MJPG"));
+	std::vector<std::size_t> frameSizes{};
+	std::vector<long> frameEnds{};
+	long checkpointEnd = 0;
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		frameSizes.push_back(1 + (i * 7919) % 7000);
+		auto frame = makeFrame(frameSizes.back(), i);
+		assert(AVI_write_frame(avi, frame.data(), frame.size()) == 0);
+		frameEnds.push_back(avi->pos);
+
+		if (i % kCheckpointPeriod == kCheckpointPeriod - 1 && i + kCheckpointPeriod < kFrames) {
+			const long writes = avi->n_unaligned_writes;
+			assert(AVI_checkpoint(avi) == 0);
+			assert(avi->n_unaligned_writes == writes + 1);  // Only the partial block gets written out of order
+			checkpointEnd = avi->pos;
+		}
+	}
+
+	// Power loss: whatever has reached the file, and cut in the middle of a frame
+	auto crashed = readFile(path);
+	const auto sidecar = readFile(avi->idx_sidecar_name);
+	assert(crashed.size() >= static_cast<std::size_t>(checkpointEnd) && !sidecar.empty());
+	const long cut = (frameEnds[kFrames - 60] + frameEnds[kFrames - 59]) / 2;
+	crashed.resize(std::min<std::size_t>(crashed.size(), cut));
+	writeFile(outputPath("crashed.avi"), crashed);
+	writeFile(outputPath("crashed.idx"), sidecar);
+	assert(AVI_close(avi) == 0);
+
+	// The header of the last checkpoint is readable as it is
+	std::size_t nRecovered = std::count_if(frameEnds.begin(), frameEnds.end(),
+		[&crashed](long aEnd) { return aEnd <= static_cast<long>(crashed.size()); });
+	assert(AVI_recover(const_cast<char *>(outputPath("crashed.avi").c_str()), 0.0) == static_cast<long>(nRecovered));
+	assert(std::fopen(outputPath("crashed.idx").c_str(), "rb") == nullptr);  // Removed
+	frameSizes.resize(nRecovered);
+	assertFrames(outputPath("crashed.avi"), frameSizes);
+	avi = AVI_open_input_file(const_cast<char *>(outputPath("crashed.avi").c_str()), 1);
+	assert(avi != nullptr && AVI_video_width(avi) == 640 && AVI_video_height(avi) == 480);
+	assert(static_cast<int>(AVI_frame_rate(avi) + 0.5) == 25);
+	AVI_close(avi);
+	OHDEBUG("Trace", "recovered frames", nRecovered, "of", kFrames);
+
+	// Nothing to do w/ a file which has been closed
+	assert(AVI_recover(const_cast<char *>(outputPath("crashed.avi").c_str()), 0.0) == 0);
+	assert(AVI_recover(const_cast<char *>(path.c_str()), 0.0) == 0);
+
+	for (const char *name : {"live.avi", "crashed.avi"}) {
+		std::remove(outputPath(name).c_str());
+	}
+}
+
+OHDEBUG_TEST("avilib, recovery w/o a checkpoint, frame size taken from JPEG")
+{
+	static constexpr std::size_t kFrames = 20;
+	const auto path = outputPath("nohdr.avi");
+	avi_t *avi = AVI_open_output_file(const_cast<char *>(path.c_str()));
+	assert(avi != nullptr);
+	std::vector<std::size_t> frameSizes{};
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		frameSizes.push_back(600 + i);
+		auto frame = makeFrame(frameSizes.back(), i);
+		static const unsigned char kSof[] = {0xff, 0xd8, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x02, 0x58, 0x03, 0x20};  // 800x600
+		std::copy(std::begin(kSof), std::end(kSof), frame.begin());
+		assert(AVI_write_frame(avi, frame.data(), frame.size()) == 0);
+	}
+
+	fflush(avi->fdes);
+	writeFile(outputPath("nohdr2.avi"), readFile(path));
+	AVI_close(avi);
+	assert(AVI_recover(const_cast<char *>(outputPath("nohdr2.avi").c_str()), 10.0) == static_cast<long>(kFrames));
+	avi = AVI_open_input_file(const_cast<char *>(outputPath("nohdr2.avi").c_str()), 1);
+	assert(avi != nullptr && AVI_video_frames(avi) == static_cast<long>(kFrames));
+	assert(AVI_video_width(avi) == 800 && AVI_video_height(avi) == 600);
+	assert(static_cast<int>(AVI_frame_rate(avi) + 0.5) == 10);
+	AVI_close(avi);
+
+	// A file w/o a single complete frame cannot be recovered
+	writeFile(outputPath("nohdr2.avi"), std::vector<char>(2048 + 100, 0));
+	assert(AVI_recover(const_cast<char *>(outputPath("nohdr2.avi").c_str()), 10.0) == -1);
+
+	for (const char *name : {"nohdr.avi", "nohdr2.avi"}) {
+		std::remove(outputPath(name).c_str());
+	}
+}
+
+int main(void)
+{
+	OHDEBUG("Trace", "avilib_test");
+	OHDEBUG_RUN_TESTS();
+
+	return 0;
+}
@@ -0,0 +1,199 @@
+#define OHDEBUG_PORT_ENABLE 1
+#define OHDEBUG_TAGS_ENABLE "Trace"
+#include <OhDebug.hpp>
+
+#include <cam/CopyPool.hpp>
+#include <cam/replay/Pacer.hpp>
+#include <cam/replay/Source.hpp>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <avilib/avilib.h>
+}
+
+static constexpr const char *kAviFile = "cam_test_replay.avi";
+static constexpr const char *kRawFile = "cam_test_replay.raw";
+
+/// \brief Produces distinguishable "JPEG" payloads of various sizes, including odd ones (RIFF padding)
+static std::vector<std::uint8_t> makePayload(std::size_t aFrame)
+{
+	static constexpr std::array<std::size_t, 5> kSizes {{1001, 2048, 40001, 17, 512}};
+	std::vector<std::uint8_t> payload(kSizes[aFrame % kSizes.size()]);
+
+	for (std::size_t i = 0; i < payload.size(); ++i) {
+		payload[i] = static_cast<std::uint8_t>(i * 7 + aFrame);
+	}
+
+	return payload;
+}
+
+OHDEBUG_TEST("Cam, replay, MJPEG AVI produced by avilib")
+{
+	constexpr std::size_t kFrames = 5;
+	avi_t *avi = AVI_open_output_file(const_cast<char *>(kAviFile));
+	assert(avi != nullptr);
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		auto payload = makePayload(i);
+		assert(AVI_write_frame(avi, reinterpret_cast<char *>(payload.data()), payload.size()) == 0);
+	}
+
+	AVI_set_video(avi, 320, 240, 10.0, const_cast<char *>("MJPG"));
+	assert(AVI_close(avi) == 0);
+
+	Cam::Replay::AviMjpegSource source{};
+	assert(source.open(kAviFile));
+	assert(source.frameCount() == kFrames);
+	assert(source.maxFrameSize() == 40001);
+	assert(source.fps() > 9.9f && source.fps() < 10.1f);
+	std::vector<std::uint8_t> buffer(source.maxFrameSize());
+
+	for (int pass = 0; pass < 2; ++pass) {
+		for (std::size_t i = 0; i < kFrames; ++i) {
+			Cam::Replay::Source::FrameInfo frameInfo{};
+			assert(source.read(buffer.data(), buffer.size(), frameInfo));
+			const auto payload = makePayload(i);
+			assert(frameInfo.size == payload.size());
+			assert(frameInfo.width == 320 && frameInfo.height == 240);
+			assert(std::equal(payload.begin(), payload.end(), buffer.begin()));
+		}
+
+		Cam::Replay::Source::FrameInfo frameInfo{};
+		assert(!source.read(buffer.data(), buffer.size(), frameInfo));
+		assert(source.rewind());
+	}
+
+	// A frame which does not fit the buffer is not read
+	Cam::Replay::Source::FrameInfo frameInfo{};
+	assert(!source.read(buffer.data(), 16, frameInfo));
+	std::remove(kAviFile);
+}
+
+OHDEBUG_TEST("Cam, replay, raw grayscale")
+{
+	constexpr int kWidth = 4;
+	constexpr int kHeight = 3;
+	constexpr std::size_t kFrames = 3;
+	std::FILE *file = std::fopen(kRawFile, "wb");
+	assert(file != nullptr);
+
+	for (std::size_t frame = 0; frame < kFrames; ++frame) {
+		for (int i = 0; i < kWidth * kHeight; ++i) {
+			std::fputc(static_cast<int>(frame * 16 + i), file);
+		}
+	}
+
+	std::fclose(file);
+	Cam::Replay::RawGrayscaleSource source{kWidth, kHeight};
+	assert(source.open(kRawFile));
+	std::array<std::uint8_t, kWidth * kHeight> buffer;
+	Cam::Replay::Source::FrameInfo frameInfo{};
+
+	for (std::size_t frame = 0; frame < kFrames; ++frame) {
+		assert(source.read(buffer.data(), buffer.size(), frameInfo));
+		assert(frameInfo.size == buffer.size() && frameInfo.width == kWidth && frameInfo.height == kHeight);
+		assert(buffer[5] == frame * 16 + 5);
+	}
+
+	assert(!source.read(buffer.data(), buffer.size(), frameInfo));
+	assert(source.rewind());
+	assert(source.read(buffer.data(), buffer.size(), frameInfo) && buffer[0] == 0);
+	std::remove(kRawFile);
+}
+
+OHDEBUG_TEST("Cam, replay, synthetic sequence")
+{
+	constexpr int kWidth = 64;
+	constexpr int kHeight = 48;
+	constexpr std::size_t kFrames = 5;
+	constexpr int kSquare = 8;
+	Cam::Replay::SyntheticSource source{kWidth, kHeight, kFrames, kSquare};
+	std::vector<std::uint8_t> buffer(source.maxFrameSize());
+	Cam::Replay::Source::FrameInfo frameInfo{};
+
+	for (std::size_t frame = 0; frame < kFrames; ++frame) {
+		assert(source.read(buffer.data(), buffer.size(), frameInfo));
+		int x = 0;
+		int y = 0;
+		source.squarePosition(frame, x, y);
+		assert(buffer[y * kWidth + x] == 255);
+		assert(buffer[(y + kSquare - 1) * kWidth + x + kSquare - 1] == 255);
+	}
+
+	int x = 0;
+	int y = 0;
+	source.squarePosition(kFrames - 1, x, y);
+	assert(x == kWidth - kSquare && y == kHeight - kSquare);
+	assert(!source.read(buffer.data(), buffer.size(), frameInfo));
+}
+
+OHDEBUG_TEST("Cam, replay, pacer")
+{
+	constexpr float kFps = 200.0f;
+	constexpr int kFrames = 20;
+	Cam::Replay::Pacer pacer{kFps};
+	const auto timeStart = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < kFrames; ++i) {
+		pacer.wait();
+	}
+
+	const auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - timeStart).count();
+	OHDEBUG("Trace", "pacer, expected, s", (kFrames - 1) / kFps, "elapsed, s", elapsed);
+	assert(elapsed >= (kFrames - 1) / kFps * 0.95f);
+}
+
+OHDEBUG_TEST("Cam, frame copies, the driver overwrites its buffer after the push")
+{
+	constexpr std::size_t kCopies = 3;
+	Cam::CopyPool<kCopies> copies{};
+	std::vector<std::uint8_t> driverBuffer{};  // The driver's only buffer (OV2640 w/ hooks)
+	std::array<int, kCopies> held{};  // Copies the "consumers" have not been done w/ yet
+	std::array<std::vector<std::uint8_t>, kCopies> expected{};
+
+	for (std::size_t i = 0; i < kCopies; ++i) {
+		driverBuffer = makePayload(i);
+		held[i] = copies.copy(driverBuffer.data(), driverBuffer.size());  // Pushed
+		assert(held[i] != Cam::CopyPool<kCopies>::kNone);
+		expected[i] = driverBuffer;
+		std::memset(driverBuffer.data(), 0xff, driverBuffer.size());  // The DMA refills it w/ the next frame
+	}
+
+	for (std::size_t i = 0; i < kCopies; ++i) {
+		assert(copies.size(held[i]) == expected[i].size());
+		assert(std::memcmp(copies.data(held[i]), expected[i].data(), expected[i].size()) == 0);
+	}
+
+	// Every copy is in use, the next frame is skipped
+	driverBuffer = makePayload(kCopies);
+	assert(copies.countUsed() == kCopies);
+	assert(copies.copy(driverBuffer.data(), driverBuffer.size()) == Cam::CopyPool<kCopies>::kNone);
+
+	// A released copy is reused, and it grows to fit a larger frame
+	copies.release(held[0]);
+	driverBuffer = makePayload(2);  // The largest one
+	const int slot = copies.copy(driverBuffer.data(), driverBuffer.size());
+	assert(slot == held[0]);
+	std::memset(driverBuffer.data(), 0, driverBuffer.size());
+	assert(std::memcmp(copies.data(slot), makePayload(2).data(), copies.size(slot)) == 0);
+	assert(std::memcmp(copies.data(held[1]), expected[1].data(), expected[1].size()) == 0);
+
+	for (std::size_t i = 0; i < kCopies; ++i) {
+		copies.release(i == 0 ? slot : held[i]);
+	}
+
+	assert(copies.countUsed() == 0);
+}
+
+int main(void)
+{
+	OHDEBUG("Trace", "cam_test");
+	OHDEBUG_RUN_TESTS();
+
+	return 0;
+}
@@ -0,0 +1,373 @@
+#define OHDEBUG_PORT_ENABLE 1
+#define OHDEBUG_TAGS_ENABLE "Trace"
+#include <OhDebug.hpp>
+
+#include <proto/Fec.hpp>
+#include <proto/Fragment.hpp>
+#include <proto/RtpJpeg.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace CameraStreamer;
+
+static std::vector<std::uint8_t> makeFrame(std::size_t aSize)
+{
+	std::vector<std::uint8_t> frame(aSize);
+
+	for (std::size_t i = 0; i < aSize; ++i) {
+		frame[i] = static_cast<std::uint8_t>(i * 13 + 5);
+	}
+
+	return frame;
+}
+
+OHDEBUG_TEST("Camera streamer, fragment header, wire format")
+{
+	const Proto::FragmentHeader header{Proto::FragmentHeader::FlagParity, 4, 0x01020304, 0x0506, 0x0708, 0x090a0b0c,
+		0x1112131415161718ULL};
+	std::array<std::uint8_t, Proto::FragmentHeader::kSize> packed{};
+	header.pack(packed.data());
+	// Big-endian, see `tools/camera_stream/reassemble.py`
+	const std::array<std::uint8_t, Proto::FragmentHeader::kSize> expected {{0xcf, 0x01, 0x01, 0x04,
+		0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c,
+		0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18}};
+	assert(packed == expected);
+
+	Proto::FragmentHeader unpacked{};
+	assert(unpacked.unpack(packed.data(), packed.size()));
+	assert(unpacked.flags == header.flags && unpacked.fecGroupSize == header.fecGroupSize);
+	assert(unpacked.frameId == header.frameId && unpacked.fragmentIndex == header.fragmentIndex
+		&& unpacked.fragmentCount == header.fragmentCount && unpacked.frameSize == header.frameSize
+		&& unpacked.timestampUs == header.timestampUs);
+	assert(!unpacked.unpack(packed.data(), packed.size() - 1));
+	packed[0] = 0;
+	assert(!unpacked.unpack(packed.data(), packed.size()));
+}
+
+OHDEBUG_TEST("Camera streamer, fragmenter, payload is referenced, frame is reassembled")
+{
+	static constexpr std::size_t kDatagramSize = 1472;
+	const Proto::Fragmenter fragmenter{kDatagramSize};
+	assert(fragmenter.payloadSize() == kDatagramSize - Proto::FragmentHeader::kSize);
+
+	for (std::size_t frameSize : {std::size_t{1}, fragmenter.payloadSize(), fragmenter.payloadSize() + 1,
+		std::size_t{100000}})
+	{
+		const auto frame = makeFrame(frameSize);
+		std::vector<std::uint8_t> reassembled{};
+		std::size_t fragments = 0;
+		const bool split = fragmenter.forEachFragment(42, 1000, frame.data(), frame.size(),
+			[&](const Proto::FragmentHeader &aHeader, const std::uint8_t *aPacked, const std::uint8_t *aPayload,
+				std::size_t aPayloadSize)
+			{
+				Proto::FragmentHeader unpacked{};
+				assert(unpacked.unpack(aPacked, Proto::FragmentHeader::kSize));
+				assert(unpacked.fragmentIndex == fragments && aHeader.fragmentIndex == fragments);
+				assert(unpacked.fragmentCount == fragmenter.fragmentCount(frameSize));
+				assert(unpacked.frameId == 42 && unpacked.timestampUs == 1000 && unpacked.frameSize == frameSize);
+				assert(aPayload == frame.data() + fragments * fragmenter.payloadSize());  // No copies
+				assert(aPayloadSize > 0 && aPayloadSize + Proto::FragmentHeader::kSize <= kDatagramSize);
+				reassembled.insert(reassembled.end(), aPayload, aPayload + aPayloadSize);
+				++fragments;
+			});
+		assert(split);
+		assert(fragments == fragmenter.fragmentCount(frameSize));
+		assert(reassembled == frame);
+		OHDEBUG("Trace", "frame size", frameSize, "fragments", fragments);
+	}
+
+	assert(!fragmenter.forEachFragment(0, 0, nullptr, 0, [](const Proto::FragmentHeader &, const std::uint8_t *,
+		const std::uint8_t *, std::size_t) {}));
+}
+
+OHDEBUG_TEST("Camera streamer, FEC, XOR kernel matches the reference")
+{
+	alignas(sizeof(std::size_t)) std::uint8_t dst[67];
+	alignas(sizeof(std::size_t)) std::uint8_t reference[67];
+	const auto src = makeFrame(sizeof(dst) + 1);
+
+	// Aligned and unaligned pointers, sizes w/ and w/o a tail
+	for (std::size_t offset : {0, 1, 3}) {
+		for (std::size_t size : {std::size_t{0}, std::size_t{5}, std::size_t{32}, sizeof(dst) - offset}) {
+			for (std::size_t i = 0; i < sizeof(dst); ++i) {
+				dst[i] = reference[i] = static_cast<std::uint8_t>(i);
+			}
+
+			Proto::xorInto(dst + offset, src.data() + offset, size);
+			Proto::xorIntoBytewise(reference + offset, src.data() + offset, size);
+			assert(std::equal(dst, dst + sizeof(dst), reference));
+		}
+	}
+}
+
+OHDEBUG_TEST("Camera streamer, FEC, a fragment lost in each group is restored")
+{
+	static constexpr std::size_t kDatagramSize = 1472;
+	static constexpr std::uint8_t kGroupSize = 4;
+	alignas(sizeof(std::size_t)) std::uint8_t parityBuffer[kDatagramSize];
+	const Proto::Fragmenter fragmenter{kDatagramSize, kGroupSize, parityBuffer};
+
+	for (std::size_t frameSize : {std::size_t{10}, std::size_t{5 * 1448}, std::size_t{5 * 1448 + 7},
+		std::size_t{100000}})
+	{
+		const auto frame = makeFrame(frameSize);
+		std::map<std::size_t, std::vector<std::uint8_t>> received{};  // Data fragments
+		std::map<std::size_t, std::vector<std::uint8_t>> parities{};
+		std::size_t nParity = 0;
+		std::size_t nData = 0;
+
+		fragmenter.forEachFragment(7, 0, frame.data(), frame.size(),
+			[&](const Proto::FragmentHeader &aHeader, const std::uint8_t *, const std::uint8_t *aPayload,
+				std::size_t aPayloadSize)
+			{
+				assert(aHeader.fecGroupSize == kGroupSize);
+
+				if (aHeader.flags & Proto::FragmentHeader::FlagParity) {
+					assert(aHeader.fragmentIndex == nParity);
+					parities[aHeader.fragmentIndex].assign(aPayload, aPayload + aPayloadSize);
+					++nParity;
+				} else if (aHeader.fragmentIndex % kGroupSize != 1) {  // Lose the 2nd fragment of each group
+					received[aHeader.fragmentIndex].assign(aPayload, aPayload + aPayloadSize);
+					++nData;
+				} else {
+					++nData;
+				}
+			});
+
+		assert(nData == fragmenter.fragmentCount(frameSize));
+		assert(nParity == (nData + kGroupSize - 1) / kGroupSize);
+
+		// Restore: XOR of the parity and the received members of the group
+		for (std::size_t i = 1; i < nData; i += kGroupSize) {
+			std::vector<std::uint8_t> restored = parities[i / kGroupSize];
+
+			for (std::size_t j = i - 1; j < std::min(i - 1 + kGroupSize, nData); ++j) {
+				if (j != i) {
+					Proto::xorIntoBytewise(restored.data(), received[j].data(), received[j].size());
+				}
+			}
+
+			restored.resize(std::min(frameSize - i * fragmenter.payloadSize(), fragmenter.payloadSize()));
+			received[i] = restored;
+		}
+
+		std::vector<std::uint8_t> reassembled{};
+
+		for (std::size_t i = 0; i < nData; ++i) {
+			reassembled.insert(reassembled.end(), received[i].begin(), received[i].end());
+		}
+
+		assert(reassembled == frame);
+	}
+}
+
+OHDEBUG_TEST("Camera streamer, FEC, benchmark, encode cost per frame")
+{
+	using Clock = std::chrono::steady_clock;
+	static constexpr std::size_t kDatagramSize = 1472;
+	static constexpr std::size_t kFrameSize = 100 * 1024;  // XGA JPEG, high quality
+	static constexpr std::size_t kIterations = 200;
+	alignas(sizeof(std::size_t)) std::uint8_t parityBuffer[kDatagramSize];
+	const auto frame = makeFrame(kFrameSize);
+	std::size_t sink = 0;
+
+	for (std::uint8_t groupSize : {0, 4, 8, 16}) {
+		const Proto::Fragmenter fragmenter{kDatagramSize, groupSize, parityBuffer};
+		std::size_t bytesSent = 0;
+		const auto start = Clock::now();
+
+		for (std::size_t i = 0; i < kIterations; ++i) {
+			fragmenter.forEachFragment(i, 0, frame.data(), frame.size(),
+				[&](const Proto::FragmentHeader &, const std::uint8_t *aHeader, const std::uint8_t *aPayload,
+					std::size_t aPayloadSize)
+				{
+					sink += aHeader[3] + aPayload[aPayloadSize - 1];
+					bytesSent += Proto::FragmentHeader::kSize + aPayloadSize;
+				});
+		}
+
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		OHDEBUG("Trace", "group size", static_cast<int>(groupSize), "us per 100 KiB frame",
+			static_cast<double>(us) / kIterations, "overhead, %",
+			100.0 * (static_cast<double>(bytesSent) / kIterations - kFrameSize) / kFrameSize);
+	}
+
+	// Raw kernel throughput, word-wide vs byte-wise
+	{
+		std::vector<std::uint8_t> dst(kFrameSize);
+		auto start = Clock::now();
+
+		for (std::size_t i = 0; i < kIterations; ++i) {
+			Proto::xorInto(dst.data(), frame.data(), kFrameSize);
+		}
+
+		const auto usWordwise = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		start = Clock::now();
+
+		for (std::size_t i = 0; i < kIterations; ++i) {
+			Proto::xorIntoBytewise(dst.data(), frame.data(), kFrameSize);
+		}
+
+		const auto usBytewise = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		sink += dst[kFrameSize / 2];
+		OHDEBUG("Trace", "XOR, us per 100 KiB, word-wide", static_cast<double>(usWordwise) / kIterations,
+			"byte-wise", static_cast<double>(usBytewise) / kIterations);
+	}
+
+	OHDEBUG("Trace", "(sink", sink, ")");
+}
+
+int main(void)
+{
+	OHDEBUG("Trace", "camera_streamer_test");
+	OHDEBUG_RUN_TESTS();
+
+	return 0;
+}
+
+/// \brief Minimal baseline JPEG: DQT (2 tables), SOF0, optional DRI, DHT, SOS, scan data, EOI, and padding
+static std::vector<std::uint8_t> makeJpeg(std::uint16_t aWidth, std::uint16_t aHeight, std::uint8_t aLumaSampling,
+	std::uint16_t aRestartInterval, std::size_t aScanSize)
+{
+	std::vector<std::uint8_t> jpeg{0xff, 0xd8, 0xff, 0xe0, 0x00, 0x04, 'J', 'F'};  // SOI, APP0
+	jpeg.insert(jpeg.end(), {0xff, 0xdb, 0x00, 2 + 2 * 65});
+
+	for (std::uint8_t id = 0; id < 2; ++id) {
+		jpeg.push_back(id);
+
+		for (std::uint8_t i = 0; i < 64; ++i) {
+			jpeg.push_back(static_cast<std::uint8_t>(id * 100 + i));
+		}
+	}
+
+	jpeg.insert(jpeg.end(), {0xff, 0xc0, 0x00, 17, 8, static_cast<std::uint8_t>(aHeight >> 8),
+		static_cast<std::uint8_t>(aHeight), static_cast<std::uint8_t>(aWidth >> 8), static_cast<std::uint8_t>(aWidth),
+		3, 1, aLumaSampling, 0, 2, 0x11, 1, 3, 0x11, 1});
+
+	if (aRestartInterval) {
+		jpeg.insert(jpeg.end(), {0xff, 0xdd, 0x00, 0x04, static_cast<std::uint8_t>(aRestartInterval >> 8),
+			static_cast<std::uint8_t>(aRestartInterval)});
+	}
+
+	jpeg.insert(jpeg.end(), {0xff, 0xc4, 0x00, 0x03, 0x00});  // DHT, contents do not matter
+	jpeg.insert(jpeg.end(), {0xff, 0xda, 0x00, 12, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0});
+	const auto scan = makeFrame(aScanSize);
+	jpeg.insert(jpeg.end(), scan.begin(), scan.end());
+	jpeg.insert(jpeg.end(), {0xff, 0xd9, 0x00, 0x00, 0x00});  // EOI, and padding the driver may leave
+
+	return jpeg;
+}
+
+OHDEBUG_TEST("Camera streamer, RTP/JPEG, JPEG parsing")
+{
+	const auto jpeg = makeJpeg(800, 600, 0x21, 0, 5000);
+	Proto::JpegScan scan{};
+	assert(scan.parse(jpeg.data(), jpeg.size()));
+	assert(scan.width == 800 && scan.height == 600 && scan.type == Proto::JpegScan::Type422);
+	assert(scan.restartInterval == 0);
+	assert(scan.quantTables[0][1] == 1 && scan.quantTables[1][1] == 101);
+	assert(scan.scanSize == 5000 && scan.scan + scan.scanSize + 5 == jpeg.data() + jpeg.size());
+	assert(std::equal(scan.scan, scan.scan + scan.scanSize, makeFrame(5000).begin()));
+
+	const auto jpeg420 = makeJpeg(1600, 1200, 0x22, 4, 100);
+	assert(scan.parse(jpeg420.data(), jpeg420.size()));
+	assert(scan.type == Proto::JpegScan::Type420 && scan.restartInterval == 4);
+
+	auto unsupported = makeJpeg(800, 600, 0x11, 0, 100);  // 4:4:4
+	assert(!scan.parse(unsupported.data(), unsupported.size()));
+	unsupported = makeJpeg(2048, 600, 0x21, 0, 100);  // Too wide
+	assert(!scan.parse(unsupported.data(), unsupported.size()));
+	unsupported = makeJpeg(800, 600, 0x21, 0, 100);
+	unsupported[1] = 0;  // No SOI
+	assert(!scan.parse(unsupported.data(), unsupported.size()));
+	unsupported = makeJpeg(800, 600, 0x21, 0, 100);
+	assert(!scan.parse(unsupported.data(), 150));  // Truncated before SOS
+}
+
+OHDEBUG_TEST("Camera streamer, RTP/JPEG, packets")
+{
+	static constexpr std::size_t kDatagramSize = 1472;
+	static constexpr std::uint32_t kSsrc = 0x12345678;
+	static constexpr std::int64_t kCaptureTimeUs = 1000000;
+
+	for (std::uint16_t restartInterval : {std::uint16_t{0}, std::uint16_t{8}}) {
+		Proto::RtpJpegPacketizer packetizer{kDatagramSize, kSsrc};
+		const auto jpeg = makeJpeg(640, 480, 0x21, restartInterval, 10000);
+		std::vector<std::uint8_t> scan{};
+		std::size_t packets = 0;
+		std::uint16_t sequence = 0;
+		bool marker = false;
+		const bool split = packetizer.forEachPacket(kCaptureTimeUs, jpeg.data(), jpeg.size(),
+			[&](const std::uint8_t *aHeader, std::size_t aHeaderSize, const std::uint8_t *aPayload,
+				std::size_t aPayloadSize)
+			{
+				assert(aHeaderSize + aPayloadSize <= kDatagramSize);
+				// RTP: V = 2, PT = 26, timestamp 90 kHz
+				assert(aHeader[0] == 0x80 && (aHeader[1] & 0x7f) == 26);
+				assert(!marker);
+				marker = aHeader[1] & 0x80;
+				const std::uint16_t currentSequence = static_cast<std::uint16_t>((aHeader[2] << 8) | aHeader[3]);
+				assert(packets == 0 || currentSequence == static_cast<std::uint16_t>(sequence + 1));
+				sequence = currentSequence;
+				assert(aHeader[4] == 0x00 && aHeader[5] == 0x01 && aHeader[6] == 0x5f && aHeader[7] == 0x90);  // 90000
+				assert(aHeader[8] == 0x12 && aHeader[11] == 0x78);
+				// RTP/JPEG main header
+				const std::uint8_t *jpegHeader = aHeader + 12;
+				const std::size_t offset = (jpegHeader[1] << 16) | (jpegHeader[2] << 8) | jpegHeader[3];
+				assert(offset == scan.size());
+				assert(jpegHeader[4] == (restartInterval ? 64 : 0) && jpegHeader[5] == 255);
+				assert(jpegHeader[6] == 640 / 8 && jpegHeader[7] == 480 / 8);
+				std::size_t expectedHeaderSize = 12 + 8;
+
+				if (restartInterval) {
+					assert(jpegHeader[8] == 0 && jpegHeader[9] == restartInterval && jpegHeader[10] == 0xff
+						&& jpegHeader[11] == 0xff);
+					expectedHeaderSize += 4;
+				}
+
+				if (offset == 0) {  // Quantization tables
+					const std::uint8_t *quant = aHeader + expectedHeaderSize;
+					assert(quant[0] == 0 && quant[1] == 0 && quant[2] == 0 && quant[3] == 128);
+					assert(quant[4 + 1] == 1 && quant[4 + 64 + 1] == 101);
+					expectedHeaderSize += 4 + 128;
+				}
+
+				assert(aHeaderSize == expectedHeaderSize);
+				assert(aPayload >= jpeg.data() && aPayload + aPayloadSize <= jpeg.data() + jpeg.size());  // No copies
+				scan.insert(scan.end(), aPayload, aPayload + aPayloadSize);
+				++packets;
+			});
+		assert(split && marker);
+		assert(scan == makeFrame(10000));
+		assert(packets == packetizer.packets() && packets == 7);
+		OHDEBUG("Trace", "RTP/JPEG packets", packets, "octets", packetizer.octets());
+	}
+}
+
+OHDEBUG_TEST("Camera streamer, RTCP, sender report")
+{
+	Proto::RtpJpegPacketizer packetizer{1472, 0x01020304};
+	const auto jpeg = makeJpeg(640, 480, 0x21, 0, 100);
+	assert(packetizer.forEachPacket(0, jpeg.data(), jpeg.size(),
+		[](const std::uint8_t *, std::size_t, const std::uint8_t *, std::size_t) {}));
+	assert(Proto::RtpJpegPacketizer::toNtpTimestamp(0) == 2208988800ULL << 32);
+	assert(Proto::RtpJpegPacketizer::toNtpTimestamp(500000) == ((2208988800ULL << 32) | 0x80000000ULL));
+	assert(Proto::RtpJpegPacketizer::toRtpTimestamp(2000000) == 180000);
+
+	std::array<std::uint8_t, Proto::RtpJpegPacketizer::kSenderReportMaxSize> report{};
+	const std::size_t size = packetizer.packSenderReport(report.data(), 0x1122334455667788ULL, 0xaabbccdd);
+	assert(size == 48 && size % 4 == 0);
+	// SR: V = 2, RC = 0, PT = 200, length = 6 words - 1
+	const std::array<std::uint8_t, 28> expected{{0x80, 200, 0x00, 0x06, 0x01, 0x02, 0x03, 0x04,
+		0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0xaa, 0xbb, 0xcc, 0xdd,
+		0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, static_cast<std::uint8_t>(8 + 4 + 128 + 100)}};
+	assert(std::equal(expected.begin(), expected.end(), report.begin()));
+	// SDES: V = 2, SC = 1, PT = 202, CNAME
+	assert(report[28] == 0x81 && report[29] == 202 && report[31] == (size - 28) / 4 - 1 && report[36] == 1);
+}
+
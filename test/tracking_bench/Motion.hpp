@@ -0,0 +1 @@
+../../components/tracking/priv_include/Motion.hpp
\ No newline at end of file
@@ -0,0 +1 @@
+../../components/tracking/priv_include/Target.cpp
\ No newline at end of file
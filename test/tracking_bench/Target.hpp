@@ -0,0 +1 @@
+../../components/tracking/priv_include/Target.hpp
\ No newline at end of file
@@ -0,0 +1,237 @@
+//
+// main.cpp
+//
+
+// Replays a recorded grayscale sequence w/ ground truth ROIs through the very per-target steps the firmware makes, see
+// `Trk::Target`: the target is initialized w/ the ground truth ROI of the first frame, then, on every frame, it is
+// preprocessed (the update is skipped for a steady target, the tracker is re-centered, or the lost target is looked
+// for, otherwise the working area is cropped, and the frame buffer is free to be reused), the tracker gets updated,
+// and the ROI is concluded. Reports the step throughput, latency percentiles, and IoU w/ the ground truth, and the
+// events (lost, re-acquired, re-centered). Optionally, dumps the per-frame trace (latency, PSR, IoU) as CSV.
+//
+// Usage:
+// tracking_bench [--raw <frames.raw> <width> <height> --gt <roi.txt>] [--trace <trace.csv>]
+//
+// - `frames.raw` - concatenated 8-bit grayscale frames, see `Cam::Replay::RawGrayscaleSource`
+// - `roi.txt` - one "x y width height" line per frame
+// - w/o `--raw`, a synthetic sequence is used, see `Cam::Replay::SyntheticSource`
+
+#include <bench/Metrics.hpp>
+#include <cam/replay/Source.hpp>
+#include <Target.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int kSyntheticWidth = 320;
+constexpr int kSyntheticHeight = 240;
+constexpr std::size_t kSyntheticFrames = 200;
+constexpr int kSyntheticSquare = 32;
+constexpr unsigned kStrideMax = 2;  ///< Same as the firmware's, see `CONFIG_TRACKING_UPDATE_STRIDE_MAX`
+constexpr int kSweepFrames = 8;  ///< Same as the firmware's, see `CONFIG_TRACKING_RECOVERY_SWEEP_FRAMES`
+
+struct Args {
+	const char *rawFile = nullptr;
+	int width = 0;
+	int height = 0;
+	const char *gtFile = nullptr;
+	const char *traceFile = nullptr;
+};
+
+bool argsParse(int aArgc, char **aArgv, Args &aArgs)
+{
+	for (int i = 1; i < aArgc; ++i) {
+		if (std::strcmp(aArgv[i], "--raw") == 0 && i + 3 < aArgc) {
+			aArgs.rawFile = aArgv[++i];
+			aArgs.width = std::atoi(aArgv[++i]);
+			aArgs.height = std::atoi(aArgv[++i]);
+		} else if (std::strcmp(aArgv[i], "--gt") == 0 && i + 1 < aArgc) {
+			aArgs.gtFile = aArgv[++i];
+		} else if (std::strcmp(aArgv[i], "--trace") == 0 && i + 1 < aArgc) {
+			aArgs.traceFile = aArgv[++i];
+		} else {
+			return false;
+		}
+	}
+
+	return aArgs.rawFile == nullptr || (aArgs.gtFile != nullptr && aArgs.width > 0 && aArgs.height > 0);
+}
+
+bool groundTruthRead(const char *aFilename, std::vector<Trk::Bench::Rect> &aGroundTruth)
+{
+	std::FILE *file = std::fopen(aFilename, "r");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	Trk::Bench::Rect rect{};
+
+	while (std::fscanf(file, "%d %d %d %d", &rect.x, &rect.y, &rect.width, &rect.height) == 4) {
+		aGroundTruth.push_back(rect);
+	}
+
+	std::fclose(file);
+
+	return !aGroundTruth.empty();
+}
+
+/// \brief The ROI has to fit the frame, see `Trk::Tracking::targetInit`
+bool roiFits(const Trk::Bench::Rect &aRect, int aWidth, int aHeight)
+{
+	return aRect.x > 0 && aRect.y > 0 && aRect.width > 0 && aRect.height > 0 && aRect.x + aRect.width < aWidth
+		&& aRect.y + aRect.height < aHeight;
+}
+
+std::int64_t nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+int main(int aArgc, char **aArgv)
+{
+	Args args{};
+
+	if (!argsParse(aArgc, aArgv, args)) {
+		std::fprintf(stderr, "Usage: %s [--raw <frames.raw> <width> <height> --gt <roi.txt>] [--trace <trace.csv>]\n",
+			aArgv[0]);
+
+		return 1;
+	}
+
+	std::unique_ptr<Cam::Replay::Source> source{};
+	std::vector<Trk::Bench::Rect> groundTruth{};
+
+	if (args.rawFile != nullptr) {
+		auto raw = new Cam::Replay::RawGrayscaleSource{args.width, args.height};
+		source.reset(raw);
+
+		if (!raw->open(args.rawFile) || !groundTruthRead(args.gtFile, groundTruth)) {
+			std::fprintf(stderr, "Failed to open the sequence\n");
+
+			return 1;
+		}
+	} else {
+		auto synthetic = new Cam::Replay::SyntheticSource{kSyntheticWidth, kSyntheticHeight, kSyntheticFrames,
+			kSyntheticSquare};
+		source.reset(synthetic);
+
+		for (std::size_t i = 0; i < kSyntheticFrames; ++i) {
+			Trk::Bench::Rect rect{0, 0, kSyntheticSquare, kSyntheticSquare};
+			synthetic->squarePosition(i, rect.x, rect.y);
+			groundTruth.push_back(rect);
+		}
+	}
+
+	std::vector<std::uint8_t> frame(source->maxFrameSize());
+	Cam::Replay::Source::FrameInfo frameInfo{};
+	Trk::Target target{};
+	const Trk::Target::Params params{kStrideMax, kSweepFrames, &nowUs};
+	Trk::Bench::Report report{};
+	std::size_t nUpdates = 0;
+	std::size_t nLost = 0;
+	std::size_t nReacquired = 0;
+	std::size_t nRecentred = 0;
+	std::size_t nFrames = 0;
+	const auto startTime = std::chrono::steady_clock::now();
+
+	for (; nFrames < groundTruth.size() && source->read(frame.data(), frame.size(), frameInfo); ++nFrames) {
+		Mosse::Tp::Image image{frame.data(), frameInfo.height, frameInfo.width};
+		const Trk::Bench::Rect &truth = groundTruth[nFrames];
+
+		if (nFrames == 0) {
+			if (!roiFits(truth, frameInfo.width, frameInfo.height)) {
+				std::fprintf(stderr, "The initial ROI does not fit the frame\n");
+
+				return 1;
+			}
+
+			target.init(image, Mosse::Tp::Roi{{truth.y, truth.x}, {truth.height, truth.width}});
+
+			continue;
+		}
+
+		const auto stepStart = std::chrono::steady_clock::now();
+
+		switch (target.preprocess(image, params)) {  // The frame buffer is free to be reused after this
+			case Trk::Target::Event::Lost:
+				++nLost;
+
+				break;
+
+			case Trk::Target::Event::Reacquired:
+				++nReacquired;
+
+				break;
+
+			case Trk::Target::Event::Recentred:
+				++nRecentred;
+
+				break;
+
+			default:
+				break;
+		}
+
+		if (target.step == Trk::Target::Step::Updated) {
+			target.update();
+			++nUpdates;
+		}
+
+		const auto roi = target.conclude();
+		const auto latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - stepStart).count();
+		const Trk::Bench::Rect rect{static_cast<int>(roi.origin(1)), static_cast<int>(roi.origin(0)),
+			static_cast<int>(roi.size(1)), static_cast<int>(roi.size(0))};
+		report.onUpdate({static_cast<std::uint32_t>(latencyUs), target.quality.psr, Trk::Bench::iou(rect, truth),
+			target.quality.isOk()});
+	}
+
+	const auto totalUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+		- startTime).count();
+
+	if (report.updates() == 0) {
+		std::fprintf(stderr, "Too short a sequence\n");
+
+		return 1;
+	}
+
+	std::printf("frames %zu, steps %zu, tracker updates %zu\n", nFrames, report.updates(), nUpdates);
+	std::printf("fps: tracker %.1f, end-to-end %.1f\n", report.fps(), Trk::Bench::fps(nFrames, totalUs));
+	std::printf("step latency, us: p50 %u, p90 %u, p99 %u, max %u\n", report.latencyPercentileUs(50.0f),
+		report.latencyPercentileUs(90.0f), report.latencyPercentileUs(99.0f), report.latencyPercentileUs(100.0f));
+	std::printf("IoU: mean %.3f, success rate (IoU > 0.5) %.3f\n", report.iouMean(), report.successRate());
+	std::printf("quality latch: %s, lost %zu, re-acquired %zu, re-centered %zu\n",
+		target.quality.isOk() ? "ok" : "lost", nLost, nReacquired, nRecentred);
+
+	if (args.traceFile != nullptr) {
+		std::FILE *trace = std::fopen(args.traceFile, "w");
+
+		if (trace == nullptr) {
+			std::fprintf(stderr, "Failed to open the trace file\n");
+
+			return 1;
+		}
+
+		std::fprintf(trace, "update,latency_us,psr,iou,ok\n");
+
+		for (std::size_t i = 0; i < report.trace().size(); ++i) {
+			const auto &sample = report.trace()[i];
+			std::fprintf(trace, "%zu,%u,%.4f,%.4f,%d\n", i, sample.latencyUs, sample.psr, sample.iou,
+				static_cast<int>(sample.ok));
+		}
+
+		std::fclose(trace);
+	}
+
+	return 0;
+}
@@ -0,0 +1 @@
+../../components/tracking/priv_include/Recovery.hpp
\ No newline at end of file
@@ -0,0 +1,138 @@
+#define OHDEBUG_PORT_ENABLE 1
+#define OHDEBUG_TAGS_ENABLE "Trace"
+
+#include <OhDebug.hpp>
+#include <bench/Metrics.hpp>
+#include <Motion.hpp>
+#include <Recovery.hpp>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+static bool isNear(float aLhs, float aRhs)
+{
+	return std::fabs(aLhs - aRhs) < 1e-4f;
+}
+
+OHDEBUG_TEST("Tracking, bench, IoU")
+{
+	using Trk::Bench::Rect;
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 10, 10}, Rect{0, 0, 10, 10}), 1.0f));
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 10, 10}, Rect{10, 0, 10, 10}), 0.0f));  // Touching
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 10, 10}, Rect{20, 20, 5, 5}), 0.0f));
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 10, 10}, Rect{5, 0, 10, 10}), 50.0f / 150.0f));
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 10, 10}, Rect{2, 2, 4, 4}), 16.0f / 100.0f));  // Nested
+	assert(isNear(Trk::Bench::iou(Rect{0, 0, 0, 0}, Rect{0, 0, 0, 0}), 0.0f));
+}
+
+OHDEBUG_TEST("Tracking, bench, fps over timestamps")
+{
+	// 10 timestamps 100 ms apart make 9 frame intervals
+	assert(isNear(Trk::Bench::fps(10, 900000), 10.0f));
+	assert(isNear(Trk::Bench::fps(1, 100000), 0.0f));
+	assert(isNear(Trk::Bench::fps(2, 0), 0.0f));
+}
+
+OHDEBUG_TEST("Tracking, bench, report")
+{
+	Trk::Bench::Report report{};
+	assert(report.latencyPercentileUs(50.0f) == 0);
+	assert(isNear(report.fps(), 0.0f));
+
+	for (std::uint32_t i = 1; i <= 100; ++i) {
+		report.onUpdate({i * 100, 1.0f, i <= 75 ? 1.0f : 0.0f, true});
+	}
+
+	assert(report.updates() == 100);
+	assert(report.latencyPercentileUs(50.0f) == 5000);
+	assert(report.latencyPercentileUs(95.0f) == 9500);
+	assert(report.latencyPercentileUs(100.0f) == 10000);
+	assert(report.latencyPercentileUs(0.0f) == 100);
+	assert(isNear(report.fps(), 100.0f * 1000000.0f / 505000.0f));
+	assert(isNear(report.iouMean(), 0.75f));
+	assert(isNear(report.successRate(), 0.75f));
+}
+
+OHDEBUG_TEST("Tracking, motion, constant velocity")
+{
+	Trk::Motion motion{};
+	motion.reset({10.0f, 20.0f});
+	assert(isNear(motion.speedAbs(), 0.0f));
+
+	// 3 px / frame along x, measured on every frame, then once in 2 frames
+	for (int i = 1; i <= 40; ++i) {
+		motion.update({10.0f + 3.0f * i, 20.0f});
+	}
+
+	for (int i = 42; i <= 80; i += 2) {
+		motion.update({10.0f + 3.0f * i, 20.0f}, 2);
+	}
+
+	assert(std::fabs(motion.velocity().x - 3.0f) < 0.01f);
+	assert(std::fabs(motion.velocity().y) < 0.01f);
+	assert(std::fabs(motion.predict(5).x - (10.0f + 3.0f * 85)) < 0.1f);
+	assert(std::fabs(motion.predict(5).y - 20.0f) < 0.1f);
+
+	motion.reset({0.0f, 0.0f});
+	assert(isNear(motion.predict(10).x, 0.0f));
+}
+
+/// \brief Textured square over a gradient background
+static void drawTarget(std::vector<std::uint8_t> &aFrame, int aCols, int aRow, int aCol, int aSide)
+{
+	for (std::size_t i = 0; i < aFrame.size(); ++i) {
+		aFrame[i] = static_cast<std::uint8_t>((i % aCols + i / aCols) / 8);
+	}
+
+	for (int r = 0; r < aSide; ++r) {
+		for (int c = 0; c < aSide; ++c) {
+			aFrame[(aRow + r) * aCols + aCol + c] = static_cast<std::uint8_t>(((r / 4 + c / 4) % 2) ? 230 : 40);
+		}
+	}
+}
+
+OHDEBUG_TEST("Tracking, recovery, coarse search spread over frames")
+{
+	constexpr int kRows = 120;
+	constexpr int kCols = 160;
+	constexpr int kSide = 32;
+	std::vector<std::uint8_t> frame(kRows * kCols);
+	drawTarget(frame, kCols, 20, 24, kSide);
+	Trk::Recovery recovery{};
+	assert(!recovery.hasTemplate());
+	assert(!recovery.capture(frame.data(), kRows, kCols, 100, 140, kSide, kSide));  // Does not fit
+	assert(recovery.capture(frame.data(), kRows, kCols, 20, 24, kSide, kSide));
+
+	// The target has moved
+	drawTarget(frame, kCols, 64, 100, kSide);
+	recovery.start();
+	constexpr int kSweepFrames = 5;
+	int steps = 1;
+
+	while (!recovery.step(frame.data(), kRows, kCols, kSweepFrames)) {
+		++steps;
+	}
+
+	OHDEBUG("Trace", "recovery, steps", steps, "row", recovery.match().row, "col", recovery.match().col, "score",
+		recovery.match().score);
+	assert(steps > 1 && steps <= kSweepFrames);
+	assert(recovery.found());
+	assert(recovery.match().row == 64 && recovery.match().col == 100);
+
+	// The target is gone
+	drawTarget(frame, kCols, 0, 0, 0);
+	recovery.start();
+
+	while (!recovery.step(frame.data(), kRows, kCols, kSweepFrames)) {
+	}
+
+	assert(!recovery.found());
+}
+
+int main(void)
+{
+	OHDEBUG("Trace", "tracking_test");
+	OHDEBUG_RUN_TESTS();
+
+	return 0;
+}
@@ -3,11 +3,49 @@
 #include <OhDebug.hpp>
 
 #include <utility/al/Crc32.hpp>
+#include <utility/al/Histogram.hpp>
+#include <utility/al/TokenBucket.hpp>
+#include <utility/cont/ByteRing.hpp>
 #include <utility/cont/DelayedInitialization.hpp>
 #include <utility/cont/EndiannessAwareRepresentation.hpp>
+#include <utility/cont/Mailbox.hpp>
+#include <utility/cont/Pool.hpp>
+#include <utility/cont/SpmcRing.hpp>
+#include <utility/IntrusivePtr.hpp>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+
+/// \brief Heap allocation counter, so allocation-free paths can be verified
+static std::atomic<std::size_t> sNewCount{0};
+
+void *operator new(std::size_t aSize)
+{
+	sNewCount.fetch_add(1);
+	void *ptr = std::malloc(aSize == 0 ? 1 : aSize);
+
+	if (ptr == nullptr) {
+		throw std::bad_alloc{};
+	}
+
+	return ptr;
+}
+
+void operator delete(void *aPtr) noexcept
+{
+	std::free(aPtr);
+}
+
+void operator delete(void *aPtr, std::size_t) noexcept
+{
+	std::free(aPtr);
+}
 
 template <class T>
 constexpr const uint8_t* u8PointerCast(T aArg)
@@ -92,6 +130,450 @@ OHDEBUG_TEST("Utility, DelayedInitialization")
 	assert(complicatedConstructionEntityDelayedInitialization.getInstance()->value == 2);
 }
 
+OHDEBUG_TEST("Utility, Pool, slot acquisition and release")
+{
+	struct Item {
+		int value;
+	};
+	Ut::Cont::Pool<Item, 2> pool{};
+	Item *first = pool.tryEmplace(1);
+	Item *second = pool.tryEmplace(2);
+	assert(first != nullptr && second != nullptr);
+	assert(pool.tryEmplace(3) == nullptr);
+	assert(pool.countUsed() == 2);
+	pool.destroy(first);
+	assert(!pool.isUsed(0));
+	assert(pool.tryEmplaceAt(1, 4) == nullptr);
+	Item *third = pool.tryEmplaceAt(0, 5);
+	assert(third == first && third->value == 5);
+	pool.destroy(second);
+	pool.destroy(third);
+	assert(pool.countUsed() == 0);
+}
+
+/// \brief Mimics `Cam::Frame` sitting in a camera's frame handle pool
+struct BenchFrame : Ut::RefCounted {
+	using Pool = Ut::Cont::Pool<BenchFrame, 2>;
+	static Pool pool;
+	std::uint8_t *buf;
+	std::size_t len;
+
+	BenchFrame(std::uint8_t *aBuf, std::size_t aLen) : buf{aBuf}, len{aLen}
+	{
+	}
+
+protected:
+	void onRefCountZero() override
+	{
+		pool.destroy(this);
+	}
+};
+
+BenchFrame::Pool BenchFrame::pool{};
+
+OHDEBUG_TEST("Utility, IntrusivePtr, frame handles, allocations per frame")
+{
+	constexpr std::size_t kFrames = 1000;
+	constexpr std::size_t kSubscribers = 3;
+	static std::uint8_t frameBuffer[64] = {0};
+
+	// Baseline: what `std::shared_ptr`-based frame handles used to cost
+	struct PlainFrame {
+		std::uint8_t *buf;
+		std::size_t len;
+	};
+	std::size_t newCountBefore = sNewCount.load();
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		std::shared_ptr<PlainFrame> frame{new PlainFrame{frameBuffer, sizeof(frameBuffer)}};
+		std::array<std::shared_ptr<PlainFrame>, kSubscribers> subscribers;
+
+		for (auto &subscriber : subscribers) {
+			subscriber = frame;
+		}
+	}
+
+	const std::size_t sharedPtrAllocations = sNewCount.load() - newCountBefore;
+
+	// Pooled intrusive handles
+	newCountBefore = sNewCount.load();
+
+	for (std::size_t i = 0; i < kFrames; ++i) {
+		Ut::IntrusivePtr<BenchFrame> frame{BenchFrame::pool.tryEmplace(frameBuffer, sizeof(frameBuffer))};
+		assert(static_cast<bool>(frame));
+		std::array<Ut::IntrusivePtr<BenchFrame>, kSubscribers> subscribers;
+
+		for (auto &subscriber : subscribers) {
+			subscriber = frame;
+		}
+
+		assert(frame.useCount() == kSubscribers + 1);
+	}
+
+	const std::size_t pooledAllocations = sNewCount.load() - newCountBefore;
+	OHDEBUG("Trace", "allocations per frame, shared_ptr:", static_cast<double>(sharedPtrAllocations) / kFrames,
+		"pooled:", static_cast<double>(pooledAllocations) / kFrames);
+	assert(pooledAllocations == 0);
+	assert(BenchFrame::pool.countUsed() == 0);
+}
+
+/// \brief Synthetic camera frame. Frames are pooled the same way `Ov2640` pools its handles
+struct SyntheticFrame : Ut::RefCounted {
+	static constexpr std::size_t kRingDepth = 2;
+	static constexpr std::size_t kConsumers = 2;
+	using Pool = Ut::Cont::Pool<SyntheticFrame, kRingDepth + kConsumers + 1>;
+	static Pool pool;
+	std::uint32_t sequence;
+
+	SyntheticFrame(std::uint32_t aSequence) : sequence{aSequence}
+	{
+	}
+
+protected:
+	void onRefCountZero() override
+	{
+		pool.destroy(this);
+	}
+};
+
+SyntheticFrame::Pool SyntheticFrame::pool{};
+
+OHDEBUG_TEST("Utility, Histogram, log2 buckets, percentiles")
+{
+	using Histogram = Ut::Al::Histogram<8>;
+	static_assert(Histogram::lowerBound(0) == 0 && Histogram::upperBound(0) == 2, "");
+	static_assert(Histogram::lowerBound(3) == 8 && Histogram::upperBound(3) == 16, "");
+	assert(Histogram::bucketOf(0) == 0);
+	assert(Histogram::bucketOf(1) == 0);
+	assert(Histogram::bucketOf(2) == 1);
+	assert(Histogram::bucketOf(15) == 3);
+	assert(Histogram::bucketOf(16) == 4);
+	assert(Histogram::bucketOf(1000000) == 7);  // The last bucket accumulates everything above
+
+	Histogram histogram{};
+	assert(histogram.count() == 0 && histogram.percentile(50) == 0 && histogram.mean() == 0);
+
+	for (unsigned i = 0; i < 90; ++i) {
+		histogram.record(10);  // Bucket 3
+	}
+
+	for (unsigned i = 0; i < 9; ++i) {
+		histogram.record(100);  // Bucket 6
+	}
+
+	histogram.record(5000);  // Bucket 7
+	assert(histogram.count() == 100);
+	assert(histogram.bucket(3) == 90 && histogram.bucket(6) == 9 && histogram.bucket(7) == 1);
+	assert(histogram.max() == 5000);
+	assert(histogram.mean() == (900 + 900 + 5000) / 100);
+	assert(histogram.percentile(0) == 16);
+	assert(histogram.percentile(50) == 16);
+	assert(histogram.percentile(90) == 16);
+	assert(histogram.percentile(99) == 128);
+	assert(histogram.percentile(100) == 5000);
+	histogram.reset();
+	assert(histogram.count() == 0 && histogram.max() == 0 && histogram.bucket(3) == 0);
+}
+
+OHDEBUG_TEST("Utility, TokenBucket, rate, burst, debt")
+{
+	Ut::Al::TokenBucket unlimited{};
+	unlimited.update(0);
+	unlimited.consume(1000000);
+	assert(unlimited.isAvailable());
+
+	Ut::Al::TokenBucket bucket{1000, 500};  // 1000 tokens/s, 500 tokens burst
+	bucket.update(0);
+	assert(bucket.tokens() == 500);
+	bucket.consume(2000);  // Larger than the bucket, goes into debt
+	assert(!bucket.isAvailable() && bucket.tokens() == -1500);
+	bucket.update(1000000);
+	assert(!bucket.isAvailable() && bucket.tokens() == -500);
+	bucket.update(1500001);
+	assert(bucket.isAvailable());
+
+	for (std::int64_t timeUs = 1500001; timeUs < 10000000; timeUs += 333) {  // Fractions are accumulated
+		bucket.update(timeUs);
+	}
+
+	assert(bucket.tokens() == 500);  // Capped
+
+	// The average rate holds over a long run
+	Ut::Al::TokenBucket paced{1000, 100};
+	std::uint32_t consumed = 0;
+
+	for (std::int64_t timeUs = 0; timeUs <= 10000000; timeUs += 1000) {
+		paced.update(timeUs);
+
+		if (paced.isAvailable()) {
+			paced.consume(250);
+			consumed += 250;
+		}
+	}
+
+	OHDEBUG("Trace", "TokenBucket, consumed over 10 s at 1000 tokens/s", consumed);
+	assert(consumed >= 10000 && consumed <= 10000 + 100 + 250);
+}
+
+OHDEBUG_TEST("Utility, ByteRing, variable-size records, drop-oldest")
+{
+	std::array<std::uint8_t, 100> arena{};
+	Ut::Cont::ByteRing<int, 4> ring{};
+	ring.assign(arena.data(), arena.size());
+	std::array<std::uint8_t, 100> record{};
+
+	for (std::size_t i = 0; i < record.size(); ++i) {
+		record[i] = static_cast<std::uint8_t>(i);
+	}
+
+	assert(!ring.fits(101) && ring.fits(100));
+	assert(!ring.push_back(record.data(), 101, 0));  // Larger than the arena
+	assert(ring.push_back(record.data(), 40, 1));
+	assert(ring.fits(40));
+	assert(ring.push_back(record.data() + 1, 40, 2));
+	assert(ring.usedBytes() == 80 && ring.evicted() == 0);
+
+	// Does not fit in the tail, placed at the beginning over the oldest one
+	assert(ring.fits(20) && !ring.fits(30));
+	assert(ring.push_back(record.data() + 2, 30, 3));
+	assert(ring.size() == 2 && ring.evicted() == 1);
+	assert(ring.front().meta == 2 && ring.front().offset == 40);
+	assert(ring.back().meta == 3 && ring.back().offset == 0);
+	assert(std::equal(record.begin() + 2, record.begin() + 32, ring.data(ring.back())));
+
+	// Fits between the newest, and the oldest records
+	assert(ring.fits(10) && !ring.fits(11));
+	assert(ring.push_back(record.data(), 10, 4));
+	assert(ring.size() == 3 && ring.evicted() == 1 && ring.at(2).offset == 30);
+
+	// Overlaps the oldest one
+	assert(ring.push_back(record.data(), 10, 5));
+	assert(ring.size() == 3 && ring.evicted() == 2 && ring.front().meta == 3);
+
+	// The table is full
+	assert(ring.push_back(record.data(), 1, 6));
+	assert(!ring.fits(1));
+	assert(ring.push_back(record.data(), 1, 7));
+	assert(ring.size() == 4 && ring.evicted() == 3 && ring.front().meta == 4);
+
+	while (!ring.empty()) {
+		ring.pop_front();
+	}
+
+	assert(ring.usedBytes() == 0 && ring.evicted() == 3);
+}
+
+OHDEBUG_TEST("Utility, SpmcRing, drop-oldest, per-consumer cursors")
+{
+	Ut::Cont::SpmcRing<int, 2, 2> ring{};
+	const int first = ring.registerConsumer();
+	const int second = ring.registerConsumer();
+	assert(first != decltype(ring)::kNoConsumer && second != decltype(ring)::kNoConsumer);
+	assert(ring.registerConsumer() == decltype(ring)::kNoConsumer);
+	int value = 0;
+	assert(!ring.tryPop(first, value));
+
+	for (int i = 1; i <= 5; ++i) {
+		ring.push(i);
+
+		if (i == 1) {
+			assert(ring.tryPop(first, value) && value == 1);
+		}
+	}
+
+	// The first consumer has read 1, and has been lapped afterwards: 2 and 3 are lost
+	assert(ring.stats(first).lag == 2);
+	assert(ring.tryPop(first, value) && value == 4);
+	assert(ring.tryPop(first, value) && value == 5);
+	assert(!ring.tryPop(first, value));
+	assert(ring.stats(first).dropped == 2 && ring.stats(first).consumed == 3);
+	// The second one has not read anything, and it does not affect the first one
+	assert(ring.tryPop(second, value) && value == 4);
+	assert(ring.stats(second).dropped == 3);
+	ring.unregisterConsumer(second);
+	assert(ring.registerConsumer() == second);
+	assert(!ring.tryPop(second, value));
+}
+
+OHDEBUG_TEST("Utility, SpmcRing, an item is only kept until every consumer has read it")
+{
+	using Ring = Ut::Cont::SpmcRing<Ut::IntrusivePtr<SyntheticFrame>, 1, SyntheticFrame::kConsumers>;
+	Ring ring{};
+	Ut::IntrusivePtr<SyntheticFrame> frame{};
+
+	// Nobody to read it
+	assert(ring.tryPush(Ut::IntrusivePtr<SyntheticFrame>{SyntheticFrame::pool.tryEmplace(1u)}));
+	assert(SyntheticFrame::pool.countUsed() == 0);
+
+	const int first = ring.registerConsumer();
+	const int second = ring.registerConsumer();
+	assert(ring.tryPush(Ut::IntrusivePtr<SyntheticFrame>{SyntheticFrame::pool.tryEmplace(2u)}));
+	assert(ring.tryPop(first, frame) && frame->sequence == 2);
+	frame.reset();
+	assert(SyntheticFrame::pool.countUsed() == 1);  // The second one has not read it yet
+	assert(ring.tryPop(second, frame) && frame->sequence == 2);
+	frame.reset();
+	assert(SyntheticFrame::pool.countUsed() == 0);
+
+	// A consumer leaving releases what it has not read
+	assert(ring.tryPush(Ut::IntrusivePtr<SyntheticFrame>{SyntheticFrame::pool.tryEmplace(3u)}));
+	assert(ring.tryPop(first, frame));
+	frame.reset();
+	ring.unregisterConsumer(second);
+	assert(SyntheticFrame::pool.countUsed() == 0);
+	assert(!ring.tryPop(first, frame));
+	ring.unregisterConsumer(first);
+}
+
+OHDEBUG_TEST("Utility, SpmcRing, synthetic camera, slow consumer does not stall the producer")
+{
+	using Ring = Ut::Cont::SpmcRing<Ut::IntrusivePtr<SyntheticFrame>, SyntheticFrame::kRingDepth,
+		SyntheticFrame::kConsumers>;
+	constexpr std::uint32_t kFrames = 2000;
+	constexpr auto kFramePeriod = std::chrono::microseconds{100};
+	constexpr auto kSlowConsumerProcessing = std::chrono::milliseconds{1};
+	static Ring ring{};
+	std::atomic<bool> finished{false};
+	std::atomic<std::uint32_t> poolExhausted{0};
+
+	struct Consumer {
+		int id;
+		std::chrono::microseconds processing;
+		std::uint32_t lastSequence;
+		bool ordered;
+		std::uint32_t received;
+	};
+
+	std::array<Consumer, SyntheticFrame::kConsumers> consumers {{
+		{ring.registerConsumer(), std::chrono::microseconds{0}, 0, true, 0},
+		{ring.registerConsumer(), kSlowConsumerProcessing, 0, true, 0},
+	}};
+
+	auto consume = [&finished](Consumer &aConsumer)
+		{
+			Ut::IntrusivePtr<SyntheticFrame> frame{};
+
+			while (true) {
+				const bool producerFinished = finished.load();
+
+				if (ring.tryPop(aConsumer.id, frame)) {
+					aConsumer.ordered = aConsumer.ordered && frame->sequence > aConsumer.lastSequence;
+					aConsumer.lastSequence = frame->sequence;
+					++aConsumer.received;
+					std::this_thread::sleep_for(aConsumer.processing);
+					frame.reset();
+				} else if (producerFinished) {
+					break;
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		};
+
+	std::thread fastConsumerThread{consume, std::ref(consumers[0])};
+	std::thread slowConsumerThread{consume, std::ref(consumers[1])};
+	const auto timeStart = std::chrono::steady_clock::now();
+
+	for (std::uint32_t sequence = 1; sequence <= kFrames; ++sequence) {
+		auto *frame = SyntheticFrame::pool.tryEmplace(sequence);
+
+		if (frame == nullptr) {
+			poolExhausted.fetch_add(1);
+		} else {
+			ring.push(Ut::IntrusivePtr<SyntheticFrame>{frame});
+		}
+
+		std::this_thread::sleep_for(kFramePeriod);
+	}
+
+	const auto producerDuration = std::chrono::steady_clock::now() - timeStart;
+	finished.store(true);
+	fastConsumerThread.join();
+	slowConsumerThread.join();
+
+	for (auto &consumer : consumers) {
+		const auto stats = ring.stats(consumer.id);
+		OHDEBUG("Trace", "consumer", consumer.id, "consumed", stats.consumed, "dropped", stats.dropped, "lag",
+			stats.lag);
+		assert(consumer.ordered);
+		assert(stats.consumed == consumer.received);
+		assert(stats.consumed + stats.dropped == ring.pushed());
+		assert(stats.lag == 0);
+	}
+
+	OHDEBUG("Trace", "producer, frames pushed", ring.pushed(), "duration, ms",
+		std::chrono::duration_cast<std::chrono::milliseconds>(producerDuration).count());
+	assert(poolExhausted.load() == 0);  // Frame buffers are never held up by a consumer for longer than it processes them
+	assert(ring.stats(consumers[1].id).dropped > 0);  // The slow consumer could not keep up
+	assert(SyntheticFrame::pool.countUsed() <= SyntheticFrame::kRingDepth);
+}
+
+OHDEBUG_TEST("Utility, Mailbox, latest value, stale values dropped")
+{
+	Ut::Cont::Mailbox<std::shared_ptr<int>> mailbox{};
+	std::shared_ptr<int> value{};
+	assert(!mailbox.take(value));
+	auto first = std::make_shared<int>(1);
+	assert(mailbox.post(first));
+	assert(!mailbox.post(std::make_shared<int>(2)));  // The first one has not been taken
+	assert(first.use_count() == 1);  // The stale one is released by the mailbox
+	assert(mailbox.dropped() == 1 && mailbox.posted() == 2);
+	assert(mailbox.take(value) && *value == 2);
+	assert(!mailbox.pending() && !mailbox.take(value));
+	assert(value.use_count() == 1);
+	assert(mailbox.post(std::make_shared<int>(3)));
+	mailbox.clear();
+	assert(!mailbox.take(value) && mailbox.dropped() == 1);
+}
+
+OHDEBUG_TEST("Utility, Mailbox, slow consumer gets the freshest value, producer never waits")
+{
+	constexpr int kValues = 200000;
+	static Ut::Cont::Mailbox<int> mailbox{};
+	std::atomic<bool> finished{false};
+	int taken = 0;
+	bool ordered = true;
+
+	std::thread consumer{
+		[&]()
+		{
+			int last = 0;
+			int value = 0;
+
+			while (true) {
+				const bool producerFinished = finished.load();
+
+				if (mailbox.take(value)) {
+					ordered = ordered && value > last;
+					last = value;
+					++taken;
+				} else if (producerFinished) {
+					break;
+				}
+
+				if (taken % 16 == 0) {
+					std::this_thread::sleep_for(std::chrono::microseconds{10});
+				}
+			}
+
+			assert(last == kValues);
+		}};
+
+	for (int i = 1; i <= kValues; ++i) {
+		mailbox.post(i);
+
+		if (i % 64 == 0) {
+			std::this_thread::yield();
+		}
+	}
+
+	finished.store(true);
+	consumer.join();
+	OHDEBUG("Trace", "mailbox, taken", taken, "dropped", mailbox.dropped());
+	assert(ordered);
+	assert(static_cast<decltype(mailbox.posted())>(taken) + mailbox.dropped() == mailbox.posted());
+}
+
 int main(void)
 {
 	OHDEBUG("Trace", "utility_test");
@@ -0,0 +1,228 @@
+#!/usr/bin/python3
+
+# Reference receiver for the fragmented camera stream (see
+# components/camera_streamer/proto/Fragment.hpp):
+#
+# [ esp32, FrameSender ]  --- UDP fragments --->  [ Reassembler ]  --->  JPEG files / stats
+#
+# When FEC is enabled on the camera, a lost fragment is restored from the
+# parity fragment of its group (see components/camera_streamer/proto/Fec.hpp).
+#
+# The stream is sent to the address and port of the TCP control connection, so
+# the UDP socket is bound to the same local port the TCP connection uses.
+#
+# Usage:
+#   reassemble.py --host 192.168.4.1 [--port 8888] [--local-port 9000] [--out frames/]
+#   reassemble.py --selftest
+
+import argparse
+import os
+import random
+import socket
+import struct
+import sys
+import time
+
+HEADER = struct.Struct(">BBBBIHHIQ")
+MAGIC = 0xcf
+VERSION = 1
+FLAG_PARITY = 1
+
+
+def xor(a, b):
+	"""XOR of 2 byte strings, the shorter one is zero-padded"""
+	if len(a) < len(b):
+		a, b = b, a
+
+	return (int.from_bytes(a, "little") ^ int.from_bytes(b, "little")).to_bytes(len(a), "little")
+
+
+def pack_fragments(frame_id, timestamp_us, frame, datagram_size, fec_group_size=0):
+	"""Mirrors `Proto::Fragmenter`, used for self-testing"""
+	payload_size = datagram_size - HEADER.size
+	count = (len(frame) + payload_size - 1) // payload_size
+	parity = b""
+
+	for index in range(count):
+		payload = frame[index * payload_size:(index + 1) * payload_size]
+		yield HEADER.pack(MAGIC, VERSION, 0, fec_group_size, frame_id, index, count, len(frame), timestamp_us) + \
+			payload
+
+		if fec_group_size == 0:
+			continue
+
+		parity = xor(parity, payload)
+
+		if index % fec_group_size == fec_group_size - 1 or index == count - 1:
+			yield HEADER.pack(MAGIC, VERSION, FLAG_PARITY, fec_group_size, frame_id, index // fec_group_size, count,
+				len(frame), timestamp_us) + parity
+			parity = b""
+
+
+class Reassembler:
+	"""Collects fragments of frames. A frame is complete once all its fragments
+	have been received, or restored from FEC parity. Incomplete frames older
+	than `window` frames are considered lost."""
+
+	def __init__(self, window=4):
+		self.window = window
+		self.pending = dict()  # frame id -> (timestamp, size, count, {index: payload}, {group: parity})
+		self.last_complete = None
+		self.stats = dict(fragments=0, malformed=0, complete=0, lost=0, duplicates=0, restored=0)
+
+	def feed(self, datagram):
+		"""Returns (frame id, timestamp us, frame) once a frame is complete, None otherwise"""
+		if len(datagram) < HEADER.size:
+			self.stats["malformed"] += 1
+			return None
+
+		magic, version, flags, group_size, frame_id, index, count, size, timestamp = HEADER.unpack_from(datagram)
+		is_parity = bool(flags & FLAG_PARITY)
+
+		if magic != MAGIC or version != VERSION or (not is_parity and index >= count) or (is_parity and not group_size):
+			self.stats["malformed"] += 1
+			return None
+
+		self.stats["fragments"] += 1
+
+		if self.last_complete is not None and frame_id <= self.last_complete:
+			return None  # Late fragment of a frame which has already been handled
+
+		entry = self.pending.setdefault(frame_id, (timestamp, size, count, dict(), dict()))
+		fragments = entry[4] if is_parity else entry[3]
+
+		if index in fragments:
+			self.stats["duplicates"] += 1
+
+		fragments[index] = datagram[HEADER.size:]
+		fragments = entry[3]
+
+		if group_size and self._restore(fragments, entry[4], index if is_parity else index // group_size, group_size,
+				count, size):
+			self.stats["restored"] += 1
+
+		if len(fragments) < count:
+			self._expire(frame_id)
+			return None
+
+		frame = b"".join(fragments[i] for i in range(count))
+		del self.pending[frame_id]
+
+		if len(frame) != size:
+			self.stats["malformed"] += 1
+			return None
+
+		self.stats["complete"] += 1
+		self.last_complete = frame_id
+		self._expire(frame_id)
+
+		return frame_id, timestamp, frame
+
+	@staticmethod
+	def _restore(fragments, parities, group, group_size, count, size):
+		"""Restores the group's missing fragment, if there is exactly one"""
+		members = range(group * group_size, min((group + 1) * group_size, count))
+		missing = [i for i in members if i not in fragments]
+
+		if len(missing) != 1 or group not in parities:
+			return False
+
+		restored = parities[group]
+
+		for i in members:
+			if i != missing[0]:
+				restored = xor(restored, fragments[i])
+
+		# Parity is as long as the group's longest fragment, i.e. the full payload, unless it is the last fragment
+		payload_size = len(parities[group])
+		fragments[missing[0]] = restored[:min(payload_size, size - missing[0] * payload_size)]
+
+		return True
+
+	def _expire(self, newest):
+		for frame_id in [i for i in self.pending if i + self.window <= newest or
+				(self.last_complete is not None and i <= self.last_complete)]:
+			del self.pending[frame_id]
+			self.stats["lost"] += 1
+
+
+def selftest():
+	random.seed(0)
+	datagram_size = 1472
+	frames = [bytes(random.getrandbits(8) for _ in range(random.randint(1, 40000))) for _ in range(20)]
+
+	for fec_group_size in (0, 4):
+		reassembler = Reassembler()
+		received = []
+
+		for frame_id, frame in enumerate(frames, 1):
+			datagrams = list(pack_fragments(frame_id, frame_id * 1000, frame, datagram_size, fec_group_size))
+			random.shuffle(datagrams)
+
+			if frame_id % 5 == 0:
+				datagrams.pop()  # Lose a fragment
+
+			if frame_id % 7 == 0:
+				datagrams.append(datagrams[0])  # Duplicate a fragment
+
+			for datagram in datagrams:
+				result = reassembler.feed(datagram)
+
+				if result is not None:
+					received.append(result)
+
+		# W/ FEC, a single lost fragment is always restored
+		expected = [(i, i * 1000, f) for i, f in enumerate(frames, 1) if fec_group_size or i % 5 != 0]
+		assert received == expected, "reassembled frames mismatch"
+		assert reassembler.stats["complete"] == len(expected)
+		print("selftest ok, FEC group size", fec_group_size, reassembler.stats)
+
+
+def receive(args):
+	udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+	udp.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+	udp.bind(("", args.local_port))
+	tcp = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+	tcp.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	tcp.bind(("", args.local_port))
+	tcp.connect((args.host, args.port))
+
+	if args.out:
+		os.makedirs(args.out, exist_ok=True)
+
+	reassembler = Reassembler()
+	time_report = time.monotonic()
+
+	try:
+		while True:
+			result = reassembler.feed(udp.recv(65536))
+
+			if result is not None and args.out:
+				frame_id, timestamp, frame = result
+
+				with open(os.path.join(args.out, f"{frame_id:08d}_{timestamp}.jpg"), "wb") as f:
+					f.write(frame)
+
+			if time.monotonic() - time_report > 1.0:
+				time_report = time.monotonic()
+				print(reassembler.stats)
+	except KeyboardInterrupt:
+		print(reassembler.stats)
+	finally:
+		tcp.close()
+		udp.close()
+
+
+if __name__ == "__main__":
+	parser = argparse.ArgumentParser(description="Fragmented camera stream receiver")
+	parser.add_argument("--host", default="192.168.4.1")
+	parser.add_argument("--port", type=int, default=8888, help="Camera's TCP control port")
+	parser.add_argument("--local-port", type=int, default=9000, help="Local port, both TCP and UDP")
+	parser.add_argument("--out", default=None, help="Directory to save frames to")
+	parser.add_argument("--selftest", action="store_true")
+	args = parser.parse_args()
+
+	if args.selftest:
+		selftest()
+	else:
+		receive(args)